@@ -643,6 +643,7 @@ struct TimeStamp
 };
 
 struct GDAL_link;
+struct Raster_reader;
 
 /*============================== Prototypes ================================*/
 
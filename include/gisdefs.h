@@ -396,6 +396,16 @@ int G_abs_log_colors(struct Colors *, struct Colors *, int);
 int G_insert_commas(char *);
 int G_remove_commas(char *);
 
+/* compress.c */
+int G_compressor_number(const char *);
+const char *G_compressor_name(int);
+int G_check_compressor(int);
+int G_compress(const unsigned char *, int, unsigned char *, int, int);
+int G_expand(const unsigned char *, int, unsigned char *, int, int);
+int G_pack_compressed(const unsigned char *, int, unsigned char *, int);
+int G_read_compressed(int, int, unsigned char *, int, int);
+int G_write_compressed(int, const unsigned char *, int, int);
+
 /* copy.c */
 int G_copy(void *, const void *, int);
 
@@ -495,12 +505,14 @@ int G_zlib_compress(const unsigned char *, int, unsigned char *, int);
 int G_zlib_expand(const unsigned char *, int, unsigned char *, int);
 int G_zlib_write(int, const unsigned char *, int);
 int G_zlib_read(int, int, unsigned char *, int);
+int G_zlib_pack(const unsigned char *, int, unsigned char *);
 int G_zlib_write_noCompress(int, const unsigned char *, int);
 
 /* fork.c */
 int G_fork(void);
 
 /* format.c */
+int G__row_ptr_count(int);
 int G__check_format(int);
 int G__read_row_ptrs(int);
 int G__write_row_ptrs(int);
@@ -592,7 +604,17 @@ int G_get_raster_row(int, void *, int, RASTER_MAP_TYPE);
 int G_get_c_raster_row(int, CELL *, int);
 int G_get_f_raster_row(int, FCELL *, int);
 int G_get_d_raster_row(int, DCELL *, int);
+int G__map_cell_file(int);
+void G__unmap_cell_file(int);
+const void *G_get_raster_row_ptr(int, int, int *);
 int G_get_null_value_row(int, char *, int);
+struct Raster_reader *G_open_raster_reader(int);
+void G_close_raster_reader(struct Raster_reader *);
+int G_reader_get_raster_row(struct Raster_reader *, void *, int,
+			    RASTER_MAP_TYPE);
+int G_reader_get_raster_row_nomask(struct Raster_reader *, void *, int,
+				   RASTER_MAP_TYPE);
+int G_set_raster_prefetch(int, int);
 
 /* get_row_colr.c */
 int G_get_raster_row_colors(int, int, struct Colors *,
@@ -814,6 +836,9 @@ int G__name_in_mapset(const char *, char *, char *);
 int G__name_is_fully_qualified(const char *, char *, char *);
 char *G_fully_qualified_name(const char *, const char *);
 
+/* null_cmpr.c */
+int G__write_null_cmpr(int);
+
 /* null_val.c */
 void G__init_null_patterns(void);
 void G__set_null_value(void *, int, int, RASTER_MAP_TYPE);
@@ -862,6 +887,8 @@ int G_open_cell_new_random(const char *);
 int G_open_cell_new_uncompressed(const char *);
 int G_want_histogram(int);
 int G_set_cell_format(int);
+int G_set_raster_tile_size(int);
+int G_set_raster_compressor(int);
 int G_cellvalue_format(CELL);
 int G_open_fp_cell_new(const char *);
 int G_open_fp_cell_new_uncompressed(const char *);
@@ -962,6 +989,8 @@ int G_put_f_raster_row(int, const FCELL *);
 int G_put_d_raster_row(int, const DCELL *);
 int G__write_data(int, int, int);
 int G__write_data_compressed(int, int, int);
+struct row_queue *G__open_row_queue(int);
+int G__close_row_queue(int, int);
 int G__open_null_write(int);
 int G__write_null_bits(int, const unsigned char *, int, int, int);
 
@@ -1145,6 +1174,14 @@ char *G_tempfile(void);
 char *G__tempfile(int);
 int G__temp_element(char *);
 
+/* tiles.c */
+int G__read_tile_size(const char *, const char *);
+int G__write_tile_size(int);
+void G__init_tile_writer(int);
+int G__put_tile_row(int, int, const unsigned char *);
+int G_get_raster_tile_size(int);
+int G_get_raster_tile(int, int, int, void *, RASTER_MAP_TYPE);
+
 /* timestamp.c */
 void G_init_timestamp(struct TimeStamp *);
 void G_set_timestamp(struct TimeStamp *, const DateTime *);
@@ -1244,6 +1281,12 @@ int G_window_cols(void);
 int G__init_window(void);
 int G_row_repeat_nomask(int, int);
 
+/* worker.c */
+int G_num_workers(void);
+void G_begin_execute(void (*)(void *), void *, void **, int);
+void G_end_execute(void **);
+void G_finish_workers(void);
+
 /* wr_cellhd.c */
 int G__write_Cell_head(FILE *, const struct Cell_head *, int);
 int G__write_Cell_head3(FILE *, const struct Cell_head *, int);
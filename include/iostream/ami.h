@@ -20,6 +20,23 @@
 #ifndef _AMI_H
 #define _AMI_H
 
+// The library for external memory algorithms. Modules written in C++
+// include this header and link with $(IOSTREAMLIB) and $(GISLIB):
+//
+//  - AMI_STREAM<T>: a stream of fixed size elements in a temporary
+//    file in $STREAM_DIR ($TMPDIR or /tmp if unset), buffered with
+//    blocks of $STREAM_BUFFER bytes;
+//  - AMI_sort(): sorts a stream by a comparison object or by the <
+//    operator of the elements; with $GRASS_WORKERS set, the blocks of
+//    the runs are sorted and the merge output is written by workers,
+//    but the merges run in the calling thread;
+//  - em_pqueue and EMPQueueAdaptive: priority queues which spill to
+//    streams when they do not fit in memory.
+//
+// MM_manager.set_memory_limit() sets the memory all of them may use.
+// Modules written in C use the sort and priority queue of records
+// declared in ami_record.h instead.
+
 //debug flags
 #include "ami_config.h"
 
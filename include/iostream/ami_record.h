@@ -0,0 +1,70 @@
+/****************************************************************************
+ *
+ *  MODULE:	iostream
+ *
+ *  COPYRIGHT (C) 2007 Laura Toma
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *****************************************************************************/
+
+#ifndef _AMI_RECORD_H
+#define _AMI_RECORD_H
+
+/* The external memory sort and priority queue for modules written in
+   C. They hold records of a fixed number of bytes, ordered by a
+   comparison function as for qsort(), and keep at most the given
+   number of bytes in memory; the rest goes to streams in $STREAM_DIR
+   ($TMPDIR or /tmp if unset). Records which compare equal come out in
+   no particular order.
+
+   The library is written in C++, so the modules link with the C++
+   compiler; their Makefile reads:
+
+     LIBES = $(IOSTREAMLIB) $(GISLIB)
+     DEPENDENCIES = $(IOSTREAMDEP) $(GISDEP)
+
+     include $(MODULE_TOPDIR)/include/Make/Module.make
+
+     LINK = $(CXX)
+ */
+
+#include <stddef.h>
+
+typedef int AMI_record_cmp(const void *, const void *);
+
+struct AMI_sorter;
+struct AMI_pqueue;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* put all records, sort, then get them back in order */
+struct AMI_sorter *AMI_sorter_create(size_t, AMI_record_cmp *, size_t);
+void AMI_sorter_put(struct AMI_sorter *, const void *);
+void AMI_sorter_sort(struct AMI_sorter *);
+int AMI_sorter_get(struct AMI_sorter *, void *);
+void AMI_sorter_destroy(struct AMI_sorter *);
+
+struct AMI_pqueue *AMI_pqueue_create(size_t, AMI_record_cmp *, size_t);
+void AMI_pqueue_insert(struct AMI_pqueue *, const void *);
+int AMI_pqueue_min(struct AMI_pqueue *, void *);
+int AMI_pqueue_extract_min(struct AMI_pqueue *, void *);
+long AMI_pqueue_size(const struct AMI_pqueue *);
+void AMI_pqueue_destroy(struct AMI_pqueue *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AMI_RECORD_H */
@@ -42,41 +42,6 @@
 #define SORT_DEBUG if(0)
 
 
-/* ---------------------------------------------------------------------- */
-
-// A version of AMI_sort that takes an input streamof elements of type
-// T, creates an output stream and and uses the < operator to sort
-
-// instream is allocated;  *outstream is created
-// template<class T>
-// AMI_err 
-// AMI_sort(AMI_STREAM<T> *instream, AMI_STREAM<T> **outstream) {
-
-//   cout << "Not implemented yet!\n";
-//   exit(1);
-//   return AMI_ERROR_NO_ERROR;
-// }
-
-
-
-/* ---------------------------------------------------------------------- */
-
-// A version of AMI_sort that takes an input stream of elements of
-// type T, creates an output stream, and a user-specified comparison
-// function
-
-// instream is allocated;  *outstream is created
-// template<class T>
-// AMI_err AMI_sort(AMI_STREAM<T> *instream, AMI_STREAM<T> **outstream,
-//                  int (*cmp)(const T&, const  T&)) {
-
-//   cout << "Not implemented yet!\n";
-//   exit(1);
-//   return AMI_ERROR_NO_ERROR;
-// }
-
-
-
 /* ---------------------------------------------------------------------- */
 // A version of AMI_sort that takes an input stream of elements of
 // type T, creates an output stream, and a user-specified comparison
@@ -165,6 +130,36 @@ AMI_sort(AMI_STREAM<T> *instream, AMI_STREAM<T> **outstream, Compare *cmp,
 
 
 
+/* ---------------------------------------------------------------------- */
+
+// The comparison object used by AMI_sort without one: it orders the
+// elements by the < operator of T.
+template<class T>
+class AMI_lessCompare {
+public:
+  int compare(const T &a, const T &b) {
+    if (a < b) return -1;
+    if (b < a) return 1;
+    return 0;
+  }
+};
+
+// A version of AMI_sort that takes an input stream of elements of
+// type T, creates an output stream and uses the < operator to sort.
+
+//  create  *outstream 
+template<class T>
+AMI_err 
+AMI_sort(AMI_STREAM<T> *instream, AMI_STREAM<T> **outstream,
+	 int deleteInputStream = 0)
+{
+  AMI_lessCompare<T> cmp;
+
+  return AMI_sort(instream, outstream, &cmp, deleteInputStream);
+}
+
+
+
 template<class  T, class Compare>
 int
 isSorted(AMI_STREAM<T> *str, Compare cmp) {
@@ -29,9 +29,23 @@
 #include "replacementHeap.h"
 #include "replacementHeapBlock.h"
 
+extern "C" {
+#include <grass/gis.h>
+}
+
 #define SDEBUG if(0)
 
 
+/* With GRASS_WORKERS set, the blocks of a run are sorted by worker
+   threads while the next blocks are read, and the output of a merge
+   is written by a worker while the next block is merged (see
+   G_begin_execute()). The merges of the blocks of a run and of the
+   runs, and the reads of the runs, stay in the calling thread. The
+   tasks must not allocate with new, which registers the memory with
+   MM_manager, and must not call random(), whose state is shared: the
+   order of equal elements would depend on the threads. */
+
+
 /* if this flag is defined, a run will be split into blocks, each
    block sorted and then all blocks merged */
 #define BLOCKED_RUN 
@@ -97,6 +111,25 @@ size_t makeRun_Block(AMI_STREAM<T> *instream, T* data,
 }
 
 
+/* ---------------------------------------------------------------------- */
+/* a block of a run, sorted by a worker */
+template<class T, class Compare>
+struct SortBlockTask {
+  T *data;
+  size_t len;
+  Compare *cmp;
+  unsigned int seed;
+  void *ref;
+};
+
+template<class T, class Compare>
+void sortBlockTask(void *closure) {
+  SortBlockTask<T,Compare> *task = (SortBlockTask<T,Compare> *)closure;
+
+  quicksort(task->data, task->len, *task->cmp, 20, &task->seed);
+}
+
+
 /* ---------------------------------------------------------------------- */
 /* data is allocated; read run_size elements from stream into data and
    sort them using quicksort; instead of reading the whole chunk at
@@ -121,17 +154,41 @@ void makeRun(AMI_STREAM<T> *instream, T* &data,
     last_block_size = run_size % block_size;
   }
   
+  //sort the blocks on workers, if any
+  SortBlockTask<T,Compare> *tasks = NULL;
+  if (nblocks > 1 && G_num_workers() > 0) {
+    tasks = new SortBlockTask<T,Compare>[nblocks];
+  }
+
   //create queue of blocks waiting to be merged
   queue<MEM_STREAM<T> *> *blockList;
   MEM_STREAM<T>* str;
   blockList  = new  queue<MEM_STREAM<T> *>(nblocks);
   for (unsigned int i=0; i < nblocks; i++) {
     crt_block_size = (i == nblocks-1) ? last_block_size: block_size;
-    makeRun_Block(instream, &(data[i*block_size]), crt_block_size, cmp);
+    if (tasks) {
+      AMI_err err;
+      err = instream->read_array(&(data[i*block_size]), crt_block_size);
+      assert(err == AMI_ERROR_NO_ERROR || err == AMI_ERROR_END_OF_STREAM);
+      tasks[i].data = &(data[i*block_size]);
+      tasks[i].len = crt_block_size;
+      tasks[i].cmp = cmp;
+      tasks[i].seed = i + 1;
+      tasks[i].ref = NULL;
+      G_begin_execute(sortBlockTask<T,Compare>, &tasks[i], &tasks[i].ref, 0);
+    } else {
+      makeRun_Block(instream, &(data[i*block_size]), crt_block_size, cmp);
+    }
     str = new MEM_STREAM<T>( &(data[i*block_size]), crt_block_size);
     blockList->enqueue(str);
   }
   assert(blockList->length() == nblocks);
+  if (tasks) {
+    for (unsigned int i=0; i < nblocks; i++) {
+      G_end_execute(&tasks[i].ref);
+    }
+    delete [] tasks;
+  }
   
   //now data consists of sorted blocks: merge them 
   ReplacementHeapBlock<T,Compare> rheap(blockList);
@@ -255,6 +312,59 @@ runFormation(AMI_STREAM<T> *instream, Compare *cmp) {
 
 
 
+/* ---------------------------------------------------------------------- */
+/* a block of the output of a merge, written by a worker */
+template<class T>
+struct WriteBlockTask {
+  AMI_STREAM<T> *str;
+  T *data;
+  size_t len;
+  void *ref;
+};
+
+template<class T>
+void writeBlockTask(void *closure) {
+  WriteBlockTask<T> *task = (WriteBlockTask<T> *)closure;
+
+  task->str->write_array(task->data, task->len);
+}
+
+
+/* ---------------------------------------------------------------------- */
+/* empty rheap into str: the elements are merged into one block while
+   the other one is written by a worker */
+template<class T, class Compare>
+void mergeBlocks(ReplacementHeap<T,Compare> &rheap, AMI_STREAM<T> *str) {
+  size_t len = UntypedStream::get_block_length() / sizeof(T) + 1;
+  T *block[2];
+  size_t n = 0;
+  int crt = 0;
+  WriteBlockTask<T> task;
+
+  block[0] = new T[len];
+  block[1] = new T[len];
+  task.str = str;
+  task.ref = NULL;
+
+  while (!rheap.empty()) {
+    block[crt][n++] = rheap.extract_min();
+    if (n == len || rheap.empty()) {
+      //wait for the other block before handing this one over
+      G_end_execute(&task.ref);
+      task.data = block[crt];
+      task.len = n;
+      G_begin_execute(writeBlockTask<T>, &task, &task.ref, 0);
+      crt = 1 - crt;
+      n = 0;
+    }
+  }
+  G_end_execute(&task.ref);
+
+  delete [] block[0];
+  delete [] block[1];
+}
+
+
 /* ---------------------------------------------------------------------- */
 
 //this is one pass of merge; estimate max possible merge arity <ar>
@@ -288,6 +398,11 @@ singleMerge(queue<char*>* streamList, Compare *cmp)
 
   //estimate max possible merge arity with available memory (approx M/B)
   mm_avail = MM_manager.memory_available();
+  //with workers, mergeBlocks() needs two blocks for the output
+  if (G_num_workers() > 0) {
+    size_t blocks = 2 * (UntypedStream::get_block_length() + sizeof(T));
+    mm_avail = (mm_avail > blocks) ? mm_avail - blocks : 0;
+  }
   //blocksize = getpagesize();
   //should use AMI function, but there's no stream at this point
   //now use static mtd -RW 5/05
@@ -311,14 +426,18 @@ singleMerge(queue<char*>* streamList, Compare *cmp)
   ReplacementHeap<T,Compare> rheap(arity, streamList);
   SDEBUG rheap.print(cerr);
 
-  int i = 0;
-  while (!rheap.empty()) {
-    //mergedStr->write_item( rheap.extract_min() );
-    //xxx should check error here
-    elt = rheap.extract_min();
-    mergedStr->write_item(elt);
-    //SDEBUG cerr << "smerge: written " << elt << endl;
-    i++;
+  if (G_num_workers() > 0) {
+    mergeBlocks(rheap, mergedStr);
+  } else {
+    int i = 0;
+    while (!rheap.empty()) {
+      //mergedStr->write_item( rheap.extract_min() );
+      //xxx should check error here
+      elt = rheap.extract_min();
+      mergedStr->write_item(elt);
+      //SDEBUG cerr << "smerge: written " << elt << endl;
+      i++;
+    }
   }
   
   SDEBUG cout << "..done\n";
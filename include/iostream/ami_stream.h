@@ -50,7 +50,10 @@ using namespace std;
 // All streams will be names STREAM_*****
 #define BASE_NAME "STREAM"
 
+// Default size in bytes of the buffer of each stream; the environment
+// variable below overrides it (the size is rounded up to whole pages)
 #define STREAM_BUFFER_SIZE (1<<18)
+#define STREAM_BUFFER_ENV "STREAM_BUFFER"
 
 
 //
@@ -97,6 +100,19 @@ enum persistence {
   PERSIST_READ_ONCE
 };
 
+/**********************************************************************/
+/* size of the stream buffers, see STREAM_BUFFER_ENV */
+size_t ami_stream_buffer_size();
+
+/* memory taken by one stream buffer, including its alignment */
+size_t ami_stream_buffer_usage();
+
+/* page aligned stream buffers, set up for sequential access; block
+   receives the allocation to be passed to ami_stream_free_buffer() */
+char *ami_stream_buffer(FILE *fp, const char *path, char **block);
+void ami_stream_free_buffer(char *block);
+
+
 /* an un-templated version makes for easier debugging */
 class UntypedStream {
 protected:
@@ -118,12 +134,13 @@ protected:
 
   //stream buffer passed in the call to setvbuf when file is opened
   char* buf;
+  //allocation holding buf, see ami_stream_buffer()
+  char* buf_block;
   int eof_reached;
 
  public:
   static unsigned int get_block_length()  {
-    return STREAM_BUFFER_SIZE;
-    //return getpagesize();
+    return ami_stream_buffer_size();
   };
 
 };
@@ -216,13 +233,7 @@ AMI_STREAM<T>::AMI_STREAM() {
   fildes = fd;
   fp = open_stream(fd, access_mode);
   
-  /* a stream is by default buffered with a buffer of size BUFSIZ=1K */
-  buf = new char[STREAM_BUFFER_SIZE];
-  if (setvbuf(fp, buf, _IOFBF, STREAM_BUFFER_SIZE) != 0) {
-    cerr << "ERROR: setvbuf failed (stream " << path << ") with: "
-         << strerror(errno) << endl;
-    exit(1);
-  }
+  buf = ami_stream_buffer(fp, path, &buf_block);
   
   // By default, all streams are deleted at destruction time.
   per = PERSIST_DELETE;
@@ -261,13 +272,7 @@ AMI_STREAM<T>::AMI_STREAM(const char *path_name, AMI_stream_type st) {
 	fildes = -1;
   }
 
-  /* a stream is by default buffered with a buffer of size BUFSIZ=1K */
-  buf = new char[STREAM_BUFFER_SIZE];
-  if (setvbuf(fp, buf, _IOFBF, STREAM_BUFFER_SIZE) != 0) {
-    cerr << "ERROR: setvbuf failed (stream " << path << ") with: "
-         << strerror(errno) << endl;
-    exit(1);
-  }
+  buf = ami_stream_buffer(fp, path, &buf_block);
 
   eof_reached = 0;
 
@@ -471,13 +476,11 @@ AMI_STREAM<T>::main_memory_usage(size_t *usage, MM_stream_usage usage_type) {
      *usage = sizeof (AMI_STREAM<T>);
      break;
    case MM_STREAM_USAGE_BUFFER:
-     // *usage = get_block_length();
-     *usage = STREAM_BUFFER_SIZE*sizeof(char);
+     *usage = ami_stream_buffer_usage();
      break;
    case MM_STREAM_USAGE_CURRENT:
    case MM_STREAM_USAGE_MAXIMUM:
-     // *usage = sizeof (*this) + get_block_length();
-     *usage = sizeof (AMI_STREAM<T>) + STREAM_BUFFER_SIZE*sizeof(char);
+     *usage = sizeof (AMI_STREAM<T>) + ami_stream_buffer_usage();
      break;
    }
    return AMI_ERROR_NO_ERROR;
@@ -492,7 +495,7 @@ AMI_STREAM<T>::~AMI_STREAM(void)  {
   DEBUG_DELETE cerr << "~AMI_STREAM: " << path << "(" << this << ")\n";
   assert(fp);
   fclose(fp);
-  delete buf;
+  ami_stream_free_buffer(buf_block);
   
   // Get rid of the file if not persistent and if not substream.
   if ((per != PERSIST_PERSISTENT) && (substream_level == 0)) {
@@ -33,8 +33,11 @@
 // less that or equal to everything above it.  Furthermore, it will
 // not be 0 since this will leave us to recurse on the whole array
 // again.
+// If seed is given, the pivot is chosen by a generator private to the
+// caller instead of random(), whose state is shared by all threads.
 template<class T, class CMPR>
-void partition(T *data, size_t n, size_t &pivot, CMPR &cmp) {
+void partition(T *data, size_t n, size_t &pivot, CMPR &cmp,
+	       unsigned int *seed = NULL) {
     T *ptpart, tpart;
     T *p, *q;
     T t0;
@@ -42,11 +45,16 @@ void partition(T *data, size_t n, size_t &pivot, CMPR &cmp) {
     // Try to get a good partition value and avoid being bitten by already
     // sorted input.
     //ptpart = data + (random() % n);
+    if (seed) {
+      *seed = *seed * 1103515245 + 12345;
+      ptpart = data + ((*seed >> 8) % n);
+    } else {
 #ifdef __MINGW32__
     ptpart = data + (rand() % n);
 #else
     ptpart = data + (random() % n);
 #endif
+    }
 
     tpart = *ptpart;
     *ptpart = data[0];
@@ -98,7 +106,8 @@ void insertionsort(T *data, size_t n, CMPR &cmp) {
 
 /* ---------------------------------------------------------------------- */
 template<class T, class CMPR>
-void quicksort(T *data, size_t n, CMPR &cmp, size_t min_len = 20)  {
+void quicksort(T *data, size_t n, CMPR &cmp, size_t min_len = 20,
+	       unsigned int *seed = NULL)  {
 
   size_t pivot;
   if (n < min_len) {
@@ -106,9 +115,9 @@ void quicksort(T *data, size_t n, CMPR &cmp, size_t min_len = 20)  {
     return;
   }
   //else
-  partition(data, n, pivot, cmp);
-  quicksort(data, pivot + 1, cmp, min_len);
-  quicksort(data + pivot + 1, n - pivot - 1, cmp, min_len);
+  partition(data, n, pivot, cmp, seed);
+  quicksort(data, pivot + 1, cmp, min_len, seed);
+  quicksort(data + pivot + 1, n - pivot - 1, cmp, min_len, seed);
 }
 
 
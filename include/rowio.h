@@ -14,7 +14,7 @@ typedef struct
     struct ROWIO_RCB
     {
 	void *buf;		/* data buffer */
-	int age;		/* for order of access */
+	int age;		/* unused, buffers are selected by row number */
 	int row;		/* row number */
 	int dirty;
     } *rcb;
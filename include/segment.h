@@ -27,12 +27,19 @@ typedef struct
     {
 	char *buf;		/* data buffer */
 	char dirty;		/* dirty flag */
-	int age;		/* for order of access */
+	int age;		/* accessed flag for replacement */
 	int n;			/* segment number */
     } *scb;
     int nseg;			/* number of segments in memory */
     int cur;			/* last accessed segment */
     int offset;			/* offset of data past header */
+    int *load_idx;		/* slot of each segment, -1 if not in memory */
+    int hand;			/* next slot checked for replacement */
+    long hits;			/* accesses to segments in memory */
+    long misses;		/* accesses which read a segment */
+    char *map;			/* mapped segment data, NULL if paged */
+    size_t map_size;		/* size of the mapping */
+    struct segment_writer *writer;	/* write-behind, see pageout.c */
 } SEGMENT;
 
 #include <grass/gis.h>
@@ -44,6 +51,7 @@ int segment_format_nofill(int, int, int, int, int, int);
 int segment_get(SEGMENT *, void *, int, int);
 int segment_get_row(const SEGMENT *, void *, int);
 int segment_init(SEGMENT *, int, int);
+int segment_init_mmap(SEGMENT *, int, int);
 int segment_pagein(SEGMENT *, int);
 int segment_pageout(SEGMENT *, int);
 int segment_put(SEGMENT *, const void *, int, int);
@@ -51,5 +59,7 @@ int segment_put_row(const SEGMENT *, const void *, int);
 int segment_release(SEGMENT *);
 int segment_seek(const SEGMENT *, int, int);
 int segment_setup(SEGMENT *);
+int segment_setup_mmap(SEGMENT *);
+int segment_stats(const SEGMENT *, long *, long *);
 
 #endif /* GRASS_SEGMENT_H */
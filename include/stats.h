@@ -48,7 +48,13 @@ extern stat_func_w w_var;
 extern stat_func_w w_skew;
 extern stat_func_w w_kurt;
 
+extern void c_quants(DCELL *, DCELL *, int, const double *, int);
+
 extern int sort_cell(DCELL *, int);
 extern int sort_cell_w(DCELL(*)[2], int);
 
+extern int partition_cell(DCELL *, int);
+extern void select_cell(DCELL *, int, int);
+extern void select_cells(DCELL *, int, const int *, int);
+
 #endif
@@ -69,6 +69,28 @@ struct fileinfo			/* Information for opened cell files */
     int min_null_row;		/* Minimum row null row number in memory */
     struct Quant quant;
     struct GDAL_link *gdal;
+    struct row_queue *row_queue;	/* rows being compressed, see put_row.c */
+    struct row_prefetch *prefetch;	/* read-ahead, see get_row.c    */
+    unsigned char *map;		/* mapped cell file (uncompressed maps) */
+    size_t map_size;		/* size of the mapping          */
+    int tile_size;		/* cells per tile side, 0 if stored in rows */
+    struct tile_cache *tiles;	/* tile buffers, see tiles.c    */
+    int null_compressor;	/* compressor of the null file, 0 if plain */
+    off_t *null_row_ptr;	/* null row addresses (compressed null file) */
+};
+
+struct Raster_reader		/* Row decoding context, see get_row.c */
+{
+    int fd;			/* descriptor the cell data is read from */
+    int owned;			/* created by G_open_raster_reader()    */
+    int null_fd;		/* null file kept open by owned readers */
+    struct fileinfo *fcb;	/* map state used for decoding          */
+    unsigned char *compressed_buf;	/* buffers, as in struct G__    */
+    unsigned char *work_buf;
+    char *null_buf;
+    CELL *temp_buf;
+    CELL *mask_buf;
+    struct Raster_reader *mask;	/* reader for the MASK (owned readers)  */
 };
 
 struct G__			/*  Structure of library globals */
@@ -97,6 +119,18 @@ struct G__			/*  Structure of library globals */
 
 extern struct G__ G__;		/* allocated in gisinit */
 
+/* null_cmpr.c */
+int G__open_null_read(struct fileinfo *);
+int G__read_null_row(struct fileinfo *, int, int, unsigned char *);
+
+/* tiles.c */
+void G__free_tile_cache(struct fileinfo *);
+int G__read_tile_row(struct fileinfo *, int, int, unsigned char *, int *);
+
+/* compressor of floating point rows, tiles and null rows (see compress.c):
+   RLE maps use zlib for these */
+#define BLOCK_COMPRESSOR(compressed) ((compressed) == 1 ? 2 : (compressed))
+
 #define OPEN_OLD              1
 #define OPEN_NEW_COMPRESSED   2
 #define OPEN_NEW_UNCOMPRESSED 3
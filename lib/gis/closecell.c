@@ -38,6 +38,7 @@
 #define FORMAT_FILE "f_format"
 #define QUANT_FILE  "f_quant"
 #define NULL_FILE   "null"
+#define NULLC_FILE  "nullcmpr"
 
 static int close_old(int);
 static int close_new(int, int);
@@ -133,12 +134,20 @@ static int close_old(int fd)
        This is obsolete since now the mask_bus is always allocated
      */
 
+    if (fcb->prefetch)
+	G_set_raster_prefetch(fd, 0);
+
+    G__unmap_cell_file(fd);
+    G__free_tile_cache(fcb);
+
     if (fcb->gdal)
 	G_close_gdal_link(fcb->gdal);
 
     for (i = 0; i < NULL_ROWS_INMEM; i++)
 	G_free(fcb->NULL_ROWS[i]);
     G_free(fcb->null_work_buf);
+    if (fcb->null_row_ptr)
+	G_free(fcb->null_row_ptr);
 
     if (fcb->cellhd.compressed)
 	G_free(fcb->row_ptr);
@@ -150,10 +159,8 @@ static int close_old(int fd)
 	G_free_reclass(&fcb->reclass);
     fcb->open_mode = -1;
 
-    if (fcb->map_type != CELL_TYPE) {
+    if (fcb->map_type != CELL_TYPE)
 	G_quant_free(&fcb->quant);
-	xdr_destroy(&fcb->xdrstream);
-    }
     close(fd);
 
     return 1;
@@ -169,6 +176,9 @@ static int close_new(int fd, int ok)
     CELL cell_min, cell_max;
     int row, i, open_mode;
 
+    /* errors writing the null file or the support files are kept */
+    stat = 1;
+
     if (ok) {
 	switch (fcb->open_mode) {
 	case OPEN_NEW_COMPRESSED:
@@ -191,14 +201,25 @@ static int close_new(int fd, int ok)
 	    fcb->data = NULL;
 	}
 
+	/* write the rows still being compressed; on error the map is
+	   discarded, as the rows written so far are incomplete */
+	if (G__close_row_queue(fd, 1) < 0) {
+	    close_new(fd, 0);
+	    return -1;
+	}
+
 	/* create path : full null file name */
 	G__make_mapset_element_misc("cell_misc", fcb->name);
+	G__file_name_misc(path, "cell_misc", NULLC_FILE, fcb->name,
+			  G_mapset());
+	remove(path);
 	G__file_name_misc(path, "cell_misc", NULL_FILE, fcb->name,
 			  G_mapset());
 	remove(path);
 
 	if (fcb->null_cur_row > 0) {
-	    /* if temporary NULL file exists, write it into cell_misc/name/null */
+	    /* if temporary NULL file exists, write it into cell_misc/name/null
+	       (or nullcmpr, see null_cmpr.c) */
 	    int null_fd;
 
 	    null_fd = G__open_null_write(fd);
@@ -224,7 +245,11 @@ static int close_new(int fd, int ok)
 	    }
 	    close(null_fd);
 
-	    if (rename(fcb->null_temp_name, path)) {
+	    if (fcb->null_compressor) {
+		if (G__write_null_cmpr(fd) < 0)
+		    stat = -1;
+	    }
+	    else if (rename(fcb->null_temp_name, path)) {
 		G_warning(_("closecell: can't move %s\nto null file %s"),
 			  fcb->null_temp_name, path);
 		stat = -1;
@@ -239,10 +264,15 @@ static int close_new(int fd, int ok)
 	}			/* null_cur_row > 0 */
 
 	if (fcb->open_mode == OPEN_NEW_COMPRESSED) {	/* auto compression */
-	    fcb->row_ptr[fcb->cellhd.rows] = lseek(fd, 0L, SEEK_CUR);
+	    fcb->row_ptr[G__row_ptr_count(fd)] = lseek(fd, 0L, SEEK_CUR);
 	    G__write_row_ptrs(fd);
 	}
 
+	if (G__write_tile_size(fd) < 0) {
+	    G_warning(_("Unable to write tile size of map %s"), fcb->name);
+	    stat = -1;
+	}
+
 	if (fcb->map_type != CELL_TYPE) {	/* floating point map */
 	    int cell_fd;
 
@@ -272,6 +302,11 @@ static int close_new(int fd, int ok)
 	    close(fd);
 	}
     }				/* ok */
+
+    /* discard pending rows of unopened maps */
+    G__close_row_queue(fd, 0);
+    G__free_tile_cache(fcb);
+
     /* NOW CLOSE THE FILE DESCRIPTOR */
 
     close(fd);
@@ -292,7 +327,6 @@ static int close_new(int fd, int ok)
      * if the move fails, tell the user, but go ahead and create
      * the support files
      */
-    stat = 1;
     if (ok && (fcb->temp_name != NULL)) {
 	G__file_name(path, CELL_DIR, fcb->name, fcb->mapset);
 	remove(path);
@@ -0,0 +1,364 @@
+/*!
+   \file compress.c
+
+   \brief GIS library - compressors for raster data
+
+   Compressed raster maps record the method used for their rows in the
+   <tt>compressed</tt> field of the cell header:
+
+   - 1: RLE (integer maps only; floating point rows use zlib)
+   - 2: zlib (DEFLATE)
+   - 3: LZ4
+   - 4: Zstandard
+
+   LZ4 and Zstandard are only available if GRASS was configured
+   <tt>--with-lz4</tt> or <tt>--with-zstd</tt>. The functions below
+   compress blocks of data (floating point rows, integer rows other
+   than RLE, tiles and null file rows) with any of the methods 2 to 4.
+   The offsets of maps compressed with 3 or 4 are preceded by a zero
+   byte (see format.c), so that older versions refuse to open them.
+
+   (C) 2013 by the GRASS Development Team
+
+   This program is free software under the
+   GNU General Public License (>=v2).
+   Read the file COPYING that comes with GRASS
+   for details.
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include <grass/config.h>
+#include <grass/gis.h>
+#include <grass/glocale.h>
+
+#ifdef HAVE_LZ4_H
+#include <lz4.h>
+#endif
+#ifdef HAVE_ZSTD_H
+#include <zstd.h>
+#endif
+
+#define COMPRESSED_NO  (unsigned char)'0'
+#define COMPRESSED_YES (unsigned char)'1'
+
+typedef int compress_func(const unsigned char *, int, unsigned char *, int);
+
+struct compressor
+{
+    const char *name;
+    int available;
+    compress_func *compress;	/* NULL if not a block compressor */
+    compress_func *expand;
+};
+
+/*--------------------------------------------------------------------------*/
+
+#ifdef HAVE_LZ4_H
+
+static int lz4_compress(const unsigned char *src, int src_sz,
+			unsigned char *dst, int dst_sz)
+{
+    int n = LZ4_compress_default((const char *)src, (char *)dst, src_sz,
+				 dst_sz);
+
+    return n > 0 ? n : -2;
+}
+
+static int lz4_expand(const unsigned char *src, int src_sz,
+		      unsigned char *dst, int dst_sz)
+{
+    int n = LZ4_decompress_safe((const char *)src, (char *)dst, src_sz,
+				dst_sz);
+
+    return n >= 0 ? n : -1;
+}
+
+#define LZ4_AVAILABLE 1
+
+#else
+
+#define lz4_compress NULL
+#define lz4_expand NULL
+#define LZ4_AVAILABLE 0
+
+#endif
+
+#ifdef HAVE_ZSTD_H
+
+static int zstd_compress(const unsigned char *src, int src_sz,
+			 unsigned char *dst, int dst_sz)
+{
+    size_t n = ZSTD_compress(dst, dst_sz, src, src_sz, 3);
+
+    /* the only error to be expected is a too small dst */
+    return ZSTD_isError(n) ? -2 : (int)n;
+}
+
+static int zstd_expand(const unsigned char *src, int src_sz,
+		       unsigned char *dst, int dst_sz)
+{
+    size_t n = ZSTD_decompress(dst, dst_sz, src, src_sz);
+
+    return ZSTD_isError(n) ? -1 : (int)n;
+}
+
+#define ZSTD_AVAILABLE 1
+
+#else
+
+#define zstd_compress NULL
+#define zstd_expand NULL
+#define ZSTD_AVAILABLE 0
+
+#endif
+
+static int zlib_compress(const unsigned char *src, int src_sz,
+			 unsigned char *dst, int dst_sz)
+{
+    return G_zlib_compress(src, src_sz, dst, dst_sz);
+}
+
+static int zlib_expand(const unsigned char *src, int src_sz,
+		       unsigned char *dst, int dst_sz)
+{
+    return G_zlib_expand(src, src_sz, dst, dst_sz);
+}
+
+/* indexed by the compressed field of the cell header */
+static const struct compressor compressors[] = {
+    {NULL, 0, NULL, NULL},
+    {"RLE", 1, NULL, NULL},
+    {"ZLIB", 1, zlib_compress, zlib_expand},
+    {"LZ4", LZ4_AVAILABLE, lz4_compress, lz4_expand},
+    {"ZSTD", ZSTD_AVAILABLE, zstd_compress, zstd_expand},
+};
+
+#define NUM_COMPRESSORS (int)(sizeof(compressors) / sizeof(compressors[0]))
+
+static const struct compressor *block_compressor(int number)
+{
+    if (number <= 0 || number >= NUM_COMPRESSORS ||
+	!compressors[number].available || !compressors[number].compress)
+	return NULL;
+
+    return &compressors[number];
+}
+
+/*--------------------------------------------------------------------------*/
+
+/*!
+ * \brief Get the number of a compressor
+ *
+ * \param name compressor name (RLE, ZLIB, LZ4 or ZSTD, case insensitive)
+ *
+ * \return compressor number as stored in the cell header
+ * \return -1 if the name is unknown
+ */
+int G_compressor_number(const char *name)
+{
+    int i;
+
+    for (i = 1; i < NUM_COMPRESSORS; i++)
+	if (G_strcasecmp(name, compressors[i].name) == 0)
+	    return i;
+
+    return -1;
+}
+
+/*!
+ * \brief Get the name of a compressor
+ *
+ * \param number compressor number
+ *
+ * \return compressor name
+ * \return NULL if the number is unknown
+ */
+const char *G_compressor_name(int number)
+{
+    if (number <= 0 || number >= NUM_COMPRESSORS)
+	return NULL;
+
+    return compressors[number].name;
+}
+
+/*!
+ * \brief Check whether a compressor is available
+ *
+ * \param number compressor number
+ *
+ * \return 1 if available
+ * \return 0 if GRASS was built without it
+ * \return -1 if the number is unknown
+ */
+int G_check_compressor(int number)
+{
+    if (number <= 0 || number >= NUM_COMPRESSORS)
+	return -1;
+
+    return compressors[number].available;
+}
+
+/*!
+ * \brief Compress a block of data
+ *
+ * \param src data
+ * \param src_sz size of the data
+ * \param[out] dst buffer for the compressed data
+ * \param dst_sz size of dst
+ * \param number compressor (ZLIB, LZ4 or ZSTD)
+ *
+ * \return number of bytes stored in dst
+ * \return -1 on error
+ * \return -2 if dst is too small
+ */
+int G_compress(const unsigned char *src, int src_sz, unsigned char *dst,
+	       int dst_sz, int number)
+{
+    const struct compressor *c = block_compressor(number);
+
+    if (!c || src == NULL || dst == NULL || src_sz < 0)
+	return -1;
+
+    return (*c->compress) (src, src_sz, dst, dst_sz);
+}
+
+/*!
+ * \brief Expand a block of data
+ *
+ * \param src compressed data
+ * \param src_sz size of the compressed data
+ * \param[out] dst buffer for the data
+ * \param dst_sz size of dst
+ * \param number compressor (ZLIB, LZ4 or ZSTD)
+ *
+ * \return number of bytes stored in dst
+ * \return -1 on error
+ */
+int G_expand(const unsigned char *src, int src_sz, unsigned char *dst,
+	     int dst_sz, int number)
+{
+    const struct compressor *c = block_compressor(number);
+
+    if (!c || src == NULL || dst == NULL || src_sz < 0)
+	return -1;
+
+    return (*c->expand) (src, src_sz, dst, dst_sz);
+}
+
+/*!
+ * \brief Compress a block of data behind a compression flag
+ *
+ * Like G_zlib_pack(): dst receives a flag byte followed by the
+ * compressed data or, if compression does not pay off, by the
+ * original data. dst must hold nbytes + 1 bytes.
+ *
+ * \param src data
+ * \param nbytes size of the data
+ * \param[out] dst buffer
+ * \param number compressor (ZLIB, LZ4 or ZSTD)
+ *
+ * \return number of bytes stored in dst
+ * \return -1 if the compressor is not available
+ */
+int G_pack_compressed(const unsigned char *src, int nbytes,
+		      unsigned char *dst, int number)
+{
+    int err;
+
+    if (!block_compressor(number) || src == NULL || dst == NULL ||
+	nbytes < 0)
+	return -1;
+
+    /* keep the data as it is if compression fails or does not pay off */
+    err = G_compress(src, nbytes, dst + 1, nbytes, number);
+
+    if (err > 0 && err <= nbytes) {
+	dst[0] = COMPRESSED_YES;
+	return err + 1;
+    }
+
+    dst[0] = COMPRESSED_NO;
+    memcpy(dst + 1, src, nbytes);
+
+    return nbytes + 1;
+}
+
+/*!
+ * \brief Read and expand a block written by G_write_compressed()
+ *
+ * \param fd file descriptor, positioned at the start of the block
+ * \param rbytes size of the block in the file
+ * \param[out] dst buffer for the data
+ * \param nbytes size of dst
+ * \param number compressor (ZLIB, LZ4 or ZSTD)
+ *
+ * \return number of bytes stored in dst
+ * \return -1 on error
+ */
+int G_read_compressed(int fd, int rbytes, unsigned char *dst, int nbytes,
+		      int number)
+{
+    unsigned char *b;
+    int nread, err;
+
+    if (dst == NULL || nbytes < 0 || rbytes <= 0)
+	return -1;
+
+    b = G_malloc(rbytes);
+
+    nread = 0;
+    do {
+	err = read(fd, b + nread, rbytes - nread);
+	if (err >= 0)
+	    nread += err;
+    } while (err > 0 && nread < rbytes);
+
+    if (nread < rbytes)
+	err = -1;
+    else if (b[0] == COMPRESSED_NO) {
+	err = rbytes - 1 < nbytes ? rbytes - 1 : nbytes;
+	memcpy(dst, b + 1, err);
+    }
+    else if (b[0] == COMPRESSED_YES)
+	err = G_expand(b + 1, rbytes - 1, dst, nbytes, number);
+    else
+	/* not at the start of a block */
+	err = -1;
+
+    G_free(b);
+
+    return err;
+}
+
+/*!
+ * \brief Compress a block of data and write it to a file
+ *
+ * \param fd file descriptor
+ * \param src data
+ * \param nbytes size of the data
+ * \param number compressor (ZLIB, LZ4 or ZSTD)
+ *
+ * \return number of bytes written
+ * \return -1 on error
+ */
+int G_write_compressed(int fd, const unsigned char *src, int nbytes,
+		       int number)
+{
+    unsigned char *dst;
+    int n;
+
+    if (src == NULL || nbytes < 0)
+	return -1;
+
+    dst = G_malloc(nbytes + 1);
+    n = G_pack_compressed(src, nbytes, dst, number);
+
+    if (n > 0 && write(fd, dst, n) != n)
+	n = -1;
+
+    G_free(dst);
+
+    return n;
+}
@@ -60,6 +60,19 @@
  *                                                                  *
  * ================================================================ *
  * int                                                              *
+ * G_zlib_pack (src, nbytes, dst)                                   *
+ *     int nbytes;                                                  *
+ *     unsigned char *src, *dst;                                    *
+ * ---------------------------------------------------------------- *
+ * Does the work of G_zlib_write() without writing: the compression *
+ * flag followed by the compressed (or, if compression does not     *
+ * pay off, the original) data is stored in 'dst', which must hold  *
+ * nbytes + 1 bytes. This allows rows to be compressed by other     *
+ * threads than the one writing the file.                           *
+ * Returns the number of bytes stored in dst, or -1 for an error.   *
+ *                                                                  *
+ * ================================================================ *
+ * int                                                              *
  * G_zlib_write_noCompress (fd, src, nbytes)                        *
  *     int fd, nbytes;                                              *
  *     unsigned char *src;                                          *
@@ -195,60 +208,60 @@ int G_zlib_read(int fd, int rbytes, unsigned char *dst, int nbytes)
 }				/* G_zlib_read() */
 
 
+int G_zlib_pack(const unsigned char *src, int nbytes, unsigned char *dst)
+{
+    int err, i;
+
+    /* Catch errors */
+    if (src == NULL || dst == NULL || nbytes < 0)
+	return -1;
+
+    /* Compress behind the flag byte */
+    err = G_zlib_compress(src, nbytes, dst + 1, nbytes);
+
+    /* If compression succeeded keep the compressed row,
+     * otherwise store the uncompressed row. Compression will fail
+     * if dst is too small (i.e. compressed data is larger)
+     */
+    if (err > 0 && err <= nbytes) {
+	dst[0] = G_ZLIB_COMPRESSED_YES;
+	return err + 1;
+    }
+
+    dst[0] = G_ZLIB_COMPRESSED_NO;
+    for (i = 0; i < nbytes; i++)
+	dst[i + 1] = src[i];
+
+    return nbytes + 1;
+}				/* G_zlib_pack() */
+
+
 int G_zlib_write(int fd, const unsigned char *src, int nbytes)
 {
     int dst_sz, nwritten, err;
-    unsigned char *dst, compressed;
+    unsigned char *dst;
 
     /* Catch errors */
     if (src == NULL || nbytes < 0)
 	return -1;
 
-    dst_sz = nbytes;
     if (NULL == (dst = (unsigned char *)
-		 G_calloc(dst_sz, sizeof(unsigned char))))
+		 G_calloc(nbytes + 1, sizeof(unsigned char))))
 	return -1;
 
-    /* Now just call G_zlib_compress() */
-    err = G_zlib_compress(src, nbytes, dst, dst_sz);
-
-    /* If compression succeeded write compressed row,
-     * otherwise write uncompressed row. Compression will fail
-     * if dst is too small (i.e. compressed data is larger)
-     */
-    if (err > 0 && err <= dst_sz) {
-	dst_sz = err;
-	/* Write the compression flag */
-	compressed = G_ZLIB_COMPRESSED_YES;
-	if (write(fd, &compressed, 1) != 1) {
-	    G_free(dst);
-	    return -1;
-	}
-	nwritten = 0;
-	do {
-	    err = write(fd, dst + nwritten, dst_sz - nwritten);
-	    if (err >= 0)
-		nwritten += err;
-	} while (err > 0 && nwritten < dst_sz);
-	/* Account for extra byte */
-	nwritten++;
+    /* Compression flag and row */
+    dst_sz = G_zlib_pack(src, nbytes, dst);
+    if (dst_sz < 0) {
+	G_free(dst);
+	return -1;
     }
-    else {
-	/* Write compression flag */
-	compressed = G_ZLIB_COMPRESSED_NO;
-	if (write(fd, &compressed, 1) != 1) {
-	    G_free(dst);
-	    return -1;
-	}
-	nwritten = 0;
-	do {
-	    err = write(fd, src + nwritten, nbytes - nwritten);
-	    if (err >= 0)
-		nwritten += err;
-	} while (err > 0 && nwritten < nbytes);
-	/* Account for extra byte */
-	nwritten++;
-    }				/* if (err > 0) */
+
+    nwritten = 0;
+    do {
+	err = write(fd, dst + nwritten, dst_sz - nwritten);
+	if (err >= 0)
+	    nwritten += err;
+    } while (err > 0 && nwritten < dst_sz);
 
     /* Done with the dst buffer */
     G_free(dst);
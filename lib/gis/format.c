@@ -38,6 +38,11 @@
    0 0 0 74        offset of end of data
    \endverbatim
 
+   Maps which older versions can not read, tiled maps (see tiles.c) and
+   maps compressed with a method other than RLE or zlib (see
+   compress.c), have a zero byte before the header. Older versions take
+   it for an invalid offset size and refuse to open the map.
+
    See G__write_row_ptrs() below for the code which writes this data. 
    However, note that the row offsets are initially zero; 
    they get overwritten later (if you are writing compressed data,
@@ -50,6 +55,24 @@
 
  */
 
+/*
+ * Number of offsets in the table at the start of a compressed cell
+ * file, not counting the end of data: one per row, or one per tile for
+ * tiled maps (see tiles.c).
+ */
+
+int G__row_ptr_count(int fd)
+{
+    struct fileinfo *fcb = &G__.fileinfo[fd];
+    int size = fcb->tile_size;
+
+    if (size <= 0)
+	return fcb->cellhd.rows;
+
+    return ((fcb->cellhd.rows + size - 1) / size) *
+	((fcb->cellhd.cols + size - 1) / size);
+}
+
 /**********************************************************************
  *
  *   G__check_format(int fd)
@@ -87,17 +110,23 @@ int G__check_format(int fd)
     if (!fcb->cellhd.compressed)
 	return fd;
 
-    /* allocate space to hold the row address array */
-    fcb->row_ptr = G_calloc(fcb->cellhd.rows + 1, sizeof(off_t));
+    /* allocate space to hold the row (or tile) address array */
+    fcb->row_ptr = G_calloc(G__row_ptr_count(fd) + 1, sizeof(off_t));
 
     /* read the row address array */
     return G__read_row_ptrs(fd);
 }
 
+/* the zero byte before the offsets, see above */
+static int has_marker(const struct fileinfo *fcb)
+{
+    return fcb->tile_size > 0 || fcb->cellhd.compressed > 2;
+}
+
 int G__read_row_ptrs(int fd)
 {
     struct fileinfo *fcb = &G__.fileinfo[fd];
-    int nrows = fcb->cellhd.rows;
+    int nrows = G__row_ptr_count(fd);
     unsigned char nbytes;
     unsigned char *buf, *b;
     int n;
@@ -122,6 +151,9 @@ int G__read_row_ptrs(int fd)
      *  actual values do not exceed the capability of the off_t)
      */
 
+    if (has_marker(fcb) && (read(fd, &nbytes, 1) != 1 || nbytes != 0))
+	goto badread;
+
     if (read(fd, &nbytes, 1) != 1)
 	goto badread;
     if (nbytes == 0)
@@ -162,7 +194,7 @@ int G__read_row_ptrs(int fd)
 int G__write_row_ptrs(int fd)
 {
     struct fileinfo *fcb = &G__.fileinfo[fd];
-    int nrows = fcb->cellhd.rows;
+    int nrows = G__row_ptr_count(fd);
     int nbytes = sizeof(off_t);
     unsigned char *buf, *b;
     int len, row, result;
@@ -170,7 +202,11 @@ int G__write_row_ptrs(int fd)
     lseek(fd, 0L, SEEK_SET);
 
     len = (nrows + 1) * nbytes + 1;
+    if (has_marker(fcb))
+	len++;
     b = buf = G_malloc(len);
+    if (has_marker(fcb))
+	*b++ = 0;
     *b++ = nbytes;
 
     for (row = 0; row <= nrows; row++) {
@@ -16,6 +16,10 @@
 #include <string.h>
 #include <unistd.h>
 #include <sys/types.h>
+#ifndef __MINGW32__
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
 
 #include <rpc/types.h>		/* need this for sgi */
 #include <rpc/xdr.h>
@@ -27,17 +31,16 @@
 
 /*--------------------------------------------------------------------------*/
 
-#define NULL_FILE   "null"
-
-/*--------------------------------------------------------------------------*/
-
-static int embed_nulls(int, void *, int, RASTER_MAP_TYPE, int, int);
+static int embed_nulls(struct Raster_reader *, void *, int, RASTER_MAP_TYPE,
+		       int, int);
+static int read_data_prefetch(struct Raster_reader *, int, unsigned char *,
+			      int *);
 
 /*--------------------------------------------------------------------------*/
 
-static int compute_window_row(int fd, int row, int *cellRow)
+static int compute_window_row(struct Raster_reader *rd, int row, int *cellRow)
 {
-    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct fileinfo *fcb = rd->fcb;
     double f;
     int r;
 
@@ -65,9 +68,8 @@ static int compute_window_row(int fd, int row, int *cellRow)
 
 /*--------------------------------------------------------------------------*/
 
-static void do_reclass_int(int fd, void *cell, int null_is_zero)
+static void do_reclass_int(struct fileinfo *fcb, void *cell, int null_is_zero)
 {
-    struct fileinfo *fcb = &G__.fileinfo[fd];
     CELL *c = cell;
     CELL *reclass_table = fcb->reclass.table;
     CELL min = fcb->reclass.min;
@@ -98,21 +100,23 @@ static void do_reclass_int(int fd, void *cell, int null_is_zero)
 
 /*--------------------------------------------------------------------------*/
 
-static int read_data_fp_compressed(int fd, int row, unsigned char *data_buf,
-				   int *nbytes)
+static int read_data_fp_compressed(struct Raster_reader *rd, int row,
+				   unsigned char *data_buf, int *nbytes)
 {
-    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct fileinfo *fcb = rd->fcb;
     off_t t1 = fcb->row_ptr[row];
     off_t t2 = fcb->row_ptr[row + 1];
     size_t readamount = t2 - t1;
     size_t bufsize = fcb->cellhd.cols * fcb->nbytes;
 
-    if (lseek(fd, t1, SEEK_SET) < 0)
+    if (lseek(rd->fd, t1, SEEK_SET) < 0)
 	return -1;
 
     *nbytes = fcb->nbytes;
 
-    if ((size_t) G_zlib_read(fd, readamount, data_buf, bufsize) != bufsize)
+    if ((size_t) G_read_compressed(rd->fd, readamount, data_buf, bufsize,
+				   BLOCK_COMPRESSOR(fcb->cellhd.compressed))
+	!= bufsize)
 	return -1;
 
     return 0;
@@ -139,20 +143,20 @@ static void rle_decompress(unsigned char *dst, const unsigned char *src,
     }
 }
 
-static int read_data_compressed(int fd, int row, unsigned char *data_buf,
-				int *nbytes)
+static int read_data_compressed(struct Raster_reader *rd, int row,
+				unsigned char *data_buf, int *nbytes)
 {
-    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct fileinfo *fcb = rd->fcb;
     off_t t1 = fcb->row_ptr[row];
     off_t t2 = fcb->row_ptr[row + 1];
     ssize_t readamount = t2 - t1;
-    unsigned char *cmp = G__.compressed_buf;
+    unsigned char *cmp = rd->compressed_buf;
     int n;
 
-    if (lseek(fd, t1, SEEK_SET) < 0)
+    if (lseek(rd->fd, t1, SEEK_SET) < 0)
 	return -1;
 
-    if (read(fd, cmp, readamount) != readamount)
+    if (read(rd->fd, cmp, readamount) != readamount)
 	return -1;
 
     /* Now decompress the row */
@@ -166,8 +170,9 @@ static int read_data_compressed(int fd, int row, unsigned char *data_buf,
 	n = *nbytes = fcb->nbytes;
 
     if (fcb->cellhd.compressed < 0 || readamount < n * fcb->cellhd.cols) {
-	if (fcb->cellhd.compressed == 2)
-	    G_zlib_expand(cmp, readamount, data_buf, n * fcb->cellhd.cols);
+	if (fcb->cellhd.compressed > 1)
+	    G_expand(cmp, readamount, data_buf, n * fcb->cellhd.cols,
+		     fcb->cellhd.compressed);
 	else
 	    rle_decompress(data_buf, cmp, n, readamount);
     }
@@ -179,18 +184,18 @@ static int read_data_compressed(int fd, int row, unsigned char *data_buf,
 
 /*--------------------------------------------------------------------------*/
 
-static int read_data_uncompressed(int fd, int row, unsigned char *data_buf,
-				  int *nbytes)
+static int read_data_uncompressed(struct Raster_reader *rd, int row,
+				  unsigned char *data_buf, int *nbytes)
 {
-    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct fileinfo *fcb = rd->fcb;
     ssize_t bufsize = fcb->cellhd.cols * fcb->nbytes;
 
     *nbytes = fcb->nbytes;
 
-    if (lseek(fd, (off_t) row * bufsize, SEEK_SET) == -1)
+    if (lseek(rd->fd, (off_t) row * bufsize, SEEK_SET) == -1)
 	return -1;
 
-    if (read(fd, data_buf, bufsize) != bufsize)
+    if (read(rd->fd, data_buf, bufsize) != bufsize)
 	return -1;
 
     return 0;
@@ -199,9 +204,10 @@ static int read_data_uncompressed(int fd, int row, unsigned char *data_buf,
 /*--------------------------------------------------------------------------*/
 
 #ifdef HAVE_GDAL
-static int read_data_gdal(int fd, int row, unsigned char *data_buf, int *nbytes)
+static int read_data_gdal(struct Raster_reader *rd, int row,
+			  unsigned char *data_buf, int *nbytes)
 {
-    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct fileinfo *fcb = rd->fcb;
     CPLErr err;
 
     *nbytes = fcb->nbytes;
@@ -218,31 +224,35 @@ static int read_data_gdal(int fd, int row, unsigned char *data_buf, int *nbytes)
 
 /* Actually read a row of data in */
 
-static int read_data(int fd, int row, unsigned char *data_buf, int *nbytes)
+static int read_data(struct Raster_reader *rd, int row,
+		     unsigned char *data_buf, int *nbytes)
 {
-    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct fileinfo *fcb = rd->fcb;
 
 #ifdef HAVE_GDAL
     if (fcb->gdal)
-	return read_data_gdal(fd, row, data_buf, nbytes);
+	return read_data_gdal(rd, row, data_buf, nbytes);
 #endif
 
+    if (fcb->tile_size)
+	return G__read_tile_row(fcb, rd->fd, row, data_buf, nbytes);
+
     if (!fcb->cellhd.compressed)
-	return read_data_uncompressed(fd, row, data_buf, nbytes);
+	return read_data_uncompressed(rd, row, data_buf, nbytes);
 
     /* map is in compressed form */
 
     if (fcb->map_type == CELL_TYPE)
-	return read_data_compressed(fd, row, data_buf, nbytes);
+	return read_data_compressed(rd, row, data_buf, nbytes);
     else
-	return read_data_fp_compressed(fd, row, data_buf, nbytes);
+	return read_data_fp_compressed(rd, row, data_buf, nbytes);
 }
 
 /*--------------------------------------------------------------------------*/
 
 /* copy cell file data to user buffer translated by window column mapping */
 
-static void cell_values_int(int fd, const unsigned char *data,
+static void cell_values_int(struct fileinfo *fcb, const unsigned char *data,
 			    const COLUMN_MAPPING * cmap, int nbytes,
 			    void *cell, int n)
 {
@@ -289,19 +299,18 @@ static void cell_values_int(int fd, const unsigned char *data,
 
 /*--------------------------------------------------------------------------*/
 
-static void cell_values_float(int fd, const unsigned char *data,
+static void cell_values_float(struct fileinfo *fcb, const unsigned char *data,
 			      const COLUMN_MAPPING * cmap, int nbytes,
 			      void *cell, int n)
 {
-    struct fileinfo *fcb = &G__.fileinfo[fd];
     FCELL *c = cell;
     COLUMN_MAPPING cmapold = 0;
-    XDR *xdrs = &fcb->xdrstream;
+    XDR xdrstream, *xdrs = &xdrstream;
     int i;
 
-    /* xdr stream is initialized to read from */
-    /* fcb->data in 'opencell.c' */
-    xdr_setpos(xdrs, 0);
+    /* data is either fcb->data or the mapped cell file */
+    xdrmem_create(xdrs, (caddr_t) data,
+		  (u_int) (nbytes * fcb->cellhd.cols), XDR_DECODE);
 
     for (i = 0; i < n; i++) {
 	if (!cmap[i]) {
@@ -326,23 +335,25 @@ static void cell_values_float(int fd, const unsigned char *data,
 
 	cmapold--;
     }
+
+    xdr_destroy(xdrs);
 }
 
 /*--------------------------------------------------------------------------*/
 
-static void cell_values_double(int fd, const unsigned char *data,
+static void cell_values_double(struct fileinfo *fcb,
+			       const unsigned char *data,
 			       const COLUMN_MAPPING * cmap, int nbytes,
 			       void *cell, int n)
 {
-    struct fileinfo *fcb = &G__.fileinfo[fd];
     DCELL *c = cell;
     COLUMN_MAPPING cmapold = 0;
-    XDR *xdrs = &fcb->xdrstream;
+    XDR xdrstream, *xdrs = &xdrstream;
     int i;
 
-    /* xdr stream is initialized to read from */
-    /* fcb->data in 'opencell.c' */
-    xdr_setpos(xdrs, 0);
+    /* data is either fcb->data or the mapped cell file */
+    xdrmem_create(xdrs, (caddr_t) data,
+		  (u_int) (nbytes * fcb->cellhd.cols), XDR_DECODE);
 
     for (i = 0; i < n; i++) {
 	if (!cmap[i]) {
@@ -367,6 +378,8 @@ static void cell_values_double(int fd, const unsigned char *data,
 
 	cmapold--;
     }
+
+    xdr_destroy(xdrs);
 }
 
 /*--------------------------------------------------------------------------*/
@@ -377,11 +390,10 @@ static void cell_values_double(int fd, const unsigned char *data,
 
 /*--------------------------------------------------------------------------*/
 
-static void gdal_values_int(int fd, const unsigned char *data,
+static void gdal_values_int(struct fileinfo *fcb, const unsigned char *data,
 			    const COLUMN_MAPPING *cmap, int nbytes,
 			    CELL *cell, int n)
 {
-    struct fileinfo *fcb = &G__.fileinfo[fd];
     const unsigned char *d;
     COLUMN_MAPPING cmapold = 0;
     int i;
@@ -417,7 +429,7 @@ static void gdal_values_int(int fd, const unsigned char *data,
 
 /*--------------------------------------------------------------------------*/
 
-static void gdal_values_float(int fd, const float *data,
+static void gdal_values_float(struct fileinfo *fcb, const float *data,
 			      const COLUMN_MAPPING *cmap, int nbytes,
 			      FCELL *cell, int n)
 {
@@ -443,7 +455,7 @@ static void gdal_values_float(int fd, const float *data,
 
 /*--------------------------------------------------------------------------*/
 
-static void gdal_values_double(int fd, const double *data,
+static void gdal_values_double(struct fileinfo *fcb, const double *data,
 			       const COLUMN_MAPPING *cmap, int nbytes,
 			       DCELL *cell, int n)
 {
@@ -475,17 +487,18 @@ static void gdal_values_double(int fd, const double *data,
 
 /* transfer_to_cell_XY takes bytes from fcb->data, converts these bytes with
    the appropriate procedure (e.g. XDR or byte reordering) into type X 
-   values which are put into array G__.work_buf.  
-   finally the values in G__.work_buf are converted into 
+   values which are put into the reader's work_buf (G__.work_buf for
+   the descriptor based functions).
+   finally the values in work_buf are converted into 
    type Y and put into 'cell'.
    if type X == type Y the intermediate step of storing the values in 
-   G__.work_buf might be ommited. check the appropriate function for XY to
+   work_buf might be ommited. check the appropriate function for XY to
    determine the procedure of conversion. 
  */
 
 /*--------------------------------------------------------------------------*/
 
-static void transfer_to_cell_XX(int fd, void *cell)
+static void transfer_to_cell_XX(struct Raster_reader *rd, void *cell)
 {
     static void (*cell_values_type[3]) () = {
     cell_values_int, cell_values_float, cell_values_double};
@@ -493,115 +506,146 @@ static void transfer_to_cell_XX(int fd, void *cell)
     static void (*gdal_values_type[3]) () = {
     gdal_values_int, gdal_values_float, gdal_values_double};
 #endif
-    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct fileinfo *fcb = rd->fcb;
+    const unsigned char *data = fcb->data;
+
+    if (fcb->map)
+	data = fcb->map + (off_t) fcb->cur_row * fcb->cellhd.cols * fcb->nbytes;
 
 #ifdef HAVE_GDAL
     if (fcb->gdal)
-    (gdal_values_type[fcb->map_type]) (fd, fcb->data, fcb->col_map,
+    (gdal_values_type[fcb->map_type]) (fcb, data, fcb->col_map,
 				       fcb->cur_nbytes, cell,
 				       G__.window.cols);
     else
 #endif
-    (cell_values_type[fcb->map_type]) (fd, fcb->data, fcb->col_map,
+    (cell_values_type[fcb->map_type]) (fcb, data, fcb->col_map,
 				       fcb->cur_nbytes, cell,
 				       G__.window.cols);
 }
 
 /*--------------------------------------------------------------------------*/
 
-static void transfer_to_cell_fi(int fd, void *cell)
+static void transfer_to_cell_fi(struct Raster_reader *rd, void *cell)
 {
-    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct fileinfo *fcb = rd->fcb;
     int i;
 
-    transfer_to_cell_XX(fd, G__.work_buf);
+    transfer_to_cell_XX(rd, rd->work_buf);
 
     for (i = 0; i < G__.window.cols; i++)
 	((CELL *) cell)[i] = (fcb->col_map[i] == 0)
 	    ? 0
 	    : G_quant_get_cell_value(&fcb->quant,
-				     ((FCELL *) G__.work_buf)[i]);
+				     ((FCELL *) rd->work_buf)[i]);
 }
 
-static void transfer_to_cell_di(int fd, void *cell)
+static void transfer_to_cell_di(struct Raster_reader *rd, void *cell)
 {
-    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct fileinfo *fcb = rd->fcb;
     int i;
 
-    transfer_to_cell_XX(fd, G__.work_buf);
+    transfer_to_cell_XX(rd, rd->work_buf);
 
     for (i = 0; i < G__.window.cols; i++)
 	((CELL *) cell)[i] = (fcb->col_map[i] == 0)
 	    ? 0
 	    : G_quant_get_cell_value(&fcb->quant,
-				     ((DCELL *) G__.work_buf)[i]);
+				     ((DCELL *) rd->work_buf)[i]);
 }
 
 /*--------------------------------------------------------------------------*/
 
-static void transfer_to_cell_if(int fd, void *cell)
+static void transfer_to_cell_if(struct Raster_reader *rd, void *cell)
 {
     int i;
 
-    transfer_to_cell_XX(fd, G__.work_buf);
+    transfer_to_cell_XX(rd, rd->work_buf);
 
     for (i = 0; i < G__.window.cols; i++)
-	((FCELL *) cell)[i] = ((CELL *) G__.work_buf)[i];
+	((FCELL *) cell)[i] = ((CELL *) rd->work_buf)[i];
 }
 
-static void transfer_to_cell_df(int fd, void *cell)
+static void transfer_to_cell_df(struct Raster_reader *rd, void *cell)
 {
     int i;
 
-    transfer_to_cell_XX(fd, G__.work_buf);
+    transfer_to_cell_XX(rd, rd->work_buf);
 
     for (i = 0; i < G__.window.cols; i++)
-	((FCELL *) cell)[i] = ((DCELL *) G__.work_buf)[i];
+	((FCELL *) cell)[i] = ((DCELL *) rd->work_buf)[i];
 }
 
 /*--------------------------------------------------------------------------*/
 
-static void transfer_to_cell_id(int fd, void *cell)
+static void transfer_to_cell_id(struct Raster_reader *rd, void *cell)
 {
     int i;
 
-    transfer_to_cell_XX(fd, G__.work_buf);
+    transfer_to_cell_XX(rd, rd->work_buf);
 
     for (i = 0; i < G__.window.cols; i++)
-	((DCELL *) cell)[i] = ((CELL *) G__.work_buf)[i];
+	((DCELL *) cell)[i] = ((CELL *) rd->work_buf)[i];
 }
 
-static void transfer_to_cell_fd(int fd, void *cell)
+static void transfer_to_cell_fd(struct Raster_reader *rd, void *cell)
 {
     int i;
 
-    transfer_to_cell_XX(fd, G__.work_buf);
+    transfer_to_cell_XX(rd, rd->work_buf);
 
     for (i = 0; i < G__.window.cols; i++)
-	((DCELL *) cell)[i] = ((FCELL *) G__.work_buf)[i];
+	((DCELL *) cell)[i] = ((FCELL *) rd->work_buf)[i];
 }
 
 /*--------------------------------------------------------------------------*/
 
 /*--------------------------------------------------------------------------*/
 
+/* set up a decoding context which works on the state and the
+   library buffers shared by everybody reading through descriptor fd */
+
+static struct Raster_reader *fd_reader(int fd, struct Raster_reader *rd)
+{
+    rd->fd = fd;
+    rd->owned = 0;
+    rd->null_fd = -1;
+    rd->fcb = &G__.fileinfo[fd];
+    rd->compressed_buf = G__.compressed_buf;
+    rd->work_buf = G__.work_buf;
+    rd->null_buf = G__.null_buf;
+    rd->temp_buf = G__.temp_buf;
+    rd->mask_buf = G__.mask_buf;
+    rd->mask = NULL;
+
+    return rd;
+}
+
+static int has_mask(const struct Raster_reader *rd)
+{
+    if (rd->owned)
+	return rd->mask != NULL;
+
+    return G__.auto_mask > 0;
+}
+
 /*--------------------------------------------------------------------------*/
 /*
  *   works for all map types and doesn't consider
  *   null row corresponding to the requested row 
  */
-static int get_map_row_nomask(int fd, void *rast, int row,
+static int get_map_row_nomask(struct Raster_reader *rd, void *rast, int row,
 			      RASTER_MAP_TYPE data_type)
 {
     static void (*transfer_to_cell_FtypeOtype[3][3]) () = { {
     transfer_to_cell_XX, transfer_to_cell_if, transfer_to_cell_id}, {
     transfer_to_cell_fi, transfer_to_cell_XX, transfer_to_cell_fd}, {
     transfer_to_cell_di, transfer_to_cell_df, transfer_to_cell_XX}};
-    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct fileinfo *fcb = rd->fcb;
     int r;
     int rowStatus;
 
-    rowStatus = compute_window_row(fd, row, &r);
+    rowStatus = compute_window_row(rd, row, &r);
 
     if (rowStatus <= 0) {
 	fcb->cur_row = -1;
@@ -613,7 +657,13 @@ static int get_map_row_nomask(int fd, void *rast, int row,
     if (r != fcb->cur_row) {
 	fcb->cur_row = r;
 
-	if (read_data(fd, fcb->cur_row, fcb->data, &fcb->cur_nbytes) < 0) {
+	/* mapped rows are decoded in place */
+	if (fcb->map)
+	    fcb->cur_nbytes = fcb->nbytes;
+	else if ((fcb->prefetch
+	     ? read_data_prefetch(rd, fcb->cur_row, fcb->data,
+				  &fcb->cur_nbytes)
+	     : read_data(rd, fcb->cur_row, fcb->data, &fcb->cur_nbytes)) < 0) {
 	    G_zero_raster_buf(rast, data_type);
 
 	    if (!fcb->io_error) {
@@ -630,24 +680,24 @@ static int get_map_row_nomask(int fd, void *rast, int row,
 	}
     }
 
-    (transfer_to_cell_FtypeOtype[fcb->map_type][data_type]) (fd, rast);
+    (transfer_to_cell_FtypeOtype[fcb->map_type][data_type]) (rd, rast);
 
     return 1;
 }
 
 /*--------------------------------------------------------------------------*/
 
-static int get_map_row_no_reclass(int fd, void *rast, int row,
-				  RASTER_MAP_TYPE data_type, int null_is_zero,
-				  int with_mask)
+static int get_map_row_no_reclass(struct Raster_reader *rd, void *rast,
+				  int row, RASTER_MAP_TYPE data_type,
+				  int null_is_zero, int with_mask)
 {
     int stat;
 
-    stat = get_map_row_nomask(fd, rast, row, data_type);
+    stat = get_map_row_nomask(rd, rast, row, data_type);
     if (stat < 0)
 	return stat;
 
-    stat = embed_nulls(fd, rast, row, data_type, null_is_zero, with_mask);
+    stat = embed_nulls(rd, rast, row, data_type, null_is_zero, with_mask);
     if (stat < 0)
 	return stat;
 
@@ -656,10 +706,11 @@ static int get_map_row_no_reclass(int fd, void *rast, int row,
 
 /*--------------------------------------------------------------------------*/
 
-static int get_map_row(int fd, void *rast, int row, RASTER_MAP_TYPE data_type,
-		       int null_is_zero, int with_mask)
+static int get_map_row(struct Raster_reader *rd, void *rast, int row,
+		       RASTER_MAP_TYPE data_type, int null_is_zero,
+		       int with_mask)
 {
-    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct fileinfo *fcb = rd->fcb;
     int size = G_raster_size(data_type);
     void *buf;
     int type;
@@ -667,7 +718,7 @@ static int get_map_row(int fd, void *rast, int row, RASTER_MAP_TYPE data_type,
     int i;
 
     if (fcb->reclass_flag && data_type != CELL_TYPE) {
-	buf = G__.temp_buf;
+	buf = rd->temp_buf;
 	type = CELL_TYPE;
     }
     else {
@@ -676,7 +727,7 @@ static int get_map_row(int fd, void *rast, int row, RASTER_MAP_TYPE data_type,
     }
 
     stat =
-	get_map_row_no_reclass(fd, buf, row, type, null_is_zero, with_mask);
+	get_map_row_no_reclass(rd, buf, row, type, null_is_zero, with_mask);
     if (stat < 0)
 	return stat;
 
@@ -686,13 +737,13 @@ static int get_map_row(int fd, void *rast, int row, RASTER_MAP_TYPE data_type,
     /* if the map is reclass table, get and
        reclass CELL row and copy results to needed type  */
 
-    do_reclass_int(fd, buf, null_is_zero);
+    do_reclass_int(fcb, buf, null_is_zero);
 
     if (data_type == CELL_TYPE)
 	return 1;
 
     for (i = 0; i < G__.window.cols; i++) {
-	G_set_raster_value_c(rast, G__.temp_buf[i], data_type);
+	G_set_raster_value_c(rast, rd->temp_buf[i], data_type);
 	rast = G_incr_void_ptr(rast, size);
     }
 
@@ -739,7 +790,9 @@ static int get_map_row(int fd, void *rast, int row, RASTER_MAP_TYPE data_type,
 
 int G_get_map_row_nomask(int fd, CELL * buf, int row)
 {
-    return get_map_row(fd, buf, row, CELL_TYPE, 1, 0);
+    struct Raster_reader rd;
+
+    return get_map_row(fd_reader(fd, &rd), buf, row, CELL_TYPE, 1, 0);
 }
 
 /*!
@@ -760,7 +813,9 @@ int G_get_map_row_nomask(int fd, CELL * buf, int row)
 int G_get_raster_row_nomask(int fd, void *buf, int row,
 			    RASTER_MAP_TYPE data_type)
 {
-    return get_map_row(fd, buf, row, data_type, 0, 0);
+    struct Raster_reader rd;
+
+    return get_map_row(fd_reader(fd, &rd), buf, row, data_type, 0, 0);
 }
 
 /*!
@@ -847,7 +902,9 @@ int G_get_d_raster_row_nomask(int fd, DCELL * buf, int row)
 
 int G_get_map_row(int fd, CELL * buf, int row)
 {
-    return get_map_row(fd, buf, row, CELL_TYPE, 1, 1);
+    struct Raster_reader rd;
+
+    return get_map_row(fd_reader(fd, &rd), buf, row, CELL_TYPE, 1, 1);
 }
 
 /*!
@@ -895,7 +952,9 @@ int G_get_map_row(int fd, CELL * buf, int row)
 
 int G_get_raster_row(int fd, void *buf, int row, RASTER_MAP_TYPE data_type)
 {
-    return get_map_row(fd, buf, row, data_type, 0, 1);
+    struct Raster_reader rd;
+
+    return get_map_row(fd_reader(fd, &rd), buf, row, data_type, 0, 1);
 }
 
 /*!
@@ -968,55 +1027,118 @@ int G_get_d_raster_row(int fd, DCELL * buf, int row)
     return G_get_raster_row(fd, buf, row, DCELL_TYPE);
 }
 
-/*--------------------------------------------------------------------------*/
+/*
+ * Uncompressed cell files are mapped into memory when opened, rows are
+ * then decoded straight from the mapping. If the file cannot be
+ * mapped, rows are read as usual.
+ */
 
-/*--------------------------------------------------------------------------*/
+int G__map_cell_file(int fd)
+{
+    struct fileinfo *fcb = &G__.fileinfo[fd];
 
-/*--------------------------------------------------------------------------*/
+    fcb->map = NULL;
+    fcb->map_size = 0;
+
+#ifndef __MINGW32__
+    {
+	off_t size = (off_t) fcb->cellhd.rows * fcb->cellhd.cols * fcb->nbytes;
+	struct stat st;
+	void *p;
+
+	if (fcb->gdal || fcb->cellhd.compressed || size <= 0 ||
+	    size != (off_t) (size_t) size)
+	    return 0;
 
-static int open_null_read(int fd)
+	/* short files are left to read() which reports the bad rows */
+	if (fstat(fd, &st) < 0 || st.st_size < size)
+	    return 0;
+
+	p = mmap(NULL, (size_t) size, PROT_READ, MAP_SHARED, fd, (off_t) 0);
+	if (p == MAP_FAILED)
+	    return 0;
+
+	fcb->map = p;
+	fcb->map_size = (size_t) size;
+    }
+#endif
+
+    return fcb->map != NULL;
+}
+
+void G__unmap_cell_file(int fd)
 {
     struct fileinfo *fcb = &G__.fileinfo[fd];
-    char *name, *mapset, *dummy;
-    int null_fd;
 
-    if (fcb->null_file_exists == 0)
-	return -1;
+#ifndef __MINGW32__
+    if (fcb->map)
+	munmap(fcb->map, fcb->map_size);
+#endif
 
-    if (fcb->reclass_flag) {
-	name = fcb->reclass.name;
-	mapset = fcb->reclass.mapset;
-    }
-    else {
-	name = fcb->name;
-	mapset = fcb->mapset;
-    }
+    fcb->map = NULL;
+    fcb->map_size = 0;
+}
 
-    dummy = G_find_file_misc("cell_misc", NULL_FILE, name, mapset);
+/*!
+ * \brief Get pointer to the stored cells of a raster row
+ *
+ * Uncompressed raster maps are mapped into memory when they are
+ * opened. If the current region matches the cell header of such a map
+ * and the map is not a reclass, this returns a pointer to the cells of
+ * <em>row</em> right in the mapping, without any system call or copy.
+ * The cells are in the portable format of the cell file, <em>nbytes</em>
+ * each: big-endian integers with the sign in the top bit of the first
+ * byte for CELL maps, XDR floats or doubles for FCELL and DCELL maps.
+ * No null values or MASK are applied; see G_get_null_value_row().
+ *
+ * The pointer stays valid until the map is closed.
+ *
+ * \param fd file descriptor for the opened raster map
+ * \param row data row desired
+ * \param[out] nbytes bytes per cell
+ *
+ * \return pointer to the row
+ * \return NULL if the row is not directly available; use
+ * G_get_raster_row() instead
+ */
+const void *G_get_raster_row_ptr(int fd, int row, int *nbytes)
+{
+    struct fileinfo *fcb;
+    const struct Cell_head *w = &G__.window;
 
-    if (!dummy) {
-	/* G_warning("unable to find [%s]",path); */
-	fcb->null_file_exists = 0;
-	return -1;
-    }
+    if (fd < 0 || fd >= G__.fileinfo_count)
+	return NULL;
 
-    null_fd = G_open_old_misc("cell_misc", NULL_FILE, name, mapset);
-    if (null_fd < 0)
-	return -1;
+    fcb = &G__.fileinfo[fd];
+
+    if (fcb->open_mode != OPEN_OLD || !fcb->map || fcb->reclass_flag)
+	return NULL;
 
-    fcb->null_file_exists = 1;
+    if (w->rows != fcb->cellhd.rows || w->cols != fcb->cellhd.cols ||
+	w->north != fcb->cellhd.north || w->west != fcb->cellhd.west ||
+	w->ns_res != fcb->cellhd.ns_res || w->ew_res != fcb->cellhd.ew_res)
+	return NULL;
+
+    if (row < 0 || row >= fcb->cellhd.rows)
+	return NULL;
+
+    *nbytes = fcb->nbytes;
 
-    return null_fd;
+    return fcb->map + (off_t) row * fcb->cellhd.cols * fcb->nbytes;
 }
 
+/*--------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------*/
+
 static int read_null_bits(int null_fd, unsigned char *flags, int row,
-			  int cols, int fd)
+			  int cols, struct Raster_reader *rd)
 {
-    off_t offset;
-    ssize_t size;
     int R;
 
-    if (compute_window_row(fd, row, &R) <= 0) {
+    if (compute_window_row(rd, row, &R) <= 0) {
 	G__init_null_bits(flags, cols);
 	return 1;
     }
@@ -1024,15 +1146,7 @@ static int read_null_bits(int null_fd, unsigned char *flags, int row,
     if (null_fd < 0)
 	return -1;
 
-    size = G__null_bitstream_size(cols);
-    offset = (off_t) size *R;
-
-    if (lseek(null_fd, offset, SEEK_SET) < 0) {
-	G_warning(_("Error reading null row %d"), R);
-	return -1;
-    }
-
-    if (read(null_fd, flags, size) != size) {
+    if (G__read_null_row(rd->fcb, null_fd, R, flags) < 0) {
 	G_warning(_("Error reading null row %d"), R);
 	return -1;
     }
@@ -1040,9 +1154,10 @@ static int read_null_bits(int null_fd, unsigned char *flags, int row,
     return 1;
 }
 
-static void get_null_value_row_nomask(int fd, char *flags, int row)
+static void get_null_value_row_nomask(struct Raster_reader *rd, char *flags,
+				      int row)
 {
-    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct fileinfo *fcb = rd->fcb;
     int i, j, null_fd;
 
     if (row > G__.window.rows || row < 0) {
@@ -1060,7 +1175,8 @@ static void get_null_value_row_nomask(int fd, char *flags, int row)
 
 	fcb->min_null_row = (row / NULL_ROWS_INMEM) * NULL_ROWS_INMEM;
 
-	null_fd = open_null_read(fd);
+	/* readers keep their null file open, see G_open_raster_reader() */
+	null_fd = rd->owned ? rd->null_fd : G__open_null_read(fcb);
 
 	for (i = 0; i < NULL_ROWS_INMEM; i++) {
 	    /* G__.window.rows doesn't have to be a multiple of NULL_ROWS_INMEM */
@@ -1069,15 +1185,15 @@ static void get_null_value_row_nomask(int fd, char *flags, int row)
 
 	    if (read_null_bits(null_fd, fcb->null_work_buf,
 			       i + fcb->min_null_row, fcb->cellhd.cols,
-			       fd) < 0) {
+			       rd) < 0) {
 		if (fcb->map_type == CELL_TYPE) {
 		    /*
 		       If can't read null row, assume  that all map 0's are nulls 
-		       use allocated G__.mask_buf to read map row */
-		    get_map_row_nomask(fd, (void *)G__.mask_buf,
+		       use allocated mask_buf to read map row */
+		    get_map_row_nomask(rd, (void *)rd->mask_buf,
 				       i + fcb->min_null_row, CELL_TYPE);
 		    for (j = 0; j < G__.window.cols; j++) {
-			if (G__.mask_buf[j] == 0)
+			if (rd->mask_buf[j] == 0)
 			    flags[j] = 1;
 			else
 			    flags[j] = 0;
@@ -1118,7 +1234,7 @@ static void get_null_value_row_nomask(int fd, char *flags, int row)
 
 	}			/* for loop */
 
-	if (null_fd > 0)
+	if (null_fd > 0 && !rd->owned)
 	    close(null_fd);
     }				/* row is not in memory */
 
@@ -1132,13 +1248,14 @@ static void get_null_value_row_nomask(int fd, char *flags, int row)
 
 #ifdef HAVE_GDAL
 
-static void get_null_value_row_gdal(int fd, char *flags, int row)
+static void get_null_value_row_gdal(struct Raster_reader *rd, char *flags,
+				    int row)
 {
-    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct fileinfo *fcb = rd->fcb;
     DCELL *tmp_buf = G_allocate_d_raster_buf();
     int i;
 
-    if (get_map_row_nomask(fd, tmp_buf, row, DCELL_TYPE) <= 0) {
+    if (get_map_row_nomask(rd, tmp_buf, row, DCELL_TYPE) <= 0) {
 	memset(flags, 1, G__.window.cols);
 	G_free(tmp_buf);
 	return;
@@ -1158,56 +1275,61 @@ static void get_null_value_row_gdal(int fd, char *flags, int row)
 
 /*--------------------------------------------------------------------------*/
 
-static void embed_mask(char *flags, int row)
+static void embed_mask(struct Raster_reader *rd, char *flags, int row)
 {
+    struct Raster_reader mask_rd, *mask;
     int i;
 
-    if (G__.auto_mask <= 0)
+    if (!has_mask(rd))
 	return;
 
-    if (get_map_row_nomask(G__.mask_fd, G__.mask_buf, row, CELL_TYPE) < 0)
+    mask = rd->owned ? rd->mask : fd_reader(G__.mask_fd, &mask_rd);
+
+    if (get_map_row_nomask(mask, rd->mask_buf, row, CELL_TYPE) < 0)
 	return;
 
-    if (G__.fileinfo[G__.mask_fd].reclass_flag)
-	do_reclass_int(G__.mask_fd, G__.mask_buf, 1);
+    if (mask->fcb->reclass_flag)
+	do_reclass_int(mask->fcb, rd->mask_buf, 1);
 
     for (i = 0; i < G__.window.cols; i++)
-	if (G__.mask_buf[i] == 0)
+	if (rd->mask_buf[i] == 0)
 	    flags[i] = 1;
 }
 
-static void get_null_value_row(int fd, char *flags, int row, int with_mask)
+static void get_null_value_row(struct Raster_reader *rd, char *flags,
+			       int row, int with_mask)
 {
 #ifdef HAVE_GDAL
-    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct fileinfo *fcb = rd->fcb;
     if (fcb->gdal)
-	get_null_value_row_gdal(fd, flags, row);
+	get_null_value_row_gdal(rd, flags, row);
     else
 #endif
-    get_null_value_row_nomask(fd, flags, row);
+    get_null_value_row_nomask(rd, flags, row);
 
     if (with_mask)
-	embed_mask(flags, row);
+	embed_mask(rd, flags, row);
 }
 
-static int embed_nulls(int fd, void *buf, int row, RASTER_MAP_TYPE map_type,
-		       int null_is_zero, int with_mask)
+static int embed_nulls(struct Raster_reader *rd, void *buf, int row,
+		       RASTER_MAP_TYPE map_type, int null_is_zero,
+		       int with_mask)
 {
-    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct fileinfo *fcb = rd->fcb;
     int i;
 
     /* this is because without null file the nulls can be only due to 0's
        in data row or mask */
     if (null_is_zero && !fcb->null_file_exists
-	&& (G__.auto_mask <= 0 || !with_mask))
+	&& (!has_mask(rd) || !with_mask))
 	return 1;
 
-    get_null_value_row(fd, G__.null_buf, row, with_mask);
+    get_null_value_row(rd, rd->null_buf, row, with_mask);
 
     for (i = 0; i < G__.window.cols; i++) {
 	/* also check for nulls which might be already embedded by quant
 	   rules in case of fp map. */
-	if (G__.null_buf[i] || G_is_null_value(buf, map_type)) {
+	if (rd->null_buf[i] || G_is_null_value(buf, map_type)) {
 	    /* G__set_[f/d]_null_value() sets it to 0 is the embedded mode
 	       is not set and calls G_set_[f/d]_null_value() otherwise */
 	    G__set_null_value(buf, 1, null_is_zero, map_type);
@@ -1243,9 +1365,10 @@ static int embed_nulls(int fd, void *buf, int row, RASTER_MAP_TYPE map_type,
 int G_get_null_value_row(int fd, char *flags, int row)
 {
     struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct Raster_reader rd;
 
     if (!fcb->reclass_flag)
-	get_null_value_row(fd, flags, row, 1);
+	get_null_value_row(fd_reader(fd, &rd), flags, row, 1);
     else {
 	CELL *buf = G_allocate_c_raster_buf();
 	int i;
@@ -1259,3 +1382,399 @@ int G_get_null_value_row(int fd, char *flags, int row)
 
     return 1;
 }
+
+/*--------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------*/
+
+static struct Raster_reader *new_reader(int fd)
+{
+    struct fileinfo *src = &G__.fileinfo[fd];
+    struct Raster_reader *rd;
+    struct fileinfo *fcb;
+    const char *name, *mapset;
+    int data_fd;
+    int i;
+
+    if (src->gdal) {
+	G_warning(_("Raster map <%s@%s> is a GDAL link, unable to create a reader"),
+		  src->name, src->mapset);
+	return NULL;
+    }
+
+    if (src->reclass_flag) {
+	name = src->reclass.name;
+	mapset = src->reclass.mapset;
+    }
+    else {
+	name = src->name;
+	mapset = src->mapset;
+    }
+
+    data_fd = G_open_old(src->map_type == CELL_TYPE ? "cell" : "fcell",
+			 name, mapset);
+    if (data_fd < 0) {
+	G_warning(_("Unable to open raster map <%s@%s>"), name, mapset);
+	return NULL;
+    }
+
+    /* make sure nothing is initialized lazily while reading */
+    if (src->map_type != CELL_TYPE)
+	G_quant_get_cell_value(&src->quant, 0.0);
+
+    rd = G_malloc(sizeof(struct Raster_reader));
+    rd->fd = data_fd;
+    rd->owned = 1;
+    rd->mask = NULL;
+
+    rd->fcb = fcb = G_malloc(sizeof(struct fileinfo));
+    G_copy(fcb, src, sizeof(struct fileinfo));
+
+    fcb->cur_row = -1;
+    fcb->io_error = 0;
+    fcb->prefetch = NULL;
+    fcb->tiles = NULL;
+    fcb->null_row_ptr = NULL;
+    fcb->data = (unsigned char *)G_calloc(fcb->cellhd.cols, fcb->nbytes);
+
+    for (i = 0; i < NULL_ROWS_INMEM; i++)
+	fcb->NULL_ROWS[i] = G__allocate_null_bits(G__.window.cols);
+    fcb->null_work_buf = G__allocate_null_bits(fcb->cellhd.cols);
+    fcb->min_null_row = (-1) * NULL_ROWS_INMEM;
+    rd->null_fd = G__open_null_read(fcb);
+
+    rd->compressed_buf = NULL;
+    if (fcb->cellhd.compressed && fcb->map_type == CELL_TYPE)
+	rd->compressed_buf =
+	    G_malloc(fcb->cellhd.cols * (sizeof(CELL) + 1) + 1);
+    rd->work_buf = G_malloc(G__.window.cols * (sizeof(DCELL) + 1) + 1);
+    rd->null_buf = G_malloc(G__.window.cols + 1);
+    rd->temp_buf = G_malloc((G__.window.cols + 1) * sizeof(CELL));
+    rd->mask_buf = G_malloc((G__.window.cols + 1) * sizeof(CELL));
+
+    return rd;
+}
+
+/*!
+ * \brief Create a private reader for an open raster map
+ *
+ * All G_get_raster_row() family functions keep their decoding state
+ * (current row, null row cache, work buffers and file offset) in
+ * library globals shared by everybody using <em>fd</em>. A reader
+ * owns a copy of that state, its own file descriptors and its own
+ * buffers, so that rows can be read and decompressed through several
+ * readers at the same time, e.g. one reader per thread. The
+ * read-only parts of the map (row pointers, column mapping, reclass
+ * table and quantization rules) are shared with <em>fd</em>.
+ *
+ * The reader must be created and closed by the thread which opened
+ * <em>fd</em>, and it must be closed before <em>fd</em> is closed or
+ * the region is changed. The MASK active at creation time is applied
+ * by G_reader_get_raster_row(). Maps linked through GDAL are not
+ * supported.
+ *
+ * \param fd file descriptor of a raster map opened for reading
+ *
+ * \return pointer to the reader
+ * \return NULL on error
+ */
+struct Raster_reader *G_open_raster_reader(int fd)
+{
+    struct Raster_reader *rd;
+
+    if (fd < 0 || fd >= G__.fileinfo_count ||
+	G__.fileinfo[fd].open_mode != OPEN_OLD) {
+	G_warning(_("G_open_raster_reader: file descriptor %d is not open for reading"),
+		  fd);
+	return NULL;
+    }
+
+    G__init_null_patterns();
+
+    if ((rd = new_reader(fd)) == NULL)
+	return NULL;
+
+    if (G__.auto_mask > 0 && (rd->mask = new_reader(G__.mask_fd)) == NULL) {
+	G_close_raster_reader(rd);
+	return NULL;
+    }
+
+    return rd;
+}
+
+/*!
+ * \brief Close a raster map reader
+ *
+ * Releases the file descriptors and buffers of a reader created by
+ * G_open_raster_reader(). The map itself stays open.
+ *
+ * \param rd reader
+ */
+void G_close_raster_reader(struct Raster_reader *rd)
+{
+    struct fileinfo *fcb = rd->fcb;
+    int i;
+
+    if (rd->mask)
+	G_close_raster_reader(rd->mask);
+
+    for (i = 0; i < NULL_ROWS_INMEM; i++)
+	G_free(fcb->NULL_ROWS[i]);
+    G_free(fcb->null_work_buf);
+    G_free(fcb->data);
+    G__free_tile_cache(fcb);
+    if (fcb->null_row_ptr)
+	G_free(fcb->null_row_ptr);
+    G_free(fcb);
+
+    if (rd->null_fd > 0)
+	close(rd->null_fd);
+    close(rd->fd);
+
+    if (rd->compressed_buf)
+	G_free(rd->compressed_buf);
+    G_free(rd->work_buf);
+    G_free(rd->null_buf);
+    G_free(rd->temp_buf);
+    G_free(rd->mask_buf);
+    G_free(rd);
+}
+
+/*!
+ * \brief Get raster row through a reader
+ *
+ * Same as G_get_raster_row() except that all state is taken from
+ * <em>rd</em>. Different readers may be used concurrently.
+ *
+ * \param rd reader created by G_open_raster_reader()
+ * \param buf buffer for the row to be placed into
+ * \param row data row desired
+ * \param data_type data type
+ *
+ * \return 1 on success
+ * \return 0 row requested not within window
+ * \return -1 on error
+ */
+int G_reader_get_raster_row(struct Raster_reader *rd, void *buf, int row,
+			    RASTER_MAP_TYPE data_type)
+{
+    return get_map_row(rd, buf, row, data_type, 0, 1);
+}
+
+/*!
+ * \brief Get raster row through a reader without masking
+ *
+ * Same as G_get_raster_row_nomask() except that all state is taken
+ * from <em>rd</em>.
+ *
+ * \param rd reader created by G_open_raster_reader()
+ * \param buf buffer for the row to be placed into
+ * \param row data row desired
+ * \param data_type data type
+ *
+ * \return 1 on success
+ * \return 0 row requested not within window
+ * \return -1 on error
+ */
+int G_reader_get_raster_row_nomask(struct Raster_reader *rd, void *buf,
+				   int row, RASTER_MAP_TYPE data_type)
+{
+    return get_map_row(rd, buf, row, data_type, 0, 0);
+}
+
+/*--------------------------------------------------------------------------*/
+
+/*
+ * Read-ahead for sequential scans: while the caller works on one batch
+ * of data rows, a worker thread reads and decompresses the next batch
+ * through a private reader. Batches follow the stride of the last two
+ * requests, so that scans at a coarser resolution than the map only
+ * read the rows actually needed.
+ */
+
+struct row_batch
+{
+    struct Raster_reader *rd;	/* private reader used by the worker */
+    int first;			/* data rows first + i * step,       */
+    int step;			/*   0 <= i < count                  */
+    int count;
+    int row_size;
+    unsigned char *data;	/* count rows of row_size bytes      */
+    int *nbytes;
+    int *stat;
+};
+
+struct row_prefetch
+{
+    int nrows;			/* rows per batch                    */
+    int last;			/* last data row requested           */
+    int cur;			/* batch[cur] is consumed, the other */
+    struct row_batch batch[2];	/*   one may be filled by a worker   */
+    void *ref;			/* worker task filling a batch       */
+};
+
+static void fill_batch(void *closure)
+{
+    struct row_batch *b = closure;
+    int i;
+
+    for (i = 0; i < b->count; i++)
+	b->stat[i] = read_data(b->rd, b->first + i * b->step,
+			       b->data + i * b->row_size, &b->nbytes[i]);
+}
+
+static int find_row(const struct row_batch *b, int row)
+{
+    int i;
+
+    if (row < b->first || (row - b->first) % b->step != 0)
+	return -1;
+
+    i = (row - b->first) / b->step;
+
+    return i < b->count ? i : -1;
+}
+
+/* start filling the batch not in use by the caller */
+static void start_batch(struct row_prefetch *p, int first, int step)
+{
+    struct row_batch *b = &p->batch[!p->cur];
+    int rows = b->rd->fcb->cellhd.rows;
+
+    b->first = first;
+    b->step = step;
+    b->count = 0;
+
+    while (b->count < p->nrows && first + b->count * step < rows)
+	b->count++;
+
+    if (b->count > 0)
+	G_begin_execute(fill_batch, b, &p->ref, 0);
+}
+
+static int read_data_prefetch(struct Raster_reader *rd, int row,
+			      unsigned char *data_buf, int *nbytes)
+{
+    struct row_prefetch *p = rd->fcb->prefetch;
+    int step = p->last >= 0 && row > p->last ? row - p->last : 1;
+    struct row_batch *b;
+    int i;
+
+    p->last = row;
+
+    b = &p->batch[p->cur];
+    if ((i = find_row(b, row)) < 0) {
+	G_end_execute(&p->ref);
+
+	b = &p->batch[!p->cur];
+	if ((i = find_row(b, row)) < 0) {
+	    /* not sequential, read the row and guess again */
+	    p->batch[0].count = p->batch[1].count = 0;
+	    start_batch(p, row + step, step);
+
+	    return read_data(rd, row, data_buf, nbytes);
+	}
+
+	/* caller moves on to the next batch, read the one after it */
+	p->cur = !p->cur;
+	start_batch(p, b->first + b->count * b->step, b->step);
+    }
+
+    memcpy(data_buf, b->data + i * b->row_size, b->row_size);
+    *nbytes = b->nbytes[i];
+
+    return b->stat[i];
+}
+
+static void free_prefetch(struct row_prefetch *p)
+{
+    int i;
+
+    G_end_execute(&p->ref);
+
+    G_close_raster_reader(p->batch[0].rd);
+
+    for (i = 0; i < 2; i++) {
+	G_free(p->batch[i].data);
+	G_free(p->batch[i].nbytes);
+	G_free(p->batch[i].stat);
+    }
+
+    G_free(p);
+}
+
+/*!
+ * \brief Read rows of a raster map ahead
+ *
+ * Enables or disables read-ahead for a map open for reading. Once
+ * enabled, the G_get_raster_row() family of functions reads and
+ * decompresses up to <em>nrows</em> of the rows following the last
+ * requested one in a worker thread (see G_num_workers()) while the
+ * caller processes the current rows. This pays off for modules which
+ * read a map row by row from top to bottom, in particular from slow
+ * or remote file systems. Random access is still possible but gains
+ * nothing.
+ *
+ * Read-ahead needs at least one worker thread and is not available
+ * for maps linked through GDAL; in these cases the call is ignored.
+ * It is disabled automatically when the map is closed.
+ *
+ * \param fd file descriptor of a raster map opened for reading
+ * \param nrows number of rows to read ahead, 0 to disable read-ahead
+ *
+ * \return 1 if read-ahead is enabled
+ * \return 0 otherwise
+ */
+int G_set_raster_prefetch(int fd, int nrows)
+{
+    struct fileinfo *fcb;
+    struct row_prefetch *p;
+    struct Raster_reader *rd;
+    int i;
+
+    if (fd < 0 || fd >= G__.fileinfo_count ||
+	G__.fileinfo[fd].open_mode != OPEN_OLD) {
+	G_warning(_("G_set_raster_prefetch: file descriptor %d is not open for reading"),
+		  fd);
+	return 0;
+    }
+
+    fcb = &G__.fileinfo[fd];
+
+    if (fcb->prefetch) {
+	free_prefetch(fcb->prefetch);
+	fcb->prefetch = NULL;
+    }
+
+    /* mapped maps are not read at all */
+    if (nrows <= 0 || fcb->gdal || fcb->map || G_num_workers() <= 0)
+	return 0;
+
+    if ((rd = new_reader(fd)) == NULL)
+	return 0;
+
+    p = G_malloc(sizeof(struct row_prefetch));
+    p->nrows = nrows;
+    p->last = -1;
+    p->cur = 0;
+    p->ref = NULL;
+
+    for (i = 0; i < 2; i++) {
+	struct row_batch *b = &p->batch[i];
+
+	b->rd = rd;
+	b->first = 0;
+	b->step = 1;
+	b->count = 0;
+	b->row_size = fcb->cellhd.cols * fcb->nbytes;
+	b->data = G_malloc(nrows * b->row_size);
+	b->nbytes = G_malloc(nrows * sizeof(int));
+	b->stat = G_malloc(nrows * sizeof(int));
+    }
+
+    fcb->prefetch = p;
+
+    return 1;
+}
@@ -0,0 +1,262 @@
+/*!
+   \file null_cmpr.c
+
+   \brief GIS library - null files
+
+   The null file of a raster map is normally a plain bitmap
+   (<tt>cell_misc/name/null</tt>) holding G__null_bitstream_size()
+   bytes per row. It may instead be compressed row by row into
+   <tt>cell_misc/name/nullcmpr</tt>: one byte with the number of the
+   compressor (see compress.c), the row offset table in the format of
+   compressed cell files (see format.c) and the rows as written by
+   G_write_compressed().
+
+   Null files are compressed for maps compressed with LZ4 or Zstandard,
+   which older GRASS versions can not read anyway, and otherwise if the
+   GRASS_COMPRESS_NULLS environment variable is set.
+
+   (C) 2013 by the GRASS Development Team
+
+   This program is free software under the
+   GNU General Public License (>=v2).
+   Read the file COPYING that comes with GRASS
+   for details.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+
+#include <grass/config.h>
+#include <grass/glocale.h>
+
+#include "G.h"
+
+#define NULL_FILE   "null"
+#define NULLC_FILE  "nullcmpr"
+
+static int read_null_row_ptrs(struct fileinfo *fcb, int null_fd)
+{
+    int nrows = fcb->cellhd.rows;
+    unsigned char hdr[2];
+    unsigned char *buf, *b;
+    int n, row;
+
+    if (read(null_fd, hdr, 2) != 2 || hdr[1] == 0 ||
+	G_check_compressor(hdr[0]) != 1)
+	return -1;
+
+    n = (nrows + 1) * hdr[1];
+    buf = G_malloc(n);
+    if (read(null_fd, buf, n) != n) {
+	G_free(buf);
+	return -1;
+    }
+
+    fcb->null_row_ptr = G_malloc((nrows + 1) * sizeof(off_t));
+    fcb->null_compressor = hdr[0];
+
+    for (row = 0, b = buf; row <= nrows; row++) {
+	off_t v = 0;
+
+	for (n = 0; n < hdr[1]; n++)
+	    v = (v << 8) + *b++;
+
+	fcb->null_row_ptr[row] = v;
+    }
+
+    G_free(buf);
+
+    return 0;
+}
+
+/*!
+ * \brief Open the null file of a raster map for reading
+ *
+ * The row offsets of a compressed null file are read on the first
+ * call and kept in <em>fcb</em>.
+ *
+ * \param fcb map opened for reading
+ *
+ * \return file descriptor
+ * \return -1 if the map has no null file
+ */
+int G__open_null_read(struct fileinfo *fcb)
+{
+    const char *name, *mapset, *element;
+    int null_fd, compressed;
+
+    if (fcb->null_file_exists == 0)
+	return -1;
+
+    if (fcb->reclass_flag) {
+	name = fcb->reclass.name;
+	mapset = fcb->reclass.mapset;
+    }
+    else {
+	name = fcb->name;
+	mapset = fcb->mapset;
+    }
+
+    if (G_find_file2_misc("cell_misc", NULL_FILE, name, mapset)) {
+	element = NULL_FILE;
+	compressed = 0;
+    }
+    else if (G_find_file2_misc("cell_misc", NULLC_FILE, name, mapset)) {
+	element = NULLC_FILE;
+	compressed = 1;
+    }
+    else {
+	fcb->null_file_exists = 0;
+	return -1;
+    }
+
+    null_fd = G_open_old_misc("cell_misc", element, name, mapset);
+    if (null_fd < 0)
+	return -1;
+
+    if (compressed && !fcb->null_row_ptr &&
+	read_null_row_ptrs(fcb, null_fd) < 0) {
+	G_warning(_("Error reading null file of raster map <%s@%s>"),
+		  name, mapset);
+	close(null_fd);
+	fcb->null_file_exists = 0;
+	return -1;
+    }
+
+    fcb->null_file_exists = 1;
+
+    return null_fd;
+}
+
+/*!
+ * \brief Read a row of a null file
+ *
+ * \param fcb map
+ * \param null_fd descriptor returned by G__open_null_read()
+ * \param row data row
+ * \param[out] flags null bits of the row
+ *
+ * \return 1 on success, -1 on error
+ */
+int G__read_null_row(struct fileinfo *fcb, int null_fd, int row,
+		     unsigned char *flags)
+{
+    int size = G__null_bitstream_size(fcb->cellhd.cols);
+
+    if (fcb->null_row_ptr) {
+	off_t t1 = fcb->null_row_ptr[row];
+	off_t t2 = fcb->null_row_ptr[row + 1];
+
+	if (lseek(null_fd, t1, SEEK_SET) < 0 ||
+	    G_read_compressed(null_fd, t2 - t1, flags, size,
+			      fcb->null_compressor) != size)
+	    return -1;
+
+	return 1;
+    }
+
+    if (lseek(null_fd, (off_t) size * row, SEEK_SET) < 0)
+	return -1;
+
+    if (read(null_fd, flags, size) != size)
+	return -1;
+
+    return 1;
+}
+
+/*!
+ * \brief Write the compressed null file of a new raster map
+ *
+ * Compresses the temporary null file of the map, which holds plain
+ * rows, into <tt>cell_misc/name/nullcmpr</tt> and removes it.
+ *
+ * \param fd file descriptor of the map being closed
+ *
+ * \return 1 on success, -1 on error
+ */
+int G__write_null_cmpr(int fd)
+{
+    struct fileinfo *fcb = &G__.fileinfo[fd];
+    int nrows = fcb->cellhd.rows;
+    int size = G__null_bitstream_size(fcb->cellhd.cols);
+    int nbytes = sizeof(off_t);
+    int len = (nrows + 1) * nbytes + 2;
+    unsigned char *flags, *cmp, *hdr, *b;
+    off_t *ptr;
+    int src_fd, dst_fd;
+    int row, i, stat = 1;
+
+    src_fd = open(fcb->null_temp_name, O_RDONLY);
+    if (src_fd < 0)
+	return -1;
+
+    dst_fd = G_open_new_misc("cell_misc", NULLC_FILE, fcb->name);
+    if (dst_fd < 0) {
+	close(src_fd);
+	return -1;
+    }
+
+    flags = G_malloc(size);
+    cmp = G_malloc(size + 1);
+    ptr = G_malloc((nrows + 1) * sizeof(off_t));
+
+    /* the offset table is written once all rows are known */
+    ptr[0] = len;
+    if (lseek(dst_fd, (off_t) len, SEEK_SET) < 0)
+	stat = -1;
+
+    for (row = 0; row < nrows && stat > 0; row++) {
+	int n;
+
+	if (read(src_fd, flags, size) != size)
+	    G__init_null_bits(flags, fcb->cellhd.cols);
+
+	n = G_pack_compressed(flags, size, cmp, fcb->null_compressor);
+	if (n < 0 || write(dst_fd, cmp, n) != n)
+	    stat = -1;
+
+	ptr[row + 1] = ptr[row] + n;
+    }
+
+    b = hdr = G_malloc(len);
+    *b++ = fcb->null_compressor;
+    *b++ = nbytes;
+    for (row = 0; row <= nrows; row++) {
+	off_t v = ptr[row];
+
+	for (i = nbytes - 1; i >= 0; i--) {
+	    b[i] = v & 0xff;
+	    v >>= 8;
+	}
+	b += nbytes;
+    }
+
+    if (stat > 0 &&
+	(lseek(dst_fd, 0L, SEEK_SET) < 0 || write(dst_fd, hdr, len) != len))
+	stat = -1;
+
+    G_free(hdr);
+    G_free(ptr);
+    G_free(cmp);
+    G_free(flags);
+
+    close(dst_fd);
+    close(src_fd);
+
+    if (stat < 0) {
+	char path[GPATH_MAX];
+
+	G_warning(_("Error writing null file of raster map <%s>"),
+		  fcb->name);
+	G__file_name_misc(path, "cell_misc", NULLC_FILE, fcb->name,
+			  G_mapset());
+	remove(path);
+    }
+
+    remove(fcb->null_temp_name);
+
+    return stat;
+}
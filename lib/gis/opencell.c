@@ -14,6 +14,7 @@
 
 #include <rpc/types.h>
 #include <rpc/xdr.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
 #include <sys/types.h>
@@ -158,6 +159,7 @@ int G__open_cell_old(const char *name, const char *mapset)
     int INTERN_SIZE;
     int reclass_flag, i;
     int MAP_NBYTES;
+    int tile_size;
     RASTER_MAP_TYPE MAP_TYPE;
     struct Reclass reclass;
     const char *xmapset;
@@ -199,6 +201,15 @@ int G__open_cell_old(const char *name, const char *mapset)
     if (G_get_cellhd(r_name, r_mapset, &cellhd) < 0)
 	return -1;
 
+    /* tiled maps are always compressed */
+    tile_size = cellhd.compressed > 0 ? G__read_tile_size(r_name, r_mapset) : 0;
+
+    if (cellhd.compressed > 0 && G_check_compressor(cellhd.compressed) != 1) {
+	G_warning(_("Raster map <%s@%s> is compressed with an unsupported method (%d)"),
+		  r_name, r_mapset, cellhd.compressed);
+	return -1;
+    }
+
     /* now check the type */
     MAP_TYPE = G_raster_map_type(r_name, r_mapset);
     if (MAP_TYPE < 0)
@@ -250,7 +261,8 @@ int G__open_cell_old(const char *name, const char *mapset)
 
 	strcpy(cell_dir, "cell");
 	INTERN_SIZE = sizeof(CELL);
-	MAP_NBYTES = CELL_nbytes;
+	/* tiles store all bytes of a CELL */
+	MAP_NBYTES = tile_size ? sizeof(CELL) : CELL_nbytes;
     }
 
     gdal = G_get_gdal_link(r_name, r_mapset);
@@ -278,6 +290,11 @@ int G__open_cell_old(const char *name, const char *mapset)
     /* Save cell header */
     G_copy((char *)&fcb->cellhd, (char *)&cellhd, sizeof(cellhd));
 
+    fcb->tile_size = tile_size;
+    fcb->tiles = NULL;
+    fcb->null_compressor = 0;
+    fcb->null_row_ptr = NULL;
+
     /* allocate null bitstream buffers for reading null rows */
     for (i = 0; i < NULL_ROWS_INMEM; i++)
 	fcb->NULL_ROWS[i] = G__allocate_null_bits(G__.window.cols);
@@ -301,6 +318,8 @@ int G__open_cell_old(const char *name, const char *mapset)
 
     /* mark no data row in memory  */
     fcb->cur_row = -1;
+    fcb->row_queue = NULL;
+    fcb->prefetch = NULL;
     /* fcb->null_cur_row is not used for reading, only for writing */
     fcb->null_cur_row = -1;
 
@@ -355,9 +374,7 @@ int G__open_cell_old(const char *name, const char *mapset)
     fcb->nbytes = MAP_NBYTES;
     fcb->null_file_exists = -1;
 
-    if (fcb->map_type != CELL_TYPE)
-	xdrmem_create(&fcb->xdrstream, (caddr_t) fcb->data,
-		      (u_int) (fcb->nbytes * fcb->cellhd.cols), XDR_DECODE);
+    G__map_cell_file(fd);
 
     return fd;
 }
@@ -378,6 +395,10 @@ static RASTER_MAP_TYPE WRITE_MAP_TYPE = CELL_TYPE;
 
 static int COMPRESSION_TYPE = 0;
 
+/* tile size for compressed maps, 0 for rows, -1 if not yet set */
+
+static int TILE_SIZE = -1;
+
 #define FP_NBYTES G__.fp_nbytes
 /* bytes per cell for writing floating point maps */
 #define FP_TYPE  G__.fp_type
@@ -508,6 +529,50 @@ int G_set_cell_format(int n)
     return 0;
 }
 
+/*!
+  \brief Sets the tile size for subsequent opens of new compressed maps
+
+  Compressed raster maps opened for writing afterwards are stored in
+  square tiles of <i>n</i> x <i>n</i> cells instead of rows, which
+  makes reading small parts of large maps cheaper (see
+  G_get_raster_tile()). A size of 0 restores the row based storage.
+  The default is taken from the GRASS_TILE_SIZE environment variable.
+
+  \param n tile size
+
+  \return 0
+*/
+int G_set_raster_tile_size(int n)
+{
+    TILE_SIZE = n > 0 ? n : 0;
+
+    return 0;
+}
+
+/*!
+  \brief Sets the compressor for subsequent opens of new compressed maps
+
+  Selects the method used to compress raster maps opened for
+  compressed writing afterwards (see G_compressor_number()). RLE
+  applies to integer maps only, floating point maps are then
+  compressed with zlib. The default is taken from the GRASS_COMPRESSOR
+  environment variable, or else from GRASS_INT_ZLIB.
+
+  \param number compressor number
+
+  \return 0 on success
+  \return -1 if the compressor is not available
+*/
+int G_set_raster_compressor(int number)
+{
+    if (G_check_compressor(number) != 1)
+	return -1;
+
+    COMPRESSION_TYPE = number;
+
+    return 0;
+}
+
 /*!
   \brief Get cell value format
 
@@ -690,8 +755,22 @@ static int G__open_raster_new(const char *name, int open_mode)
     G__reallocate_null_buf();
     /* we need null buffer to automatically write embeded nulls in put_row */
 
-    if (open_mode == OPEN_NEW_COMPRESSED && !COMPRESSION_TYPE)
+    if (open_mode == OPEN_NEW_COMPRESSED && !COMPRESSION_TYPE) {
+	const char *p = getenv("GRASS_COMPRESSOR");
+
 	COMPRESSION_TYPE = getenv("GRASS_INT_ZLIB") ? 2 : 1;
+	if (p && G_set_raster_compressor(G_compressor_number(p)) < 0)
+	    G_warning(_("Compressor <%s> is not available, using %s"), p,
+		      G_compressor_name(COMPRESSION_TYPE));
+    }
+
+    if (TILE_SIZE < 0) {
+	const char *p = getenv("GRASS_TILE_SIZE");
+
+	TILE_SIZE = p ? atoi(p) : 0;
+	if (TILE_SIZE < 0)
+	    TILE_SIZE = 0;
+    }
 
     /*
      * copy current window into cell header
@@ -702,11 +781,17 @@ static int G__open_raster_new(const char *name, int open_mode)
      */
     G_copy((char *)&fcb->cellhd, (char *)&G__.window, sizeof(fcb->cellhd));
 
+    fcb->tile_size = open_mode == OPEN_NEW_COMPRESSED ? TILE_SIZE : 0;
+    fcb->tiles = NULL;
+
     if (open_mode == OPEN_NEW_COMPRESSED && fcb->map_type == CELL_TYPE) {
-	fcb->row_ptr = G_calloc(fcb->cellhd.rows + 1, sizeof(off_t));
-	G_zero(fcb->row_ptr, (fcb->cellhd.rows + 1) * sizeof(off_t));
+	fcb->row_ptr = G_calloc(G__row_ptr_count(fd) + 1, sizeof(off_t));
+	G_zero(fcb->row_ptr, (G__row_ptr_count(fd) + 1) * sizeof(off_t));
+	/* tiles are compressed like floating point rows */
+	fcb->cellhd.compressed = fcb->tile_size
+	    ? BLOCK_COMPRESSOR(COMPRESSION_TYPE) : COMPRESSION_TYPE;
+	/* the method decides the layout of the offsets, see format.c */
 	G__write_row_ptrs(fd);
-	fcb->cellhd.compressed = COMPRESSION_TYPE;
 
 	allocate_compress_buf(fd);
 	fcb->nbytes = 1;	/* to the minimum */
@@ -717,10 +802,10 @@ static int G__open_raster_new(const char *name, int open_mode)
     else {
 	fcb->nbytes = WRITE_NBYTES;
 	if (open_mode == OPEN_NEW_COMPRESSED) {
-	    fcb->row_ptr = G_calloc(fcb->cellhd.rows + 1, sizeof(off_t));
-	    G_zero(fcb->row_ptr, (fcb->cellhd.rows + 1) * sizeof(off_t));
-	    G__write_row_ptrs(fd);
+	    fcb->row_ptr = G_calloc(G__row_ptr_count(fd) + 1, sizeof(off_t));
+	    G_zero(fcb->row_ptr, (G__row_ptr_count(fd) + 1) * sizeof(off_t));
 	    fcb->cellhd.compressed = COMPRESSION_TYPE;
+	    G__write_row_ptrs(fd);
 	}
 	else
 	    fcb->cellhd.compressed = 0;
@@ -785,6 +870,16 @@ static int G__open_raster_new(const char *name, int open_mode)
     fcb->min_null_row = (-1) * NULL_ROWS_INMEM;
     fcb->null_work_buf = G__allocate_null_bits(fcb->cellhd.cols);
 
+    /* compress the null file of maps which older versions can not read
+       anyway, or on request (see null_cmpr.c) */
+    fcb->null_row_ptr = NULL;
+    fcb->null_compressor = 0;
+    if (open_mode == OPEN_NEW_COMPRESSED && COMPRESSION_TYPE > 2)
+	fcb->null_compressor = COMPRESSION_TYPE;
+    else if (getenv("GRASS_COMPRESS_NULLS"))
+	fcb->null_compressor = open_mode == OPEN_NEW_COMPRESSED
+	    ? BLOCK_COMPRESSOR(COMPRESSION_TYPE) : 2;
+
     /* init cell stats */
     /* now works only for int maps */
     if (fcb->map_type == CELL_TYPE)
@@ -797,6 +892,13 @@ static int G__open_raster_new(const char *name, int open_mode)
     if (fcb->map_type != CELL_TYPE)
 	G_init_fp_range(&fcb->fp_range);
 
+    /* compress rows in worker threads, if there are any */
+    fcb->row_queue = open_mode == OPEN_NEW_COMPRESSED && !fcb->tile_size
+	? G__open_row_queue(fd) : NULL;
+
+    if (fcb->tile_size)
+	G__init_tile_writer(fd);
+
     /* mark file as open for write */
     fcb->open_mode = open_mode;
     fcb->io_error = 0;
@@ -152,6 +152,37 @@ static int convert_and_write_df(int, const DCELL *);
 static int convert_and_write_fd(int, const FCELL *);
 static int put_raster_row(int fd, const void *buf, RASTER_MAP_TYPE data_type,
 			  int zeros_r_nulls);
+static void compress_row(void *);
+static struct row_job *get_job(int, int);
+
+/*
+ * Rows of compressed maps may be compressed by worker threads (see
+ * worker.c). put_data() and put_fp_data() then hand the converted row
+ * to a slot of the row queue instead of compressing and writing it.
+ * The slots are written by the calling thread in row order, which is
+ * also when the row pointer is recorded, as soon as the slot is needed
+ * for a later row or the map is closed.
+ */
+
+struct row_job
+{
+    void *ref;			/* worker task handle                  */
+    int row;			/* row held by the slot, -1 if free    */
+    int n;			/* number of cells                     */
+    int nbytes;			/* bytes per cell                      */
+    int fp;			/* floating point row                  */
+    int method;			/* compressor, see compress.c          */
+    int size;			/* size of raw and cmp                 */
+    unsigned char *raw;		/* converted row                       */
+    unsigned char *cmp;		/* compressed row                      */
+    int ncmp;			/* bytes to be written from cmp or raw */
+};
+
+struct row_queue
+{
+    int nslots;
+    struct row_job *jobs;
+};
 
 /*--------------------------------------------------------------------------*/
 
@@ -334,7 +365,8 @@ int G__write_data_compressed(int fd, int row, int n)
     struct fileinfo *fcb = &G__.fileinfo[fd];
     int nwrite = fcb->nbytes * n;
 
-    if (G_zlib_write(fd, G__.work_buf, nwrite) < 0) {
+    if (G_write_compressed(fd, G__.work_buf, nwrite,
+			   BLOCK_COMPRESSOR(fcb->cellhd.compressed)) < 0) {
 	write_error(fd, row);
 	return -1;
     }
@@ -446,7 +478,7 @@ static int put_fp_data(int fd, const void *rast, int row, int col, int n,
 	if (seek_random(fd, row, col) == -1)
 	    return -1;
     }
-    else if (compressed)
+    else if (compressed && !fcb->row_queue && !fcb->tiles)
 	set_file_pointer(fd, row);
 
     xdrmem_create(xdrs, (caddr_t) G__.work_buf,
@@ -464,7 +496,24 @@ static int put_fp_data(int fd, const void *rast, int row, int col, int n,
 
     xdr_destroy(&fcb->xdrstream);
 
-    if (compressed) {
+    if (compressed && fcb->tiles) {
+	if (G__put_tile_row(fd, row, G__.work_buf) < 0)
+	    return -1;
+    }
+    else if (compressed && fcb->row_queue) {
+	struct row_job *job = get_job(fd, row);
+
+	if (!job)
+	    return -1;
+
+	job->n = n;
+	job->nbytes = fcb->nbytes;
+	job->fp = 1;
+	job->method = BLOCK_COMPRESSOR(fcb->cellhd.compressed);
+	memcpy(job->raw, G__.work_buf, n * fcb->nbytes);
+	G_begin_execute(compress_row, job, &job->ref, 0);
+    }
+    else if (compressed) {
 	if (G__write_data_compressed(fd, row, n) == -1)
 	    return -1;
     }
@@ -594,19 +643,158 @@ static int rle_compress(unsigned char *dst, unsigned char *src, int n,
     return nwrite;
 }
 
-static int zlib_compress(unsigned char *dst, unsigned char *src, int n,
-			 int nbytes)
+static int block_compress(unsigned char *dst, int dst_sz, unsigned char *src,
+			  int n, int nbytes, int method)
 {
     int total = nbytes * n;
-    int nwrite = G_zlib_compress(G__.work_buf + 1, total,
-				 G__.compressed_buf + 1,
-				 G__.compressed_buf_size - 1);
+    int nwrite = G_compress(src, total, dst, dst_sz, method);
 
     return (nwrite >= total) ? 0 : nwrite;
 }
 
 /*--------------------------------------------------------------------------*/
 
+static void compress_row(void *closure)
+{
+    struct row_job *job = closure;
+    int total = job->nbytes * job->n;
+    int nwrite;
+
+    if (job->fp) {
+	job->ncmp = G_pack_compressed(job->raw, total, job->cmp, job->method);
+	return;
+    }
+
+    job->cmp[0] = job->raw[0];
+
+    nwrite = job->method == 1
+	? rle_compress(job->cmp + 1, job->raw + 1, job->n, job->nbytes)
+	: block_compress(job->cmp + 1, job->size - 1, job->raw + 1, job->n,
+			 job->nbytes, job->method);
+
+    if (nwrite > 0)
+	job->ncmp = nwrite + 1;
+    else {
+	/* compression does not pay off, write the raw row */
+	memcpy(job->cmp, job->raw, total + 1);
+	job->ncmp = total + 1;
+    }
+}
+
+struct row_queue *G__open_row_queue(int fd)
+{
+    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct row_queue *q;
+    int i, workers;
+
+    workers = G_num_workers();
+    if (workers <= 0)
+	return NULL;
+
+    q = G_malloc(sizeof(struct row_queue));
+    q->nslots = 2 * workers + 2;
+    q->jobs = G_calloc(q->nslots, sizeof(struct row_job));
+
+    for (i = 0; i < q->nslots; i++) {
+	struct row_job *job = &q->jobs[i];
+
+	job->row = -1;
+	job->size = fcb->cellhd.cols * (sizeof(DCELL) + 1) + 1;
+	job->raw = G_malloc(job->size);
+	job->cmp = G_malloc(job->size);
+    }
+
+    return q;
+}
+
+static int write_job(int fd, struct row_job *job)
+{
+    struct fileinfo *fcb = &G__.fileinfo[fd];
+    int row = job->row;
+    ssize_t nwrite;
+
+    G_end_execute(&job->ref);
+    nwrite = job->ncmp;
+    job->row = -1;
+
+    fcb->row_ptr[row] = lseek(fd, 0L, SEEK_CUR);
+
+    if (nwrite < 0 || write(fd, job->cmp, nwrite) != nwrite) {
+	write_error(fd, row);
+	return -1;
+    }
+
+    return 0;
+}
+
+/* get the slot for row, writing out the row previously held by it */
+static struct row_job *get_job(int fd, int row)
+{
+    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct row_queue *q = fcb->row_queue;
+    struct row_job *job = &q->jobs[row % q->nslots];
+
+    if (job->row >= 0 && write_job(fd, job) < 0)
+	return NULL;
+
+    job->row = row;
+
+    return job;
+}
+
+/*!
+ * \brief Write out and release the row queue of a map
+ *
+ * Waits for all pending rows, writes them if <em>flush</em> is set and
+ * frees the queue.
+ *
+ * \param fd file descriptor
+ * \param flush nonzero to write the pending rows
+ *
+ * \return 0 on success, -1 on write error
+ */
+int G__close_row_queue(int fd, int flush)
+{
+    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct row_queue *q = fcb->row_queue;
+    int stat = 0;
+    int i, row;
+
+    if (!q)
+	return 0;
+
+    /* slots hold the last nslots rows, write them oldest first */
+    for (row = fcb->cur_row - q->nslots; row < fcb->cur_row; row++) {
+	struct row_job *job;
+
+	if (row < 0)
+	    continue;
+
+	job = &q->jobs[row % q->nslots];
+	if (job->row != row)
+	    continue;
+
+	if (flush) {
+	    if (write_job(fd, job) < 0)
+		stat = -1;
+	}
+	else
+	    G_end_execute(&job->ref);
+    }
+
+    for (i = 0; i < q->nslots; i++) {
+	G_free(q->jobs[i].raw);
+	G_free(q->jobs[i].cmp);
+    }
+    G_free(q->jobs);
+    G_free(q);
+    fcb->row_queue = NULL;
+
+    return stat;
+}
+
+/*--------------------------------------------------------------------------*/
+
 static int put_data(int fd, const CELL * cell, int row, int col, int n,
 		    int zeros_r_nulls)
 {
@@ -627,7 +815,7 @@ static int put_data(int fd, const CELL * cell, int row, int col, int n,
 	if (seek_random(fd, row, col) == -1)
 	    return -1;
     }
-    else if (compressed)
+    else if (compressed && !fcb->row_queue && !fcb->tiles)
 	set_file_pointer(fd, row);
 
     if (compressed)
@@ -642,18 +830,40 @@ static int put_data(int fd, const CELL * cell, int row, int col, int n,
 	if (fcb->nbytes < nbytes)
 	    fcb->nbytes = nbytes;
 
+	/* tiles keep all bytes */
+	if (fcb->tiles)
+	    return G__put_tile_row(fd, row, wk);
+
 	/* first trim away zero high bytes */
 	if (nbytes < len)
 	    trim_bytes(wk, n, len, len - nbytes);
 
 	G__.compressed_buf[0] = G__.work_buf[0] = nbytes;
 
+	/* leave compression and writing to the row queue */
+	if (fcb->row_queue) {
+	    struct row_job *job = get_job(fd, row);
+
+	    if (!job)
+		return -1;
+
+	    job->n = n;
+	    job->nbytes = nbytes;
+	    job->fp = 0;
+	    job->method = compressed;
+	    memcpy(job->raw, G__.work_buf, nbytes * n + 1);
+	    G_begin_execute(compress_row, job, &job->ref, 0);
+
+	    return 1;
+	}
+
 	/* then compress the data */
 	nwrite = compressed == 1
 	    ? rle_compress(G__.compressed_buf + 1, G__.work_buf + 1, n,
 			   nbytes)
-	    : zlib_compress(G__.compressed_buf + 1, G__.work_buf + 1, n,
-			    nbytes);
+	    : block_compress(G__.compressed_buf + 1,
+			     G__.compressed_buf_size - 1, G__.work_buf + 1,
+			     n, nbytes, compressed);
 
 	if (nwrite > 0) {
 	    nwrite++;
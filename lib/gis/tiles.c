@@ -0,0 +1,571 @@
+/*!
+   \file tiles.c
+
+   \brief GIS library - tiled raster storage
+
+   Compressed raster maps may be stored in square tiles instead of
+   rows. Each tile is compressed on its own, so that reading a part of
+   a large map only decompresses the tiles covering that part.
+
+   The cell file of a tiled map starts with a zero byte followed by
+   the usual offset table (see format.c), which holds one entry per
+   tile (tiles in row major order) instead of one per row. Older
+   versions take the zero byte for an invalid offset size and refuse
+   to open the map instead of reading the tiles as rows.
+
+   A tile holds tile_size x tile_size cells, stored like the cells of
+   a row: 4 bytes per cell for CELL maps, XDR for FCELL and DCELL
+   maps. Tiles at the right and bottom edge are padded with zeros.
+   Each tile is written like a floating point row by
+   G_write_compressed(), with the compressor of the map (see
+   compress.c). The tile size is kept in the
+   <tt>cell_misc/name/tiles</tt> file; null values stay in the row
+   based null file.
+
+   (C) 2013 by the GRASS Development Team
+
+   This program is free software under the
+   GNU General Public License (>=v2).
+   Read the file COPYING that comes with GRASS
+   for details.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include <rpc/types.h>
+#include <rpc/xdr.h>
+
+#include <grass/config.h>
+#include <grass/glocale.h>
+
+#include "G.h"
+
+#define TILES_FILE "tiles"
+
+struct tile_job
+{
+    void *ref;			/* worker task handle            */
+    int tile;			/* tile held by the slot, or -1  */
+    int nbytes;			/* size of raw                   */
+    int method;			/* compressor                    */
+    unsigned char *raw;		/* tile cells                    */
+    unsigned char *cmp;		/* tile as written to the file   */
+    int ncmp;
+};
+
+struct tile_cache
+{
+    int size;			/* cells per tile side              */
+    int nbytes;			/* stored bytes per cell            */
+    int rows, cols;		/* number of tile rows and columns  */
+    int tile_bytes;		/* bytes per tile                   */
+
+    /* reading */
+    unsigned char **tile;	/* decoded tile of each tile column */
+    int *loaded;		/* tile row held by tile[], or -1   */
+    int null_fd;		/* null file for G_get_raster_tile() */
+
+    /* writing */
+    unsigned char *strip;	/* rows of the current tile row     */
+    int nslots;
+    struct tile_job *jobs;
+};
+
+/*--------------------------------------------------------------------------*/
+
+static struct tile_cache *new_cache(struct fileinfo *fcb)
+{
+    struct tile_cache *c = G_calloc(1, sizeof(struct tile_cache));
+    int i;
+
+    c->size = fcb->tile_size;
+    c->nbytes = fcb->map_type == CELL_TYPE ? sizeof(CELL) : fcb->nbytes;
+    c->rows = (fcb->cellhd.rows + c->size - 1) / c->size;
+    c->cols = (fcb->cellhd.cols + c->size - 1) / c->size;
+    c->tile_bytes = c->size * c->size * c->nbytes;
+
+    c->tile = G_calloc(c->cols, sizeof(unsigned char *));
+    c->loaded = G_malloc(c->cols * sizeof(int));
+    for (i = 0; i < c->cols; i++)
+	c->loaded[i] = -1;
+    c->null_fd = -1;
+
+    return c;
+}
+
+/*!
+ * \brief Release the tile buffers of a map
+ *
+ * \param fcb map
+ */
+void G__free_tile_cache(struct fileinfo *fcb)
+{
+    struct tile_cache *c = fcb->tiles;
+    int i;
+
+    if (!c)
+	return;
+
+    for (i = 0; i < c->cols; i++)
+	if (c->tile[i])
+	    G_free(c->tile[i]);
+    G_free(c->tile);
+    G_free(c->loaded);
+
+    if (c->null_fd >= 0)
+	close(c->null_fd);
+
+    if (c->jobs) {
+	for (i = 0; i < c->nslots; i++) {
+	    G_end_execute(&c->jobs[i].ref);
+	    G_free(c->jobs[i].raw);
+	    G_free(c->jobs[i].cmp);
+	}
+	G_free(c->jobs);
+	G_free(c->strip);
+    }
+
+    G_free(c);
+    fcb->tiles = NULL;
+}
+
+/*--------------------------------------------------------------------------*/
+
+/*!
+ * \brief Read the tile size of a raster map
+ *
+ * \param name map name
+ * \param mapset mapset
+ *
+ * \return tile size, 0 if the map is stored in rows
+ */
+int G__read_tile_size(const char *name, const char *mapset)
+{
+    char path[GPATH_MAX];
+    struct Key_Value *keys;
+    const char *str;
+    int stat, size = 0;
+
+    if (!G_find_file2_misc("cell_misc", TILES_FILE, name, mapset))
+	return 0;
+
+    G__file_name_misc(path, "cell_misc", TILES_FILE, name, mapset);
+    keys = G_read_key_value_file(path, &stat);
+    if (stat == 0 && (str = G_find_key_value("tile_size", keys)) != NULL)
+	size = atoi(str);
+    G_free_key_value(keys);
+
+    if (size < 0) {
+	G_warning(_("Invalid tile size in <%s>"), path);
+	size = 0;
+    }
+
+    return size;
+}
+
+/*!
+ * \brief Record the tile size of a new raster map
+ *
+ * Writes the tiles file of a tiled map and removes a stale one left
+ * by a previous map of the same name otherwise.
+ *
+ * \param fd file descriptor of the map being closed
+ *
+ * \return 0 on success, -1 on error
+ */
+int G__write_tile_size(int fd)
+{
+    struct fileinfo *fcb = &G__.fileinfo[fd];
+    char path[GPATH_MAX];
+    char buf[32];
+    struct Key_Value *keys;
+    int stat;
+
+    G__file_name_misc(path, "cell_misc", TILES_FILE, fcb->name, fcb->mapset);
+
+    if (!fcb->tile_size) {
+	remove(path);
+	return 0;
+    }
+
+    G__make_mapset_element_misc("cell_misc", fcb->name);
+
+    keys = G_create_key_value();
+    sprintf(buf, "%d", fcb->tile_size);
+    G_set_key_value("tile_size", buf, keys);
+    G_write_key_value_file(path, keys, &stat);
+    G_free_key_value(keys);
+
+    return stat == 0 ? 0 : -1;
+}
+
+/*--------------------------------------------------------------------------*/
+
+/* writing */
+
+static void pack_tile(void *closure)
+{
+    struct tile_job *job = closure;
+
+    job->ncmp = G_pack_compressed(job->raw, job->nbytes, job->cmp,
+				  job->method);
+}
+
+static int write_tile(int fd, struct tile_job *job)
+{
+    struct fileinfo *fcb = &G__.fileinfo[fd];
+    int tile = job->tile;
+
+    G_end_execute(&job->ref);
+    job->tile = -1;
+
+    fcb->row_ptr[tile] = lseek(fd, 0L, SEEK_CUR);
+
+    if (job->ncmp < 0 || write(fd, job->cmp, job->ncmp) != job->ncmp) {
+	if (!fcb->io_error)
+	    G_warning(_("map [%s] - unable to write tile %d"), fcb->name,
+		      tile);
+	fcb->io_error = 1;
+	return -1;
+    }
+
+    return 0;
+}
+
+/* compress the tiles of a tile row, in worker threads if possible,
+   and write them in order */
+static int write_strip(int fd, int trow)
+{
+    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct tile_cache *c = fcb->tiles;
+    int stride = c->cols * c->size * c->nbytes;
+    int len = c->size * c->nbytes;
+    int stat = 1;
+    int tcol, r;
+
+    for (tcol = 0; tcol < c->cols + c->nslots; tcol++) {
+	struct tile_job *job = &c->jobs[tcol % c->nslots];
+
+	if (job->tile >= 0 && write_tile(fd, job) < 0)
+	    stat = -1;
+
+	if (tcol >= c->cols)
+	    continue;
+
+	for (r = 0; r < c->size; r++)
+	    memcpy(job->raw + r * len, c->strip + r * stride + tcol * len,
+		   len);
+
+	job->tile = trow * c->cols + tcol;
+	G_begin_execute(pack_tile, job, &job->ref, 0);
+    }
+
+    memset(c->strip, 0, c->size * stride);
+
+    return stat;
+}
+
+/*!
+ * \brief Set up tiled writing of a new raster map
+ *
+ * \param fd file descriptor of a map opened for compressed writing
+ */
+void G__init_tile_writer(int fd)
+{
+    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct tile_cache *c;
+    int i;
+
+    fcb->tiles = c = new_cache(fcb);
+
+    c->strip = G_calloc(c->size, c->cols * c->size * c->nbytes);
+
+    c->nslots = 2 * G_num_workers() + 2;
+    if (c->nslots > c->cols)
+	c->nslots = c->cols;
+    c->jobs = G_calloc(c->nslots, sizeof(struct tile_job));
+
+    for (i = 0; i < c->nslots; i++) {
+	c->jobs[i].tile = -1;
+	c->jobs[i].nbytes = c->tile_bytes;
+	c->jobs[i].method = BLOCK_COMPRESSOR(fcb->cellhd.compressed);
+	c->jobs[i].raw = G_malloc(c->tile_bytes);
+	c->jobs[i].cmp = G_malloc(c->tile_bytes + 1);
+    }
+}
+
+/*!
+ * \brief Add a row to a tiled raster map
+ *
+ * The row is buffered until the row of tiles it belongs to is
+ * complete, which is then compressed and written.
+ *
+ * \param fd file descriptor
+ * \param row row number
+ * \param data cells of the row in storage format
+ *
+ * \return 1 on success, -1 on write error
+ */
+int G__put_tile_row(int fd, int row, const unsigned char *data)
+{
+    struct fileinfo *fcb = &G__.fileinfo[fd];
+    struct tile_cache *c = fcb->tiles;
+    int stride = c->cols * c->size * c->nbytes;
+    int r = row % c->size;
+
+    memcpy(c->strip + r * stride, data, fcb->cellhd.cols * c->nbytes);
+
+    if (r == c->size - 1 || row == fcb->cellhd.rows - 1)
+	return write_strip(fd, row / c->size);
+
+    return 1;
+}
+
+/*--------------------------------------------------------------------------*/
+
+/* reading */
+
+static const unsigned char *read_tile(struct fileinfo *fcb, int fd, int trow,
+				      int tcol)
+{
+    struct tile_cache *c;
+    int tile;
+    off_t t1, t2;
+
+    if (!fcb->tiles)
+	fcb->tiles = new_cache(fcb);
+    c = fcb->tiles;
+
+    if (c->loaded[tcol] == trow)
+	return c->tile[tcol];
+
+    if (!c->tile[tcol])
+	c->tile[tcol] = G_malloc(c->tile_bytes);
+    c->loaded[tcol] = -1;
+
+    tile = trow * c->cols + tcol;
+    t1 = fcb->row_ptr[tile];
+    t2 = fcb->row_ptr[tile + 1];
+
+    if (lseek(fd, t1, SEEK_SET) < 0 ||
+	G_read_compressed(fd, t2 - t1, c->tile[tcol], c->tile_bytes,
+			  BLOCK_COMPRESSOR(fcb->cellhd.compressed)) !=
+	c->tile_bytes)
+	return NULL;
+
+    c->loaded[tcol] = trow;
+
+    return c->tile[tcol];
+}
+
+/*!
+ * \brief Read a data row of a tiled raster map
+ *
+ * Only the tiles covering the columns used by the current window are
+ * read; the other columns of <em>data</em> are left alone. The tiles
+ * of the tile row last read are kept in memory.
+ *
+ * \param fcb map
+ * \param fd descriptor of the cell file
+ * \param row data row
+ * \param[out] data cells of the row in storage format
+ * \param[out] nbytes bytes per cell
+ *
+ * \return 0 on success, -1 on error
+ */
+int G__read_tile_row(struct fileinfo *fcb, int fd, int row,
+		     unsigned char *data, int *nbytes)
+{
+    int size = fcb->tile_size;
+    int nb = fcb->map_type == CELL_TYPE ? sizeof(CELL) : fcb->nbytes;
+    int cols = fcb->cellhd.cols;
+    int lo = cols, hi = -1;
+    int i, tcol;
+
+    *nbytes = nb;
+
+    for (i = 0; i < G__.window.cols; i++) {
+	int col = fcb->col_map[i] - 1;
+
+	if (col < 0)
+	    continue;
+	if (col < lo)
+	    lo = col;
+	if (col > hi)
+	    hi = col;
+    }
+
+    for (tcol = lo / size; tcol <= hi / size; tcol++) {
+	const unsigned char *tile =
+	    read_tile(fcb, fd, row / size, tcol);
+	int n = (tcol + 1) * size <= cols ? size : cols - tcol * size;
+
+	if (!tile)
+	    return -1;
+
+	memcpy(data + tcol * size * nb, tile + (row % size) * size * nb,
+	       n * nb);
+    }
+
+    return 0;
+}
+
+/*--------------------------------------------------------------------------*/
+
+/*!
+ * \brief Get tile size of a raster map
+ *
+ * \param fd file descriptor of a raster map opened for reading
+ *
+ * \return number of cells per tile side
+ * \return 0 if the map is not tiled
+ */
+int G_get_raster_tile_size(int fd)
+{
+    return G__.fileinfo[fd].tile_size;
+}
+
+static void set_null_cells(void *buf, int size, int row0, int col0,
+			   struct fileinfo *fcb, RASTER_MAP_TYPE data_type)
+{
+    struct tile_cache *c = fcb->tiles;
+    int cols = fcb->cellhd.cols;
+    unsigned char *bits = G__allocate_null_bits(cols);
+    int r, i;
+
+    for (r = 0; r < size; r++) {
+	int row = row0 + r;
+	void *p = G_incr_void_ptr(buf, r * size * G_raster_size(data_type));
+
+	if (row >= fcb->cellhd.rows) {
+	    G_set_null_value(p, size, data_type);
+	    continue;
+	}
+
+	if (c->null_fd < 0 || G__read_null_row(fcb, c->null_fd, row, bits) < 0)
+	    G__init_null_bits(bits, cols);
+
+	for (i = 0; i < size; i++) {
+	    int col = col0 + i;
+
+	    if (col >= cols || G__check_null_bit(bits, col, cols))
+		G_set_null_value(G_incr_void_ptr(p,
+						 i * G_raster_size(data_type)),
+				 1, data_type);
+	}
+    }
+
+    G_free(bits);
+}
+
+/*!
+ * \brief Read a tile of a raster map
+ *
+ * Reads the cells of the tile at <em>tile_row</em>, <em>tile_col</em>
+ * of a tiled raster map, at the resolution of the map and regardless
+ * of the current region and MASK. <em>buf</em> receives
+ * G_get_raster_tile_size() rows of as many cells each; cells of edge
+ * tiles which lie outside the map are set to null. Floating point
+ * maps read as CELL are quantized, reclass tables are applied.
+ *
+ * \param fd file descriptor of a raster map opened for reading
+ * \param tile_row tile row, from 0 at the top of the map
+ * \param tile_col tile column, from 0 at the left edge of the map
+ * \param buf buffer for the tile
+ * \param data_type type of the values in buf
+ *
+ * \return 1 on success
+ * \return -1 on error or if the map is not tiled
+ */
+int G_get_raster_tile(int fd, int tile_row, int tile_col, void *buf,
+		      RASTER_MAP_TYPE data_type)
+{
+    struct fileinfo *fcb = &G__.fileinfo[fd];
+    const unsigned char *tile;
+    struct tile_cache *c;
+    int size = fcb->tile_size;
+    int n, i;
+    XDR xdrs;
+
+    if (fcb->open_mode != OPEN_OLD || size <= 0) {
+	G_warning(_("G_get_raster_tile: map <%s> is not tiled"), fcb->name);
+	return -1;
+    }
+
+    if (tile_row < 0 || tile_row * size >= fcb->cellhd.rows ||
+	tile_col < 0 || tile_col * size >= fcb->cellhd.cols) {
+	G_warning(_("G_get_raster_tile: tile %d,%d outside of map <%s>"),
+		  tile_row, tile_col, fcb->name);
+	return -1;
+    }
+
+    tile = read_tile(fcb, fd, tile_row, tile_col);
+    if (!tile) {
+	G_warning(_("Error reading tile %d,%d of map <%s@%s>"),
+		  tile_row, tile_col, fcb->name, fcb->mapset);
+	return -1;
+    }
+
+    c = fcb->tiles;
+    n = size * size;
+
+    if (fcb->map_type != CELL_TYPE)
+	xdrmem_create(&xdrs, (caddr_t) tile, c->tile_bytes, XDR_DECODE);
+
+    for (i = 0; i < n; i++) {
+	void *p = G_incr_void_ptr(buf, i * G_raster_size(data_type));
+
+	if (fcb->map_type == CELL_TYPE) {
+	    const unsigned char *d = tile + i * sizeof(CELL);
+	    CELL v = ((d[0] & 0x7f) << 24) | (d[1] << 16) | (d[2] << 8) | d[3];
+
+	    if (d[0] & 0x80)
+		v = -v;
+
+	    if (fcb->reclass_flag) {
+		if (v < fcb->reclass.min || v > fcb->reclass.max)
+		    G_set_c_null_value(&v, 1);
+		else
+		    v = fcb->reclass.table[v - fcb->reclass.min];
+	    }
+
+	    if (G_is_c_null_value(&v))
+		G_set_null_value(p, 1, data_type);
+	    else
+		G_set_raster_value_c(p, v, data_type);
+	}
+	else {
+	    DCELL v;
+
+	    if (fcb->map_type == FCELL_TYPE) {
+		FCELL f;
+
+		xdr_float(&xdrs, &f);
+		v = f;
+	    }
+	    else
+		xdr_double(&xdrs, &v);
+
+	    if (data_type == CELL_TYPE)
+		*(CELL *) p = G_quant_get_cell_value(&fcb->quant, v);
+	    else
+		G_set_raster_value_d(p, v, data_type);
+	}
+    }
+
+    if (fcb->map_type != CELL_TYPE)
+	xdr_destroy(&xdrs);
+
+    /* open the null file on first use */
+    if (c->null_fd < 0)
+	c->null_fd = G__open_null_read(fcb);
+
+    set_null_cells(buf, size, tile_row * size, tile_col * size, fcb,
+		   data_type);
+
+    return 1;
+}
@@ -46,8 +46,11 @@ int G__create_window_mapping(int fd)
 
     if (fcb->open_mode >= 0 && fcb->open_mode != OPEN_OLD)	/* open for write? */
 	return 0;
-    if (fcb->open_mode == OPEN_OLD)	/* already open ? */
+    if (fcb->open_mode == OPEN_OLD) {	/* already open ? */
 	G_free(fcb->col_map);
+	/* tiled maps only decode the columns needed by the old window */
+	fcb->cur_row = -1;
+    }
 
     col = fcb->col_map = alloc_index(G__.window.cols);
 
@@ -0,0 +1,260 @@
+/*!
+   \file worker.c
+
+   \brief GIS library - worker threads
+
+   A small pool of threads which executes independent tasks on behalf
+   of the library and of modules. The size of the pool is taken from
+   the GRASS_WORKERS environment variable (default: no workers). When
+   GRASS is compiled without POSIX threads support or no worker is
+   available, tasks are executed by the calling thread.
+
+   (C) 2013 by the GRASS Development Team
+
+   This program is free software under the
+   GNU General Public License (>=v2).
+   Read the file COPYING that comes with GRASS
+   for details.
+ */
+
+#include <stdlib.h>
+
+#include <grass/config.h>
+#include <grass/gis.h>
+#include <grass/glocale.h>
+
+/*--------------------------------------------------------------------------*/
+
+#ifdef HAVE_PTHREAD_H
+
+#include <pthread.h>
+
+struct worker
+{
+    void (*func) (void *);
+    void *closure;
+    void **ref;
+    pthread_t thread;
+    pthread_cond_t cond;
+    int cancel;
+};
+
+static int num_workers = -1;
+static struct worker *workers;
+
+/* protects all of the above; worker_cond is signalled when a task ends */
+static pthread_mutex_t worker_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t worker_cond = PTHREAD_COND_INITIALIZER;
+
+static void *worker(void *arg)
+{
+    struct worker *w = arg;
+
+    pthread_mutex_lock(&worker_mutex);
+
+    for (;;) {
+	while (!w->func && !w->cancel)
+	    pthread_cond_wait(&w->cond, &worker_mutex);
+
+	if (w->cancel)
+	    break;
+
+	pthread_mutex_unlock(&worker_mutex);
+	(*w->func) (w->closure);
+	pthread_mutex_lock(&worker_mutex);
+
+	*w->ref = NULL;
+	w->func = NULL;
+	w->closure = NULL;
+	w->ref = NULL;
+	pthread_cond_broadcast(&worker_cond);
+    }
+
+    pthread_mutex_unlock(&worker_mutex);
+
+    return NULL;
+}
+
+/* must be called with worker_mutex locked */
+static void init_workers(void)
+{
+    const char *p;
+    int i;
+
+    if (num_workers >= 0)
+	return;
+
+    p = getenv("GRASS_WORKERS");
+    num_workers = p ? atoi(p) : 0;
+    if (num_workers < 0)
+	num_workers = 0;
+
+    workers = G_calloc(num_workers + 1, sizeof(struct worker));
+
+    for (i = 0; i < num_workers; i++) {
+	struct worker *w = &workers[i];
+
+	pthread_cond_init(&w->cond, NULL);
+	if (pthread_create(&w->thread, NULL, worker, w) != 0) {
+	    G_warning(_("Unable to start worker thread, using %d workers"),
+		      i);
+	    pthread_cond_destroy(&w->cond);
+	    num_workers = i;
+	    break;
+	}
+    }
+}
+
+static struct worker *get_worker(void)
+{
+    int i;
+
+    for (i = 0; i < num_workers; i++) {
+	struct worker *w = &workers[i];
+
+	if (!w->func)
+	    return w;
+    }
+
+    return NULL;
+}
+
+/*!
+   \brief Get number of worker threads
+
+   \return number of workers (0 if tasks are run by the caller)
+ */
+int G_num_workers(void)
+{
+    int n;
+
+    pthread_mutex_lock(&worker_mutex);
+    init_workers();
+    n = num_workers;
+    pthread_mutex_unlock(&worker_mutex);
+
+    return n;
+}
+
+/*!
+   \brief Start a task
+
+   Hands <em>func</em>(<em>closure</em>) to an idle worker. If no
+   worker is idle the task is executed at once by the calling thread,
+   unless <em>force</em> is set, in which case the caller waits for a
+   worker to become idle. <em>ref</em> identifies the task for
+   G_end_execute() and must be NULL when the task is started.
+
+   \param func task function
+   \param closure argument passed to func
+   \param ref task handle
+   \param force wait for a worker instead of running the task inline
+ */
+void G_begin_execute(void (*func) (void *), void *closure, void **ref,
+		     int force)
+{
+    struct worker *w;
+
+    if (*ref)
+	G_fatal_error(_("Task already has a worker"));
+
+    pthread_mutex_lock(&worker_mutex);
+    init_workers();
+
+    while (w = get_worker(), force && num_workers > 0 && !w)
+	pthread_cond_wait(&worker_cond, &worker_mutex);
+
+    if (!w) {
+	pthread_mutex_unlock(&worker_mutex);
+	(*func) (closure);
+	return;
+    }
+
+    *ref = w;
+    w->func = func;
+    w->closure = closure;
+    w->ref = ref;
+    pthread_cond_signal(&w->cond);
+
+    pthread_mutex_unlock(&worker_mutex);
+}
+
+/*!
+   \brief Wait for a task to finish
+
+   \param ref task handle passed to G_begin_execute()
+ */
+void G_end_execute(void **ref)
+{
+    pthread_mutex_lock(&worker_mutex);
+
+    while (*ref)
+	pthread_cond_wait(&worker_cond, &worker_mutex);
+
+    pthread_mutex_unlock(&worker_mutex);
+}
+
+/*!
+   \brief Stop all worker threads
+
+   Running tasks are finished first. Workers are started again on
+   demand by the next G_begin_execute().
+ */
+void G_finish_workers(void)
+{
+    int i, n;
+
+    pthread_mutex_lock(&worker_mutex);
+
+    /* let running tasks finish */
+    for (i = 0; i < num_workers; i++)
+	while (workers[i].func)
+	    pthread_cond_wait(&worker_cond, &worker_mutex);
+
+    for (i = 0; i < num_workers; i++) {
+	workers[i].cancel = 1;
+	pthread_cond_signal(&workers[i].cond);
+    }
+
+    n = num_workers;
+    pthread_mutex_unlock(&worker_mutex);
+
+    for (i = 0; i < n; i++) {
+	pthread_join(workers[i].thread, NULL);
+	pthread_cond_destroy(&workers[i].cond);
+    }
+
+    pthread_mutex_lock(&worker_mutex);
+    if (workers)
+	G_free(workers);
+    workers = NULL;
+    num_workers = -1;
+    pthread_mutex_unlock(&worker_mutex);
+}
+
+/*--------------------------------------------------------------------------*/
+
+#else
+
+/*--------------------------------------------------------------------------*/
+
+int G_num_workers(void)
+{
+    return 0;
+}
+
+void G_begin_execute(void (*func) (void *), void *closure, void **ref,
+		     int force)
+{
+    (*func) (closure);
+}
+
+void G_end_execute(void **ref)
+{
+}
+
+void G_finish_workers(void)
+{
+}
+
+#endif
@@ -0,0 +1,487 @@
+/****************************************************************************
+ *
+ *  MODULE:	iostream
+ *
+ *  COPYRIGHT (C) 2007 Laura Toma
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <grass/iostream/ami_stream.h>
+#include <grass/iostream/queue.h>
+#include <grass/iostream/ami_record.h>
+
+extern "C" {
+#include <grass/gis.h>
+}
+
+// The records of the C interface are not a type known at compile time,
+// so they are kept in streams of bytes, reclen bytes per record.
+
+/**********************************************************************/
+/* a sorted stream of records and its first record not yet read */
+struct record_run {
+  AMI_STREAM<char> *str;
+  char *head;
+};
+
+/* a min-heap of runs by their first records, for merging them */
+struct run_heap {
+  size_t reclen;
+  AMI_record_cmp *cmp;
+  record_run *runs;
+  int n, max;
+};
+
+
+/* the number of runs that can be merged with mem bytes, keeping a
+   buffer for the output */
+static int
+merge_arity(size_t mem) {
+  size_t arity = mem / ami_stream_buffer_usage() - 1;
+
+  if (arity < 2)
+    arity = 2;
+  if (arity > MAX_STREAMS_OPEN)
+    arity = MAX_STREAMS_OPEN;
+  return (int)arity;
+}
+
+
+/* closes a run and returns its name; as in runFormation(), the runs
+   waiting to be merged are kept by name, not as open streams */
+static char *
+close_run(AMI_STREAM<char> *str) {
+  char *name;
+
+  str->name(&name);
+  str->persist(PERSIST_PERSISTENT);
+  delete str;
+  return name;
+}
+
+
+/* writes n sorted records to a new run */
+static char *
+write_run(const char *recs, size_t n, size_t reclen) {
+  AMI_STREAM<char> *str = new AMI_STREAM<char>();
+
+  str->write_array(recs, (off_t)(n * reclen));
+  return close_run(str);
+}
+
+
+/* removes a run which is not going to be merged */
+static void
+remove_run(char *name) {
+  unlink(name);
+  delete [] name;
+}
+
+
+/* reads the next record of r; returns 0 at the end of the run */
+static int
+read_head(record_run *r, size_t reclen) {
+  AMI_err ae = r->str->read_array(r->head, (off_t)reclen);
+
+  if (ae == AMI_ERROR_END_OF_STREAM)
+    return 0;
+  if (ae != AMI_ERROR_NO_ERROR)
+    G_fatal_error("AMI: cannot read a sorted run");
+  return 1;
+}
+
+
+/**********************************************************************/
+/* the in-memory heaps of runs and of records are binary min-heaps */
+static void
+run_heap_init(run_heap *h, size_t reclen, AMI_record_cmp *cmp, int max) {
+  h->reclen = reclen;
+  h->cmp = cmp;
+  h->runs = new record_run[max];
+  h->n = 0;
+  h->max = max;
+}
+
+
+static void
+run_heap_down(run_heap *h, int i) {
+  record_run r = h->runs[i];
+  int c;
+
+  while ((c = 2 * i + 1) < h->n) {
+    if (c + 1 < h->n &&
+	h->cmp(h->runs[c + 1].head, h->runs[c].head) < 0)
+      c++;
+    if (h->cmp(h->runs[c].head, r.head) >= 0)
+      break;
+    h->runs[i] = h->runs[c];
+    i = c;
+  }
+  h->runs[i] = r;
+}
+
+
+/* opens a run and adds it; its file is removed when it is empty */
+static void
+run_heap_add(run_heap *h, char *name) {
+  record_run r;
+  int i, p;
+
+  assert(h->n < h->max);
+  r.str = new AMI_STREAM<char>(name);
+  delete [] name;
+  r.head = new char[h->reclen];
+  if (!read_head(&r, h->reclen)) {
+    delete [] r.head;
+    delete r.str;
+    return;
+  }
+
+  for (i = h->n++; i > 0; i = p) {
+    p = (i - 1) / 2;
+    if (h->cmp(h->runs[p].head, r.head) <= 0)
+      break;
+    h->runs[i] = h->runs[p];
+  }
+  h->runs[i] = r;
+}
+
+
+/* copies the smallest record to rec; returns 0 if there is none */
+static int
+run_heap_next(run_heap *h, void *rec) {
+  record_run *top = &h->runs[0];
+
+  if (h->n == 0)
+    return 0;
+
+  memcpy(rec, top->head, h->reclen);
+  if (!read_head(top, h->reclen)) {
+    delete [] top->head;
+    delete top->str;
+    *top = h->runs[--h->n];
+  }
+  if (h->n > 0)
+    run_heap_down(h, 0);
+  return 1;
+}
+
+
+/* merges all runs of h into a new run and returns its name */
+static char *
+run_heap_merge(run_heap *h) {
+  AMI_STREAM<char> *str = new AMI_STREAM<char>();
+  char *rec = new char[h->reclen];
+
+  while (run_heap_next(h, rec))
+    str->write_array(rec, (off_t)h->reclen);
+
+  delete [] rec;
+  return close_run(str);
+}
+
+
+static void
+run_heap_free(run_heap *h) {
+  int i;
+
+  for (i = 0; i < h->n; i++) {
+    delete [] h->runs[i].head;
+    delete h->runs[i].str;
+  }
+  delete [] h->runs;
+  h->runs = NULL;
+  h->n = 0;
+}
+
+
+/**********************************************************************/
+struct AMI_sorter {
+  size_t reclen;
+  AMI_record_cmp *cmp;
+  size_t mem;
+  char *recs;			/* records not yet in a run */
+  size_t n, max, next;
+  queue<char*> *runs;		/* names of the runs not yet merged */
+  run_heap merge;		/* the last merge, read by AMI_sorter_get() */
+  int sorted;
+};
+
+
+/* a sorter of records of reclen bytes keeping mem bytes in memory */
+struct AMI_sorter *
+AMI_sorter_create(size_t reclen, AMI_record_cmp *cmp, size_t mem) {
+  AMI_sorter *s = new AMI_sorter;
+
+  s->reclen = reclen;
+  s->cmp = cmp;
+  s->mem = mem;
+  s->max = mem / reclen;
+  if (s->max < 1)
+    s->max = 1;
+  s->recs = new char[s->max * reclen];
+  s->n = s->next = 0;
+  s->runs = new queue<char*>();
+  s->merge.runs = NULL;
+  s->merge.n = 0;
+  s->sorted = 0;
+  return s;
+}
+
+
+void
+AMI_sorter_put(struct AMI_sorter *s, const void *rec) {
+  char *name;
+
+  if (s->sorted)
+    G_fatal_error("AMI_sorter_put: the records have been sorted");
+
+  if (s->n == s->max) {
+    qsort(s->recs, s->n, s->reclen, s->cmp);
+    name = write_run(s->recs, s->n, s->reclen);
+    s->runs->enqueue(name);
+    s->n = 0;
+  }
+  memcpy(s->recs + s->n * s->reclen, rec, s->reclen);
+  s->n++;
+}
+
+
+/* sorts the records put so far; the records which did not fit into
+   memory are merged, as many runs at a time as the memory allows, the
+   last merge is done while the records are read back */
+void
+AMI_sorter_sort(struct AMI_sorter *s) {
+  char *name;
+  int arity, i;
+
+  if (s->sorted)
+    G_fatal_error("AMI_sorter_sort: the records have been sorted");
+  s->sorted = 1;
+
+  qsort(s->recs, s->n, s->reclen, s->cmp);
+  if (s->runs->length() == 0)
+    return;
+
+  if (s->n > 0) {
+    name = write_run(s->recs, s->n, s->reclen);
+    s->runs->enqueue(name);
+  }
+  delete [] s->recs;
+  s->recs = NULL;
+
+  arity = merge_arity(s->mem);
+  while (s->runs->length() > (unsigned int)arity) {
+    run_heap_init(&s->merge, s->reclen, s->cmp, arity);
+    for (i = 0; i < arity; i++) {
+      s->runs->dequeue(&name);
+      run_heap_add(&s->merge, name);
+    }
+    name = run_heap_merge(&s->merge);
+    s->runs->enqueue(name);
+    run_heap_free(&s->merge);
+  }
+
+  run_heap_init(&s->merge, s->reclen, s->cmp, arity);
+  while (s->runs->dequeue(&name))
+    run_heap_add(&s->merge, name);
+}
+
+
+/* copies the next record in order to rec; returns 0 after the last */
+int
+AMI_sorter_get(struct AMI_sorter *s, void *rec) {
+  if (!s->sorted)
+    G_fatal_error("AMI_sorter_get: the records have not been sorted");
+
+  if (s->recs) {
+    if (s->next == s->n)
+      return 0;
+    memcpy(rec, s->recs + s->next * s->reclen, s->reclen);
+    s->next++;
+    return 1;
+  }
+
+  return run_heap_next(&s->merge, rec);
+}
+
+
+void
+AMI_sorter_destroy(struct AMI_sorter *s) {
+  char *name;
+
+  while (s->runs->dequeue(&name))
+    remove_run(name);
+  delete s->runs;
+  if (s->merge.runs)
+    run_heap_free(&s->merge);
+  delete [] s->recs;
+  delete s;
+}
+
+
+/**********************************************************************/
+/* The queue keeps a heap of records in memory. When it is full, its
+   larger half is written to a sorted run; the smallest record is then
+   either at the top of the heap or the first one of a run. When there
+   are more runs than can be read at a time, they are merged into one. */
+struct AMI_pqueue {
+  size_t reclen;
+  AMI_record_cmp *cmp;
+  char *recs;			/* heap of records */
+  size_t n, max;
+  char *tmp;
+  run_heap runs;
+  long size;
+};
+
+
+static void
+rec_swap(AMI_pqueue *q, size_t i, size_t j) {
+  char *a = q->recs + i * q->reclen, *b = q->recs + j * q->reclen;
+
+  memcpy(q->tmp, a, q->reclen);
+  memcpy(a, b, q->reclen);
+  memcpy(b, q->tmp, q->reclen);
+}
+
+
+static char *
+rec_at(AMI_pqueue *q, size_t i) {
+  return q->recs + i * q->reclen;
+}
+
+
+/* writes the larger half of the records to a run */
+static void
+pqueue_spill(AMI_pqueue *q) {
+  size_t half = q->n / 2;
+  char *name;
+
+  /* a sorted array is a heap too */
+  qsort(q->recs, q->n, q->reclen, q->cmp);
+  name = write_run(rec_at(q, half), q->n - half, q->reclen);
+  q->n = half;
+
+  if (q->runs.n == q->runs.max)
+    run_heap_add(&q->runs, run_heap_merge(&q->runs));
+  run_heap_add(&q->runs, name);
+}
+
+
+/* a priority queue of records of reclen bytes; the heap of records
+   takes half of the mem bytes, the buffers of the runs the other */
+struct AMI_pqueue *
+AMI_pqueue_create(size_t reclen, AMI_record_cmp *cmp, size_t mem) {
+  AMI_pqueue *q = new AMI_pqueue;
+
+  q->reclen = reclen;
+  q->cmp = cmp;
+  q->max = mem / 2 / reclen;
+  if (q->max < 2)
+    q->max = 2;
+  q->recs = new char[q->max * reclen];
+  q->n = 0;
+  q->tmp = new char[reclen];
+  run_heap_init(&q->runs, reclen, cmp, merge_arity(mem / 2));
+  q->size = 0;
+  return q;
+}
+
+
+void
+AMI_pqueue_insert(struct AMI_pqueue *q, const void *rec) {
+  size_t i, p;
+
+  if (q->n == q->max)
+    pqueue_spill(q);
+
+  memcpy(rec_at(q, q->n), rec, q->reclen);
+  for (i = q->n++; i > 0; i = p) {
+    p = (i - 1) / 2;
+    if (q->cmp(rec_at(q, p), rec_at(q, i)) <= 0)
+      break;
+    rec_swap(q, i, p);
+  }
+  q->size++;
+}
+
+
+/* the smallest record, or NULL if the queue is empty */
+static char *
+pqueue_top(AMI_pqueue *q) {
+  char *a = q->n > 0 ? q->recs : NULL;
+  char *b = q->runs.n > 0 ? q->runs.runs[0].head : NULL;
+
+  if (a && b)
+    return q->cmp(b, a) < 0 ? b : a;
+  return a ? a : b;
+}
+
+
+/* copies the smallest record to rec; returns 0 if the queue is empty */
+int
+AMI_pqueue_min(struct AMI_pqueue *q, void *rec) {
+  char *top = pqueue_top(q);
+
+  if (!top)
+    return 0;
+  memcpy(rec, top, q->reclen);
+  return 1;
+}
+
+
+/* as AMI_pqueue_min(), and removes the record from the queue */
+int
+AMI_pqueue_extract_min(struct AMI_pqueue *q, void *rec) {
+  char *top = pqueue_top(q);
+  size_t i, c;
+
+  if (!top)
+    return 0;
+  q->size--;
+
+  if (top != q->recs)
+    return run_heap_next(&q->runs, rec);
+
+  memcpy(rec, top, q->reclen);
+  if (--q->n > 0)
+    memcpy(q->recs, rec_at(q, q->n), q->reclen);
+  for (i = 0; (c = 2 * i + 1) < q->n; i = c) {
+    if (c + 1 < q->n && q->cmp(rec_at(q, c + 1), rec_at(q, c)) < 0)
+      c++;
+    if (q->cmp(rec_at(q, c), rec_at(q, i)) >= 0)
+      break;
+    rec_swap(q, i, c);
+  }
+  return 1;
+}
+
+
+long
+AMI_pqueue_size(const struct AMI_pqueue *q) {
+  return q->size;
+}
+
+
+void
+AMI_pqueue_destroy(struct AMI_pqueue *q) {
+  run_heap_free(&q->runs);
+  delete [] q->recs;
+  delete [] q->tmp;
+  delete q;
+}
@@ -0,0 +1,148 @@
+/****************************************************************************
+ *
+ *  MODULE:	iostream
+ *
+ *  COPYRIGHT (C) 2007 Laura Toma
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *****************************************************************************/
+
+/* Tests the C interface of ami_record.cc: sorts and queues n records
+   keeping mem bytes in memory, and checks that they come out in order
+   and that none is lost. The defaults give the sorter 16 runs merged 3
+   at a time, so that the runs are merged in several passes, and make
+   the queue merge its runs as well.
+
+   usage: ami_record_test [n [mem]]	(make test) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <grass/iostream/ami_record.h>
+
+struct rec
+{
+    int key;
+    int seq;
+};
+
+static int cmp(const void *a, const void *b)
+{
+    const struct rec *x = a, *y = b;
+
+    return x->key < y->key ? -1 : x->key > y->key;
+}
+
+/* the keys 0 .. (n - 1) / 2 in a scrambled order, each one twice */
+static int key_of(long i, long n)
+{
+    return (int)((long long)i * 7919 % n / 2);
+}
+
+/* checks that the records come out as the keys in order, and that the
+   sequence numbers add up to those put in */
+static int check(const char *what, const struct rec *r, long i,
+		 long long *sum)
+{
+    if (r->key != (int)(i / 2)) {
+	fprintf(stderr, "%s: record %ld has key %d, not %ld\n",
+		what, i, r->key, i / 2);
+	return 0;
+    }
+    *sum += r->seq;
+    return 1;
+}
+
+static int test_sorter(long n, size_t mem)
+{
+    struct AMI_sorter *s = AMI_sorter_create(sizeof(struct rec), cmp, mem);
+    struct rec r;
+    long long sum = 0;
+    long i;
+    int ok = 1;
+
+    for (i = 0; i < n; i++) {
+	r.key = key_of(i, n);
+	r.seq = (int)i;
+	AMI_sorter_put(s, &r);
+    }
+    AMI_sorter_sort(s);
+
+    for (i = 0; ok && AMI_sorter_get(s, &r); i++)
+	ok = check("sorter", &r, i, &sum);
+    AMI_sorter_destroy(s);
+
+    if (ok && (i != n || sum != (long long)n * (n - 1) / 2)) {
+	fprintf(stderr, "sorter: %ld of %ld records came out\n", i, n);
+	ok = 0;
+    }
+    return ok;
+}
+
+/* inserts the records, extracting one of every three on the way, then
+   extracts the rest; the extracted keys must not decrease */
+static int test_pqueue(long n, size_t mem)
+{
+    struct AMI_pqueue *q = AMI_pqueue_create(sizeof(struct rec), cmp, mem);
+    struct rec r, m;
+    long i, out = 0;
+    int last = -1;
+    int ok = 1;
+
+    for (i = 0; ok && i < n; i++) {
+	r.key = key_of(i, n);
+	r.seq = (int)i;
+	AMI_pqueue_insert(q, &r);
+	if (i % 3 == 2) {
+	    AMI_pqueue_min(q, &m);
+	    AMI_pqueue_extract_min(q, &r);
+	    if (r.key != m.key) {
+		fprintf(stderr, "pqueue: min %d but extracted %d\n",
+			m.key, r.key);
+		ok = 0;
+	    }
+	    out++;
+	}
+    }
+    if (ok && AMI_pqueue_size(q) != n - out) {
+	fprintf(stderr, "pqueue: size %ld, not %ld\n",
+		AMI_pqueue_size(q), n - out);
+	ok = 0;
+    }
+
+    for (; ok && AMI_pqueue_extract_min(q, &r); out++) {
+	if (r.key < last) {
+	    fprintf(stderr, "pqueue: key %d after %d\n", r.key, last);
+	    ok = 0;
+	}
+	last = r.key;
+    }
+    AMI_pqueue_destroy(q);
+
+    if (ok && out != n) {
+	fprintf(stderr, "pqueue: %ld of %ld records came out\n", out, n);
+	ok = 0;
+    }
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    long n = argc > 1 ? atol(argv[1]) : 2000000;
+    size_t mem = argc > 2 ? (size_t) atol(argv[2]) : 1 << 20;
+    int ok;
+
+    ok = test_sorter(n, mem);
+    ok = test_pqueue(n, mem) && ok;
+
+    fprintf(stdout, "%s\n", ok ? "ok" : "failed");
+    return ok ? 0 : 1;
+}
@@ -45,6 +45,91 @@ const char *ami_str_error[] = {
   "AMI_ERROR_NO_MAIN_MEMORY_OPERATION",
 };
 
+/**********************************************************************/
+/* the page size, to which the stream buffers are aligned */
+static size_t
+ami_stream_page_size() {
+  static size_t page = 0;
+
+  if (page)
+    return page;
+
+#ifdef _SC_PAGESIZE
+  if (sysconf(_SC_PAGESIZE) > 0)
+    page = sysconf(_SC_PAGESIZE);
+  else
+#endif
+    page = 4096;
+
+  return page;
+}
+
+
+/**********************************************************************/
+/* size of the stream buffers: STREAM_BUFFER_SIZE, or the number of
+   bytes given by the environment variable STREAM_BUFFER_ENV, rounded
+   up to whole pages. large buffers mean fewer and larger reads and
+   writes, but also a smaller merge arity for a given memory size */
+size_t
+ami_stream_buffer_size() {
+  static size_t size = 0;
+  size_t page = ami_stream_page_size();
+  char *env;
+
+  if (size)
+    return size;
+
+  size = STREAM_BUFFER_SIZE;
+  env = getenv(STREAM_BUFFER_ENV);
+  if (env && atol(env) > 0)
+    size = atol(env);
+
+  size = (size + page - 1) / page * page;
+  return size;
+}
+
+
+/* the buffers are allocated one page larger so that they can be
+   aligned, and with new[] so that MM_manager accounts for them */
+size_t
+ami_stream_buffer_usage() {
+  return ami_stream_buffer_size() + ami_stream_page_size();
+}
+
+
+/**********************************************************************/
+/* allocates a page aligned buffer of ami_stream_buffer_size() bytes
+   for fp and tells the kernel that the file is read sequentially, so
+   that it reads ahead while the buffer is being used */
+char *
+ami_stream_buffer(FILE *fp, const char *path, char **block) {
+  size_t size = ami_stream_buffer_size();
+  size_t page = ami_stream_page_size();
+  char *buf;
+
+  *block = new char[size + page];
+  buf = *block + (page - (size_t)*block % page) % page;
+
+  if (setvbuf(fp, buf, _IOFBF, size) != 0) {
+    cerr << "ERROR: setvbuf failed (stream " << path << ") with: "
+         << strerror(errno) << endl;
+    exit(1);
+  }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(fileno(fp), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+  return buf;
+}
+
+
+void
+ami_stream_free_buffer(char *block) {
+  delete [] block;
+}
+
+
 /**********************************************************************/
 /* creates a random file name, opens the file for reading and writing
    and and returns a file descriptor */
@@ -54,13 +139,12 @@ ami_single_temp_name(const std::string& base, char* tmp_path) {
   char *base_dir;
   int fd;
 
-  // get the dir
+  // get the dir; modules other than r.terraflow need not set it
   base_dir = getenv(STREAM_TMPDIR);
-  if(!base_dir) {
-	fprintf(stderr, "ami_stream: %s not set\n", STREAM_TMPDIR);
-	assert(base_dir);
-	exit(1);
-  }
+  if(!base_dir)
+	base_dir = getenv("TMPDIR");
+  if(!base_dir)
+	base_dir = (char *)"/tmp";
   sprintf(tmp_path, "%s/%s_XXXXXX", base_dir, base.c_str());
 
 #ifdef __MINGW32__
@@ -7,9 +7,10 @@ void rowio_forget(ROWIO * R, int row)
     if (row < 0)
 	return;
 
-    for (i = 0; i < R->nrows; i++)
-	if (row == R->rcb[i].row) {
-	    R->rcb[i].row = -1;	/* no longer in memory */
-	    break;
-	}
+    i = row % R->nrows;
+    if (row == R->rcb[i].row) {
+	R->rcb[i].row = -1;	/* no longer in memory */
+	if (row == R->cur)
+	    R->cur = -1;
+    }
 }
@@ -18,6 +18,11 @@ static void pageout(ROWIO *, int);
  * <i>rowio_setup</i> is called first to write the changed row to disk. If row
  * <b>n</b> is already in memory, no disk read is done. The pointer to the data
  * is simply returned.
+ * The buffers are used as a ring: row <b>n</b> is kept in buffer <b>n</b>
+ * modulo the number of rows given to <i>rowio_setup</i>, so the lookup
+ * takes constant time and any that many consecutive rows (e.g. rows
+ * r-k to r+k of a moving window) are in memory together. The pointer
+ * returned remains valid until the buffer is used for another row.
  * Return codes:
  * NULL <b>n</b> is negative, or
  * <b>getrow()</b> returned 0 (indicating an error condition).
@@ -30,8 +35,6 @@ static void pageout(ROWIO *, int);
 
 void *rowio_get(ROWIO * R, int row)
 {
-    int i;
-    int age;
     int cur;
 
     if (row < 0)
@@ -40,31 +43,22 @@ void *rowio_get(ROWIO * R, int row)
     if (row == R->cur)
 	return R->buf;
 
-    for (i = 0; i < R->nrows; i++)
-	if (row == R->rcb[i].row)
-	    return my_select(R, i);
-
-    age = 0;
-    cur = 0;
+    /* the buffers form a ring indexed by row number, so that any
+       R->nrows consecutive rows are held at the same time */
+    cur = row % R->nrows;
 
-    for (i = 0; i < R->nrows; i++)
-	if (R->rcb[i].row < 0) {	/* free slot ! */
-	    cur = i;
-	    break;
-	}
-	else if (age < R->rcb[i].age) {
-	    cur = i;
-	    age = R->rcb[i].age;
-	}
+    if (row == R->rcb[cur].row)
+	return my_select(R, cur);
 
     pageout(R, cur);
 
-    i = (*R->getrow) (R->fd, R->rcb[cur].buf, R->rcb[cur].row = row, R->len);
+    if (R->rcb[cur].row == R->cur)
+	R->cur = -1;
+
+    R->rcb[cur].row = row;
     R->rcb[cur].dirty = 0;
-    if (!i) {
+    if (!(*R->getrow) (R->fd, R->rcb[cur].buf, row, R->len)) {
 	R->rcb[cur].row = -1;
-	if (cur == R->cur)
-	    R->cur = -1;
 	return NULL;
     }
 
@@ -91,11 +85,6 @@ static void pageout(ROWIO * R, int cur)
 
 static void *my_select(ROWIO * R, int n)
 {
-    int i;
-
-    R->rcb[n].age = 0;
-    for (i = 0; i < R->nrows; i++)
-	R->rcb[i].age++;
     R->cur = R->rcb[n].row;
     R->buf = R->rcb[n].buf;
     return R->buf;
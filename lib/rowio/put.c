@@ -31,11 +31,11 @@ int rowio_put(ROWIO * R, const void *buf, int row)
     if (row < 0)
 	return 0;
 
-    for (i = 0; i < R->nrows; i++)
-	if (row == R->rcb[i].row) {
-	    memcpy(R->rcb[i].buf, buf, R->len);
-	    R->rcb[i].dirty = 1;
-	    return 1;
-	}
+    i = row % R->nrows;
+    if (row == R->rcb[i].row) {
+	memcpy(R->rcb[i].buf, buf, R->len);
+	R->rcb[i].dirty = 1;
+	return 1;
+    }
     return ((*R->putrow) (R->fd, buf, row, R->len));
 }
@@ -12,7 +12,14 @@
  * \date 2005-2006
  */
 
+#include <stdlib.h>
+#include <grass/gis.h>
 #include <grass/segment.h>
+#include "local_proto.h"
+
+
+static int compare_slots(const void *, const void *);
+static const SEGMENT *sort_seg;
 
 
 /**
@@ -24,6 +31,7 @@
  * written to the segment file <b>seg</b>. Must be called after the 
  * final <i>segment_put()</i> to force all pending updates to disk. Must 
  * also be called before the first call to <i>segment_get_row</i>.
+ * Segments are written in the order of the file.
  *
  * \param[in] seg segment
  * \return always returns 0
@@ -31,11 +39,36 @@
 
 int segment_flush(SEGMENT * SEG)
 {
-    int i;
+    int *slots;
+    int i, count;
+
+    seg_sync_writes(SEG);
+
+    if (SEG->nseg == 0)
+	return 0;
 
-    for (i = 0; i < SEG->nseg; i++)
+    slots = G_malloc(SEG->nseg * sizeof(int));
+
+    for (i = count = 0; i < SEG->nseg; i++)
 	if (SEG->scb[i].n >= 0 && SEG->scb[i].dirty)
-	    segment_pageout(SEG, i);
+	    slots[count++] = i;
+
+    sort_seg = SEG;
+    qsort(slots, count, sizeof(int), compare_slots);
+
+    for (i = 0; i < count; i++)
+	segment_pageout(SEG, slots[i]);
+
+    G_free(slots);
 
     return 0;
 }
+
+
+static int compare_slots(const void *a, const void *b)
+{
+    int na = sort_seg->scb[*(const int *)a].n;
+    int nb = sort_seg->scb[*(const int *)b].n;
+
+    return na - nb;
+}
@@ -43,6 +43,12 @@ int segment_get(SEGMENT * SEG, void *buf, int row, int col)
     int index, n, i;
 
     segment_address(SEG, row, col, &n, &index);
+
+    if (SEG->map) {
+	memcpy(buf, &SEG->map[(off_t) n * SEG->size + index], SEG->len);
+	return 1;
+    }
+
     if ((i = segment_pagein(SEG, n)) < 0)
 	return -1;
 
@@ -17,6 +17,7 @@
 #include <string.h>
 #include <errno.h>
 #include <grass/segment.h>
+#include "local_proto.h"
 
 
 /**
@@ -50,6 +51,20 @@ int segment_get_row(const SEGMENT * SEG, void *buf, int row)
     scols = SEG->scols;
     size = scols * SEG->len;
 
+    if (SEG->map) {
+	for (col = 0; col < SEG->ncols; col += scols) {
+	    if (col == ncols)
+		size = SEG->spill * SEG->len;
+	    segment_address(SEG, row, col, &n, &index);
+	    memcpy(buf, &SEG->map[(off_t) n * SEG->size + index], size);
+	    buf = ((char *)buf) + size;
+	}
+	return 1;
+    }
+
+    if (seg_sync_writes(SEG) < 0)
+	return -1;
+
     for (col = 0; col < ncols; col += scols) {
 	segment_address(SEG, row, col, &n, &index);
 	if (segment_seek(SEG, n, index) < 0)
@@ -23,6 +23,7 @@
 #include <grass/segment.h>
 
 
+static int read_header(SEGMENT *, int, int);
 static int read_int(int, int *);
 
 /* fd must be open for read and write */
@@ -54,6 +55,48 @@ static int read_int(int, int *);
  */
 
 int segment_init(SEGMENT * SEG, int fd, int nseg)
+{
+    if (read_header(SEG, fd, nseg) < 0)
+	return -1;
+
+    return segment_setup(SEG);
+}
+
+
+/**
+ * \fn int segment_init_mmap (SEGMENT *SEG, int fd, int nseg)
+ *
+ * \brief Initialize segment structure with the segment file mapped.
+ *
+ * Like <i>segment_init()</i>, but the segment file is mapped into
+ * memory. <i>segment_get()</i> and <i>segment_put()</i> then access the
+ * mapped file directly, and the system keeps as much of it in memory
+ * as there is room for, writing the rest back to the file. The file
+ * must not be resized while it is mapped.
+ *
+ * If the file can not be mapped (e.g. it is larger than the address
+ * space), <b>nseg</b> segments are kept in memory as with
+ * <i>segment_init()</i>.
+ *
+ * \param[in,out] seg segment
+ * \param[in] fd file descriptor
+ * \param[in] nsegs number of segments to remain in memory if the file
+ * can not be mapped
+ * \return 1 if successful
+ * \return -1 if unable to seek or read segment file
+ * \return -2 if out of memory
+ */
+
+int segment_init_mmap(SEGMENT * SEG, int fd, int nseg)
+{
+    if (read_header(SEG, fd, nseg) < 0)
+	return -1;
+
+    return segment_setup_mmap(SEG);
+}
+
+
+static int read_header(SEGMENT * SEG, int fd, int nseg)
 {
     SEG->open = 0;
     SEG->fd = fd;
@@ -72,7 +115,7 @@ int segment_init(SEGMENT * SEG, int fd, int nseg)
 	|| !read_int(fd, &SEG->len))
 	return -1;
 
-    return segment_setup(SEG);
+    return 0;
 }
 
 
@@ -0,0 +1,13 @@
+#ifndef SEGMENT_LOCAL_PROTO_H
+#define SEGMENT_LOCAL_PROTO_H
+
+#include <grass/segment.h>
+
+/* pageout.c */
+int seg_writer_init(SEGMENT *);
+void seg_writer_free(SEGMENT *);
+int seg_pageout_deferred(SEGMENT *, int);
+int seg_pagein_pending(SEGMENT *, int, char *);
+int seg_sync_writes(const SEGMENT *);
+
+#endif
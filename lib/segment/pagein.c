@@ -17,6 +17,7 @@
 #include <string.h>
 #include <errno.h>
 #include <grass/segment.h>
+#include "local_proto.h"
 
 
 static int segment_select(SEGMENT *, int);
@@ -30,6 +31,11 @@ static int segment_select(SEGMENT *, int);
  * Finds <b>n</b> in the segment file, <b>seg</b>, and selects it as the 
  * current segment.
  *
+ * Segments in memory are found through a table indexed by segment
+ * number. If <b>n</b> is not in memory, a slot is chosen with the
+ * CLOCK algorithm: slots are visited in turn, a slot accessed since
+ * the last visit is spared once, the first other one is reused.
+ *
  * \param[in] seg segment
  * \param[in] n segment number
  * \return 1 if successful
@@ -38,44 +44,53 @@ static int segment_select(SEGMENT *, int);
 
 int segment_pagein(SEGMENT * SEG, int n)
 {
-    int age;
     int cur;
-    int i;
     int read_result;
 
     /* is n the current segment? */
-    if (n == SEG->scb[SEG->cur].n)
+    if (n == SEG->scb[SEG->cur].n) {
+	SEG->hits++;
 	return SEG->cur;
+    }
+
+    /* is n in memory? */
+    if (SEG->load_idx[n] >= 0) {
+	SEG->hits++;
+	return segment_select(SEG, SEG->load_idx[n]);
+    }
 
-    /* search the in memory segments */
-    for (i = 0; i < SEG->nseg; i++)
-	if (n == SEG->scb[i].n)
-	    return segment_select(SEG, i);
+    SEG->misses++;
 
     /* find a slot to use to hold segment */
-    age = 0;
-    cur = 0;
-    for (i = 0; i < SEG->nseg; i++)
-	if (SEG->scb[i].n < 0) {	/* free slot */
-	    cur = i;
+    for (;;) {
+	cur = SEG->hand;
+	SEG->hand = (cur + 1) % SEG->nseg;
+
+	if (SEG->scb[cur].n < 0)	/* free slot */
+	    break;
+	if (!SEG->scb[cur].age)	/* not accessed since the last visit */
 	    break;
-	}
-	else if (age < SEG->scb[i].age) {	/* find oldest segment */
-	    cur = i;
-	    age = SEG->scb[i].age;
-	}
-
-    /* if slot is used, write it out, if dirty */
-    if (SEG->scb[cur].n >= 0 && SEG->scb[cur].dirty)
-	if (segment_pageout(SEG, cur) < 0)
+	SEG->scb[cur].age = 0;
+    }
+
+    /* if slot is used, queue it for writing, if dirty */
+    if (SEG->scb[cur].n >= 0) {
+	if (SEG->scb[cur].dirty && seg_pageout_deferred(SEG, cur) < 0)
 	    return -1;
+	SEG->load_idx[SEG->scb[cur].n] = -1;
+    }
 
-    /* read in the segment */
+    /* read in the segment, unless it is still waiting to be written */
     SEG->scb[cur].n = n;
     SEG->scb[cur].dirty = 0;
-    segment_seek(SEG, SEG->scb[cur].n, 0);
 
-    read_result = read(SEG->fd, SEG->scb[cur].buf, SEG->size);
+    if (seg_pagein_pending(SEG, n, SEG->scb[cur].buf))
+	read_result = SEG->size;
+    else {
+	segment_seek(SEG, SEG->scb[cur].n, 0);
+	read_result = read(SEG->fd, SEG->scb[cur].buf, SEG->size);
+    }
+
     if (read_result != SEG->size) {
 	G_debug(2, "segment_pagein: read_result=%d  SEG->size=%d",
 		read_result, SEG->size);
@@ -89,20 +104,19 @@ int segment_pagein(SEGMENT * SEG, int n)
 		("segment_pagein: short count during read(), got %d, expected %d",
 		 read_result, SEG->size);
 
+	SEG->scb[cur].n = -1;
 	return -1;
     }
 
+    SEG->load_idx[n] = cur;
+
     return segment_select(SEG, cur);
 }
 
 
 static int segment_select(SEGMENT * SEG, int n)
 {
-    int i;
-
-    SEG->scb[n].age = 0;
-    for (i = 0; i < SEG->nseg; i++)
-	SEG->scb[i].age++;
+    SEG->scb[n].age = 1;
 
     return SEG->cur = n;
 }
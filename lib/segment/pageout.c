@@ -13,10 +13,43 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <grass/gis.h>
 #include <grass/segment.h>
+#include "local_proto.h"
+
+
+/* Dirty segments evicted by segment_pagein() are not written at once
+ * but copied into a batch. A full batch is sorted by segment number,
+ * i.e. by file offset, and written by a worker thread (see
+ * G_begin_execute()) while the next batch is filled. Without workers
+ * the batch is written by the caller, still in file order.
+ */
+
+struct page
+{
+    int n;			/* segment number */
+    char *buf;			/* copy of the segment */
+};
+
+struct batch
+{
+    const SEGMENT *seg;
+    int count;			/* pages in the batch */
+    struct page *pages;
+    int error;			/* set by write_batch() */
+    void *ref;			/* task writing the batch */
+};
+
+struct segment_writer
+{
+    int max;			/* pages per batch */
+    int cur;			/* batch being filled */
+    struct batch batch[2];
+};
 
 
 /**
@@ -44,3 +77,220 @@ int segment_pageout(SEGMENT * SEG, int i)
 
     return 1;
 }
+
+
+static int write_page(const SEGMENT * SEG, int n, const char *buf)
+{
+    off_t offset = (off_t) n * SEG->size + SEG->offset;
+
+#ifndef __MINGW32__
+    /* pwrite() leaves the file position to the thread reading pages */
+    if (pwrite(SEG->fd, buf, SEG->size, offset) != SEG->size)
+	return -1;
+#else
+    if (lseek(SEG->fd, offset, SEEK_SET) == (off_t) - 1 ||
+	write(SEG->fd, buf, SEG->size) != SEG->size)
+	return -1;
+#endif
+
+    return 0;
+}
+
+
+static void write_batch(void *closure)
+{
+    struct batch *b = closure;
+    int i;
+
+    for (i = 0; i < b->count; i++)
+	if (write_page(b->seg, b->pages[i].n, b->pages[i].buf) < 0)
+	    b->error = errno ? errno : EIO;
+}
+
+
+static int compare_pages(const void *a, const void *b)
+{
+    return ((const struct page *)a)->n - ((const struct page *)b)->n;
+}
+
+
+/* waits for the batch and empties it */
+static int finish_batch(struct batch *b)
+{
+    int error;
+
+    G_end_execute(&b->ref);
+
+    error = b->error;
+    b->error = 0;
+    b->count = 0;
+
+    if (error) {
+	G_warning("segment_pageout: %s", strerror(error));
+	return -1;
+    }
+
+    return 0;
+}
+
+
+static int start_batch(struct batch *b, int wait)
+{
+    if (b->count == 0)
+	return 0;
+
+    qsort(b->pages, b->count, sizeof(struct page), compare_pages);
+
+    if (wait) {
+	write_batch(b);
+	return finish_batch(b);
+    }
+
+    G_begin_execute(write_batch, b, &b->ref, 0);
+
+    return 0;
+}
+
+
+/* the two batches take their pages from the nseg segments allowed in
+   memory: a quarter of them, up to 32 pages per batch. with fewer
+   segments all of them are left to the cache and evicted segments are
+   written at once. */
+#define MIN_WRITER_SEGS 16
+
+int seg_writer_init(SEGMENT * SEG)
+{
+    struct segment_writer *w;
+    int i, j;
+
+    if (SEG->nseg < MIN_WRITER_SEGS) {
+	SEG->writer = NULL;
+	return 0;
+    }
+
+    w = G_malloc(sizeof(struct segment_writer));
+
+    w->max = SEG->nseg / 8;
+    if (w->max > 32)
+	w->max = 32;
+    w->cur = 0;
+    SEG->nseg -= 2 * w->max;
+
+    for (i = 0; i < 2; i++) {
+	struct batch *b = &w->batch[i];
+
+	b->seg = SEG;
+	b->count = 0;
+	b->error = 0;
+	b->ref = NULL;
+	b->pages = G_malloc(w->max * sizeof(struct page));
+	for (j = 0; j < w->max; j++)
+	    b->pages[j].buf = G_malloc(SEG->size);
+    }
+
+    SEG->writer = w;
+
+    return 0;
+}
+
+
+void seg_writer_free(SEGMENT * SEG)
+{
+    struct segment_writer *w = SEG->writer;
+    int i, j;
+
+    if (!w)
+	return;
+
+    for (i = 0; i < 2; i++) {
+	for (j = 0; j < w->max; j++)
+	    G_free(w->batch[i].pages[j].buf);
+	G_free(w->batch[i].pages);
+    }
+
+    G_free(w);
+    SEG->writer = NULL;
+}
+
+
+/* queues the dirty segment in slot i for writing */
+int seg_pageout_deferred(SEGMENT * SEG, int i)
+{
+    struct segment_writer *w = SEG->writer;
+    struct batch *b;
+    int n = SEG->scb[i].n;
+    int j;
+
+    if (!w)
+	return segment_pageout(SEG, i);
+
+    b = &w->batch[w->cur];
+
+    /* a newer copy replaces one still queued */
+    for (j = 0; j < b->count; j++)
+	if (b->pages[j].n == n)
+	    break;
+
+    if (j == b->count) {
+	if (b->count == w->max) {
+	    /* the other batch must be on disk before this one is written */
+	    struct batch *next = &w->batch[1 - w->cur];
+
+	    if (finish_batch(next) < 0 || start_batch(b, 0) < 0)
+		return -1;
+
+	    w->cur = 1 - w->cur;
+	    b = next;
+	    j = 0;
+	}
+	b->count++;
+    }
+
+    b->pages[j].n = n;
+    memcpy(b->pages[j].buf, SEG->scb[i].buf, SEG->size);
+    SEG->scb[i].dirty = 0;
+
+    return 1;
+}
+
+
+/* copies segment n into buf if it is queued for writing */
+int seg_pagein_pending(SEGMENT * SEG, int n, char *buf)
+{
+    struct segment_writer *w = SEG->writer;
+    int i, j;
+
+    if (!w)
+	return 0;
+
+    /* the batch being filled holds the newest copies */
+    for (i = 0; i < 2; i++) {
+	struct batch *b = &w->batch[i == 0 ? w->cur : 1 - w->cur];
+
+	for (j = 0; j < b->count; j++)
+	    if (b->pages[j].n == n) {
+		memcpy(buf, b->pages[j].buf, SEG->size);
+		return 1;
+	    }
+    }
+
+    return 0;
+}
+
+
+/* writes all queued segments */
+int seg_sync_writes(const SEGMENT * SEG)
+{
+    struct segment_writer *w = SEG->writer;
+    int stat = 0;
+
+    if (!w)
+	return 0;
+
+    if (finish_batch(&w->batch[1 - w->cur]) < 0)
+	stat = -1;
+    if (start_batch(&w->batch[w->cur], 1) < 0)
+	stat = -1;
+
+    return stat;
+}
@@ -46,6 +46,12 @@ int segment_put(SEGMENT * SEG, const void *buf, int row, int col)
     int index, n, i;
 
     segment_address(SEG, row, col, &n, &index);
+
+    if (SEG->map) {
+	memcpy(&SEG->map[(off_t) n * SEG->size + index], buf, SEG->len);
+	return 1;
+    }
+
     if ((i = segment_pagein(SEG, n)) < 0)
 	return -1;
 
@@ -18,6 +18,7 @@
 #include <unistd.h>
 #include <grass/segment.h>
 #include <grass/gis.h>
+#include "local_proto.h"
 
 
 /*      buf is CELL *   WRAT code       */
@@ -54,6 +55,21 @@ int segment_put_row(const SEGMENT * SEG, const void *buf, int row)
     ncols = SEG->ncols - SEG->spill;
     scols = SEG->scols;
     size = scols * SEG->len;
+
+    if (SEG->map) {
+	for (col = 0; col < SEG->ncols; col += scols) {
+	    if (col == ncols)
+		size = SEG->spill * SEG->len;
+	    segment_address(SEG, row, col, &n, &index);
+	    memcpy(&SEG->map[(off_t) n * SEG->size + index], buf, size);
+	    buf = ((const char *)buf) + size;
+	}
+	return 1;
+    }
+
+    /* queued segments must not overwrite the row later */
+    if (seg_sync_writes(SEG) < 0)
+	return -1;
     /*      printf("segment_put_row ncols: %d, scols %d, size: %d, col %d, row: %d,  SEG->fd: %d\n",ncols,scols,size,col,row, SEG->fd); */
 
     for (col = 0; col < ncols; col += scols) {
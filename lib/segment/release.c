@@ -14,6 +14,10 @@
 
 #include <stdlib.h>
 #include <grass/segment.h>
+#include "local_proto.h"
+#ifndef __MINGW32__
+#include <sys/mman.h>
+#endif
 
 
 /**
@@ -39,9 +43,24 @@ int segment_release(SEGMENT * SEG)
     if (SEG->open != 1)
 	return -1;
 
+    G_debug(1, "segment_release: %ld hits, %ld misses", SEG->hits,
+	    SEG->misses);
+
+    /* segments already paged out must reach the file */
+    seg_sync_writes(SEG);
+    seg_writer_free(SEG);
+
+#ifndef __MINGW32__
+    if (SEG->map) {
+	munmap(SEG->map - SEG->offset, SEG->map_size);
+	SEG->map = NULL;
+    }
+#endif
+
     for (i = 0; i < SEG->nseg; i++)
 	free(SEG->scb[i].buf);
     free(SEG->scb);
+    free(SEG->load_idx);
 
     SEG->open = 0;
 
@@ -16,6 +16,15 @@
 #include <stdio.h>
 #include <grass/gis.h>
 #include <grass/segment.h>
+#include "local_proto.h"
+#include <unistd.h>
+#ifndef __MINGW32__
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+
+static int setup(SEGMENT *, int);
 
 
 /**
@@ -26,6 +35,10 @@
  * <b>SEG</b> must have the following parms set:
  *  fd (open for read and write), nrows, ncols, srows, scols, len, nseg
  *
+ * With 16 or more segments, a quarter of the <i>nseg</i> buffers is
+ * used to write evicted segments behind (see pageout.c) and the
+ * others cache segments.
+ *
  * \param[in,out] SEG segment
  * \return 1 if successful
  * \return -1 if illegal parameters are passed in <b>SEG</b>
@@ -34,9 +47,41 @@
 
 int segment_setup(SEGMENT * SEG)
 {
-    int i;
+    return setup(SEG, 0);
+}
+
+
+/**
+ * \fn int segment_setup_mmap (SEGMENT *SEG)
+ *
+ * \brief Setup segment with the segment file mapped into memory.
+ *
+ * Like <i>segment_setup()</i>, but the segment file is mapped into
+ * memory, so that the system caches it instead of the <i>nseg</i>
+ * segment buffers. The disk blocks of the whole file are reserved
+ * first, as a store to a mapped page without a block would kill the
+ * process (SIGBUS) instead of failing. If they can not be reserved
+ * or the file can not be mapped, the segment is set up with
+ * <i>nseg</i> buffers as usual.
+ *
+ * \param[in,out] SEG segment
+ * \return 1 if successful
+ * \return -1 if illegal parameters are passed in <b>SEG</b>
+ * \return -2 if unable to allocate memory
+ */
+
+int segment_setup_mmap(SEGMENT * SEG)
+{
+    return setup(SEG, 1);
+}
+
+
+static int setup(SEGMENT * SEG, int use_map)
+{
+    int i, nsegs;
 
     SEG->open = 0;
+    SEG->map = NULL;
 
     if (SEG->nrows <= 0 || SEG->ncols <= 0
 	|| SEG->srows <= 0 || SEG->scols <= 0
@@ -53,13 +98,51 @@ int segment_setup(SEGMENT * SEG)
     if (SEG->spill)
 	SEG->spr++;
 
+    SEG->size = SEG->srows * SEG->scols * SEG->len;
+
+    nsegs = ((SEG->nrows + SEG->srows - 1) / SEG->srows) * SEG->spr;
+
+#if !defined(__MINGW32__) && defined(_POSIX_ADVISORY_INFO) && \
+    _POSIX_ADVISORY_INFO > 0
+    if (use_map) {
+	off_t size = SEG->offset + (off_t) nsegs * SEG->size;
+	void *p = MAP_FAILED;
+
+	/* allocate the blocks of the whole file, which also extends
+	   files made by segment_format_nofill(), so that a full disk
+	   is reported here and not by a SIGBUS on a store to the map */
+	if ((off_t) (size_t) size == size &&
+	    posix_fallocate(SEG->fd, (off_t) 0, size) == 0)
+	    p = mmap(NULL, (size_t) size, PROT_READ | PROT_WRITE, MAP_SHARED,
+		     SEG->fd, (off_t) 0);
+
+	if (p != MAP_FAILED) {
+	    SEG->map = (char *)p + SEG->offset;
+	    SEG->map_size = (size_t) size;
+	    SEG->nseg = 0;
+	    SEG->scb = NULL;
+	    SEG->load_idx = NULL;
+	    SEG->writer = NULL;
+	    SEG->hits = 0;
+	    SEG->misses = 0;
+	    SEG->open = 1;
+
+	    return 1;
+	}
+
+	G_debug(1, "segment_setup: unable to map segment file, "
+		"using %d segments in memory", SEG->nseg);
+    }
+#endif
+
+    /* takes its buffers out of nseg */
+    seg_writer_init(SEG);
+
     if ((SEG->scb =
 	 (struct SEGMENT_SCB *)G_malloc(SEG->nseg *
 					sizeof(struct SEGMENT_SCB))) == NULL)
 	return -2;
 
-    SEG->size = SEG->srows * SEG->scols * SEG->len;
-
     for (i = 0; i < SEG->nseg; i++) {
 	if ((SEG->scb[i].buf = G_malloc(SEG->size)) == NULL)
 	    return -2;
@@ -68,7 +151,18 @@ int segment_setup(SEGMENT * SEG)
 	SEG->scb[i].dirty = 0;
 	SEG->scb[i].age = 0;
     }
+
+    /* table of the slots holding each segment */
+    if ((SEG->load_idx = (int *)G_malloc(nsegs * sizeof(int))) == NULL)
+	return -2;
+
+    for (i = 0; i < nsegs; i++)
+	SEG->load_idx[i] = -1;
+
     SEG->cur = 0;
+    SEG->hand = 0;
+    SEG->hits = 0;
+    SEG->misses = 0;
     SEG->open = 1;
 
     return 1;
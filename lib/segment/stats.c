@@ -0,0 +1,47 @@
+
+/**
+ * \file stats.c
+ *
+ * \brief Segment statistics routines.
+ *
+ * This program is free software under the GNU General Public License
+ * (>=v2). Read the file COPYING that comes with GRASS for details.
+ *
+ * \author GRASS GIS Development Team
+ *
+ * \date 2013
+ */
+
+#include <grass/segment.h>
+
+
+/**
+ * \fn int segment_stats (const SEGMENT *SEG, long *hits, long *misses)
+ *
+ * \brief Get segment cache statistics.
+ *
+ * Reports how many accesses since segment_setup() found their segment
+ * in memory (<b>hits</b>) and how many had to read it from the segment
+ * file (<b>misses</b>). A high miss count suggests giving the segment
+ * more memory, i.e. a larger <i>nseg</i>. Accesses to segment files
+ * mapped by <i>segment_init_mmap()</i> are not counted.
+ *
+ * \param[in] SEG segment
+ * \param[out] hits number of hits, may be NULL
+ * \param[out] misses number of misses, may be NULL
+ * \return 1 if successful
+ * \return -1 if segment is not available (not open)
+ */
+
+int segment_stats(const SEGMENT * SEG, long *hits, long *misses)
+{
+    if (SEG->open != 1)
+	return -1;
+
+    if (hits)
+	*hits = SEG->hits;
+    if (misses)
+	*misses = SEG->misses;
+
+    return 1;
+}
@@ -3,12 +3,20 @@
 
 void c_median(DCELL * result, DCELL * values, int n, const void *closure)
 {
-    n = sort_cell(values, n);
+    int ranks[2];
 
-    if (n < 1)
+    n = partition_cell(values, n);
+
+    if (n < 1) {
 	G_set_d_null_value(result, 1);
-    else
-	*result = (values[(n - 1) / 2] + values[n / 2]) / 2;
+	return;
+    }
+
+    ranks[0] = (n - 1) / 2;
+    ranks[1] = n / 2;
+    select_cells(values, n, ranks, 2);
+
+    *result = (values[ranks[0]] + values[ranks[1]]) / 2;
 }
 
 void w_median(DCELL * result, DCELL(*values)[2], int n, const void *closure)
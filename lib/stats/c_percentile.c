@@ -3,26 +3,85 @@
 #include <grass/gis.h>
 #include <grass/stats.h>
 
-void c_quant(DCELL * result, DCELL * values, int n, const void *closure)
+/* the value at rank k, as the one below the rank selected last */
+static DCELL select_rank(DCELL * values, int n, int k, int *done)
 {
-    double quant = *(const double *)closure;
-    double k;
-    int i0, i1;
+    if (k > *done) {
+	select_cell(values + *done + 1, n - *done - 1, k - *done - 1);
+	*done = k;
+    }
+
+    return values[k];
+}
+
+/*!
+ * \brief Computes several quantiles of the same values
+ *
+ * As c_quant() for each of the quantiles, but the values are
+ * partitioned only once: the quantiles are selected in ascending
+ * order, each one among the values above the previous one.
+ *
+ * \param results quantiles
+ * \param values values, reordered
+ * \param n number of values
+ * \param quants quantiles to compute, between 0 and 1
+ * \param num_quants number of quantiles
+ */
+void c_quants(DCELL * results, DCELL * values, int n, const double *quants,
+	      int num_quants)
+{
+    int done = -1;
+    double quant, last;
+    int found;
+    int i;
 
-    n = sort_cell(values, n);
+    n = partition_cell(values, n);
 
     if (n < 1) {
-	G_set_d_null_value(result, 1);
+	G_set_d_null_value(results, num_quants);
 	return;
     }
 
-    k = n * quant;
-    i0 = (int)floor(k);
-    i1 = (int)ceil(k);
+    for (found = 0;; found = 1, last = quant) {
+	double k;
+	int i0, i1;
+	DCELL v0, v1;
+	int next = -1;
+
+	/* the smallest quantile not done yet */
+	for (i = 0; i < num_quants; i++)
+	    if ((!found || quants[i] > last) &&
+		(next < 0 || quants[i] < quants[next]))
+		next = i;
+	if (next < 0)
+	    break;
+	quant = quants[next];
+
+	k = n * quant;
+	i0 = (int)floor(k);
+	i1 = (int)ceil(k);
+
+	/* quantiles close to 1 would be interpolated with a null */
+	if (i1 > n - 1)
+	    i1 = n - 1;
+	if (i0 > i1)
+	    i0 = i1;
+	if (i0 < 0)
+	    i0 = i1 = 0;
+
+	v0 = select_rank(values, n, i0, &done);
+	v1 = select_rank(values, n, i1, &done);
+
+	for (i = 0; i < num_quants; i++)
+	    if (quants[i] == quant)
+		results[i] = (i0 == i1)
+		    ? v0 : v0 * (i1 - k) + v1 * (k - i0);
+    }
+}
 
-    *result = (i0 == i1)
-	? values[i0]
-	: values[i0] * (i1 - k) + values[i1] * (k - i0);
+void c_quant(DCELL * result, DCELL * values, int n, const void *closure)
+{
+    c_quants(result, values, n, (const double *)closure, 1);
 }
 
 void c_quart1(DCELL * result, DCELL * values, int n, const void *closure)
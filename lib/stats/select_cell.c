@@ -0,0 +1,247 @@
+#include <grass/gis.h>
+#include <grass/stats.h>
+
+/*
+   order statistics without a full sort: the values which are not
+   NaN (nulls in particular) are moved to the front first, so that
+   the comparisons need no null tests. introselect then partitions
+   around the median of three values until the rank is reached,
+   switching to heapsort when the partitions keep being unbalanced,
+   which bounds the time to O(n log n). sort_cell() uses the same
+   partitioning (introsort).
+ */
+
+/* ranges up to this length are sorted by insertion */
+#define SMALL 16
+
+#define SWAP(a, b) do { DCELL t_ = (a); (a) = (b); (b) = t_; } while (0)
+
+static int max_depth(int n)
+{
+    int depth = 0;
+
+    while (n >>= 1)
+	depth++;
+
+    return 2 * depth;
+}
+
+static void insertion_sort(DCELL * a, int lo, int hi)
+{
+    int i, j;
+
+    for (i = lo + 1; i <= hi; i++) {
+	DCELL v = a[i];
+
+	for (j = i; j > lo && a[j - 1] > v; j--)
+	    a[j] = a[j - 1];
+	a[j] = v;
+    }
+}
+
+static void sift_down(DCELL * a, int root, int n)
+{
+    DCELL v = a[root];
+    int child;
+
+    while ((child = 2 * root + 1) < n) {
+	if (child + 1 < n && a[child + 1] > a[child])
+	    child++;
+	if (a[child] <= v)
+	    break;
+	a[root] = a[child];
+	root = child;
+    }
+
+    a[root] = v;
+}
+
+static void heap_sort(DCELL * a, int lo, int hi)
+{
+    DCELL *h = a + lo;
+    int n = hi - lo + 1;
+    int i;
+
+    for (i = n / 2 - 1; i >= 0; i--)
+	sift_down(h, i, n);
+
+    for (i = n - 1; i > 0; i--) {
+	SWAP(h[0], h[i]);
+	sift_down(h, 0, i);
+    }
+}
+
+/* partition a[lo..hi] (at least 3 values) around the median of the
+   first, middle and last value; returns the final index of the pivot */
+static int partition(DCELL * a, int lo, int hi)
+{
+    int mid = lo + (hi - lo) / 2;
+    DCELL pivot;
+    int i, j;
+
+    if (a[mid] < a[lo])
+	SWAP(a[mid], a[lo]);
+    if (a[hi] < a[lo])
+	SWAP(a[hi], a[lo]);
+    if (a[hi] < a[mid])
+	SWAP(a[hi], a[mid]);
+
+    /* a[lo] and a[hi] are sentinels for the scans */
+    pivot = a[mid];
+    SWAP(a[mid], a[hi - 1]);
+
+    i = lo;
+    j = hi - 1;
+    for (;;) {
+	while (a[++i] < pivot) ;
+	while (a[--j] > pivot) ;
+	if (i >= j)
+	    break;
+	SWAP(a[i], a[j]);
+    }
+
+    SWAP(a[i], a[hi - 1]);
+
+    return i;
+}
+
+static void select_range(DCELL * a, int lo, int hi, int k, int depth)
+{
+    int p;
+
+    while (hi - lo >= SMALL) {
+	if (depth-- == 0) {
+	    heap_sort(a, lo, hi);
+	    return;
+	}
+
+	p = partition(a, lo, hi);
+	if (k == p)
+	    return;
+	if (k < p)
+	    hi = p - 1;
+	else
+	    lo = p + 1;
+    }
+
+    insertion_sort(a, lo, hi);
+}
+
+static void sort_range(DCELL * a, int lo, int hi, int depth)
+{
+    int p;
+
+    while (hi - lo >= SMALL) {
+	if (depth-- == 0) {
+	    heap_sort(a, lo, hi);
+	    return;
+	}
+
+	p = partition(a, lo, hi);
+
+	/* recurse into the smaller part only */
+	if (p - lo < hi - p) {
+	    sort_range(a, lo, p - 1, depth);
+	    lo = p + 1;
+	}
+	else {
+	    sort_range(a, p + 1, hi, depth);
+	    hi = p - 1;
+	}
+    }
+
+    insertion_sort(a, lo, hi);
+}
+
+static void select_ranks(DCELL * a, int lo, int hi, const int *k, int nk,
+			 int depth)
+{
+    int m, left, right;
+
+    if (nk == 0 || lo >= hi)
+	return;
+
+    m = nk / 2;
+    select_range(a, lo, hi, k[m], depth);
+
+    /* the ranks equal to k[m] are done */
+    for (left = m; left > 0 && k[left - 1] == k[m]; left--) ;
+    for (right = m + 1; right < nk && k[right] == k[m]; right++) ;
+
+    select_ranks(a, lo, k[m] - 1, k, left, depth);
+    select_ranks(a, k[m] + 1, hi, k + right, nk - right, depth);
+}
+
+/*!
+ * \brief Moves the values which are not NaN to the front
+ *
+ * Nulls, as well as any other NaN, are moved to the end of the array
+ * in no particular order. The order of the other values is not kept
+ * either.
+ *
+ * \param array values
+ * \param n number of values
+ * \return number of values which are not NaN
+ */
+int partition_cell(DCELL * array, int n)
+{
+    int i = 0, j = n - 1;
+
+    for (;;) {
+	while (i <= j && array[i] == array[i])
+	    i++;
+	while (i <= j && array[j] != array[j])
+	    j--;
+	if (i >= j)
+	    break;
+	SWAP(array[i], array[j]);
+	i++;
+	j--;
+    }
+
+    return i;
+}
+
+/*!
+ * \brief Puts the k-th smallest value in place
+ *
+ * On return, array[k] is the value which would be there if the array
+ * were sorted, the values before it are not larger and those after it
+ * are not smaller.
+ *
+ * \param array values without NaNs, see partition_cell()
+ * \param n number of values
+ * \param k rank, counting from 0
+ */
+void select_cell(DCELL * array, int n, int k)
+{
+    if (k >= 0 && k < n)
+	select_range(array, 0, n - 1, k, max_depth(n));
+}
+
+/*!
+ * \brief Puts several order statistics in place
+ *
+ * As select_cell() for each rank, but sharing the partitioning: the
+ * values between two of the ranks are partitioned only once.
+ *
+ * \param array values without NaNs, see partition_cell()
+ * \param n number of values
+ * \param ranks ranks in ascending order, counting from 0 and less than n
+ * \param num_ranks number of ranks
+ */
+void select_cells(DCELL * array, int n, const int *ranks, int num_ranks)
+{
+    if (n > 1)
+	select_ranks(array, 0, n - 1, ranks, num_ranks, max_depth(n));
+}
+
+int sort_cell(DCELL * array, int n)
+{
+    n = partition_cell(array, n);
+
+    if (n > 1)
+	sort_range(array, 0, n - 1, max_depth(n));
+
+    return n;
+}
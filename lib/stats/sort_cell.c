@@ -18,19 +18,6 @@ static int ascending(const void *aa, const void *bb)
     return (*a < *b) ? -1 : (*a > *b) ? 1 : 0;
 }
 
-int sort_cell(DCELL * array, int n)
-{
-    int i;
-
-    qsort(array, n, sizeof(DCELL), ascending);
-
-    for (i = 0; i < n; i++)
-	if (G_is_d_null_value(&array[i]))
-	    break;
-
-    return i;
-}
-
 int sort_cell_w(DCELL(*array)[2], int n)
 {
     int i;
@@ -419,15 +419,15 @@ int main(int argc, char *argv[])
     /*   Open initialize and segment all files  */
 
     in_fd = open(in_file, 2);
-    segment_init(&in_seg, in_fd, segments_in_memory);
+    segment_init_mmap(&in_seg, in_fd, segments_in_memory);
 
 
     out_fd = open(out_file, 2);
-    segment_init(&out_seg, out_fd, segments_in_memory);
+    segment_init_mmap(&out_seg, out_fd, segments_in_memory);
 
     if (dir == 1) {
 	dir_out_fd = open(dir_out_file, 2);
-	segment_init(&out_seg2, dir_out_fd, segments_in_memory);
+	segment_init_mmap(&out_seg2, dir_out_fd, segments_in_memory);
     }
 
     /*   Write the cost layer in the segmented file  */
@@ -252,13 +252,13 @@ int main(int argc, char *argv[])
 
     /*      open, initialize and segment all files          */
     in_fd = open(in_name, 2);
-    segment_init(&seg_in, in_fd, 4);
+    segment_init_mmap(&seg_in, in_fd, 4);
     out_fd = open(out_name, 2);
-    segment_init(&seg_out, out_fd, 4);
+    segment_init_mmap(&seg_out, out_fd, 4);
 
     if (patt_flag == TRUE) {
 	patt_fd = open(patt_name, 2);
-	segment_init(&seg_patt, patt_fd, 4);
+	segment_init_mmap(&seg_patt, patt_fd, 4);
 	for (row = 0; row < nrows; row++) {
 	    if (G_get_raster_row(patt, cell, row, CELL_TYPE) < 0)
 		G_fatal_error(_("Unable to read raster map <%s> row %d"),
@@ -1,5 +1,6 @@
 
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <grass/gis.h>
@@ -7,6 +8,7 @@
 
 #include "mapcalc.h"
 #include "globals.h"
+#include "func_proto.h"
 
 /****************************************************************************/
 
@@ -15,8 +17,29 @@ int depths, rows, columns;
 
 /****************************************************************************/
 
+/* Functions with arguments are evaluated in tiles of TILE_COLS columns
+   and their buffers hold one tile only, so that the intermediate
+   results of a row stay in the cache. The leaves of an expression
+   (maps, constants and functions without arguments such as col(), x()
+   or rand()) are evaluated for the whole row first. */
+#define TILE_COLS 1024
+
+/* rows of a block evaluated by one worker, see execute_parallel() */
+#define BLOCK_ROWS 16
+
+typedef struct worker
+{
+    expr_list *exprs;		/* private copy of the expressions */
+    struct Raster_reader **readers;	/* private readers of the input maps */
+    int row;			/* row being evaluated */
+    int first_row, num_rows;	/* block of rows assigned to the worker */
+    void **out;			/* evaluated block, one per expression */
+    void *ref;			/* task handle, see G_begin_execute() */
+} worker;
+
+/****************************************************************************/
+
 static void initialize(expression * e);
-static void evaluate(expression * e);
 
 /****************************************************************************/
 
@@ -25,16 +48,82 @@ static void allocate_buf(expression * e)
     e->buf = G_malloc(columns * G_raster_size(e->res_type));
 }
 
+static void allocate_tile(expression * e)
+{
+    int ncols = columns < TILE_COLS ? columns : TILE_COLS;
+
+    e->buf = G_malloc(ncols * G_raster_size(e->res_type));
+}
+
 static void set_buf(expression * e, void *buf)
 {
     e->buf = buf;
 }
 
+static int full_width(const expression * e)
+{
+    switch (e->type) {
+    case expr_type_variable:
+	return full_width(e->data.var.bind->data.bind.val);
+    case expr_type_function:
+	return e->data.func.argc == 0;
+    case expr_type_binding:
+	return full_width(e->data.bind.val);
+    default:
+	return 1;
+    }
+}
+
+/* the part of the buffer of e holding the columns starting at col,
+   which are at offset off of the current tile */
+static void *tile_buf(const expression * e, int col, int off)
+{
+    if (!full_width(e))
+	return (char *)e->buf + off * G_raster_size(e->res_type);
+
+    return (char *)e->buf + col * G_raster_size(e->res_type);
+}
+
+/* the value of a binding to be written is needed for the whole row */
+static void allocate_result(expression * e)
+{
+    if (!full_width(e->data.bind.val))
+	allocate_buf(e);
+}
+
 /****************************************************************************/
 
+static void evaluate_constant(expression * e)
+{
+    int *ibuf = e->buf;
+    float *fbuf = e->buf;
+    double *dbuf = e->buf;
+    int i;
+
+    switch (e->res_type) {
+    case CELL_TYPE:
+	for (i = 0; i < columns; i++)
+	    ibuf[i] = e->data.con.ival;
+	break;
+
+    case FCELL_TYPE:
+	for (i = 0; i < columns; i++)
+	    fbuf[i] = e->data.con.fval;
+	break;
+
+    case DCELL_TYPE:
+	for (i = 0; i < columns; i++)
+	    dbuf[i] = e->data.con.fval;
+	break;
+    default:
+	G_fatal_error(_("Invalid type: %d"), e->res_type);
+    }
+}
+
 static void initialize_constant(expression * e)
 {
     allocate_buf(e);
+    evaluate_constant(e);
 }
 
 static void initialize_variable(expression * e)
@@ -53,7 +142,10 @@ static void initialize_function(expression * e)
 {
     int i;
 
-    allocate_buf(e);
+    if (e->data.func.argc == 0)
+	allocate_buf(e);
+    else
+	allocate_tile(e);
 
     e->data.func.argv[0] = e->buf;
 
@@ -94,57 +186,26 @@ static void initialize(expression * e)
 
 /****************************************************************************/
 
-static void evaluate_constant(expression * e)
-{
-    int *ibuf = e->buf;
-    float *fbuf = e->buf;
-    double *dbuf = e->buf;
-    int i;
-
-    switch (e->res_type) {
-    case CELL_TYPE:
-	for (i = 0; i < columns; i++)
-	    ibuf[i] = e->data.con.ival;
-	break;
-
-    case FCELL_TYPE:
-	for (i = 0; i < columns; i++)
-	    fbuf[i] = e->data.con.fval;
-	break;
-
-    case DCELL_TYPE:
-	for (i = 0; i < columns; i++)
-	    dbuf[i] = e->data.con.fval;
-	break;
-    default:
-	G_fatal_error(_("Invalid type: %d"), e->res_type);
-    }
-}
-
-static void evaluate_variable(expression * e)
+static void evaluate_map(expression * e, const worker * w)
 {
-    /* this is a no-op */
+    if (w)
+	get_map_row_reader(w->readers, e->data.map.idx,
+			   w->row + e->data.map.row,
+			   e->data.map.col, e->buf, e->res_type);
+    else
+	get_map_row(e->data.map.idx,
+		    e->data.map.mod,
+		    current_depth + e->data.map.depth,
+		    current_row + e->data.map.row,
+		    e->data.map.col, e->buf, e->res_type);
 }
 
-static void evaluate_map(expression * e)
+static void call_function(expression * e, int ncols)
 {
-    get_map_row(e->data.map.idx,
-		e->data.map.mod,
-		current_depth + e->data.map.depth,
-		current_row + e->data.map.row,
-		e->data.map.col, e->buf, e->res_type);
-}
-
-static void evaluate_function(expression * e)
-{
-    int i;
     int res;
 
-    for (i = 1; i <= e->data.func.argc; i++)
-	evaluate(e->data.func.args[i]);
-
     res = (*e->data.func.func) (e->data.func.argc,
-				e->data.func.argt, e->data.func.argv);
+				e->data.func.argt, e->data.func.argv, ncols);
 
     switch (res) {
     case E_ARG_LO:
@@ -177,34 +238,503 @@ static void evaluate_function(expression * e)
     }
 }
 
-static void evaluate_binding(expression * e)
+/****************************************************************************/
+
+/* the leaves of the expression are evaluated for the whole row */
+static void evaluate_leaves(expression * e, const worker * w)
+{
+    int i;
+
+    switch (e->type) {
+    case expr_type_constant:
+	/* filled in by initialize() */
+	break;
+    case expr_type_variable:
+	/* this is a no-op */
+	break;
+    case expr_type_map:
+	evaluate_map(e, w);
+	break;
+    case expr_type_function:
+	if (e->data.func.argc == 0)
+	    call_function(e, columns);
+	for (i = 1; i <= e->data.func.argc; i++)
+	    evaluate_leaves(e->data.func.args[i], w);
+	break;
+    case expr_type_binding:
+	evaluate_leaves(e->data.bind.val, w);
+	break;
+    default:
+	G_fatal_error(_("Unknown type: %d"), e->type);
+    }
+}
+
+/* the other functions for ncols columns starting at col, which are at
+   offset off of the current tile */
+static void evaluate_tile(expression * e, int col, int off, int ncols);
+
+/* whether e can be evaluated for some of the columns only: its values
+   are not used elsewhere, and rand() is called for every column so that
+   the random numbers do not depend on the other values */
+static int can_skip(const expression * e)
+{
+    int i;
+
+    switch (e->type) {
+    case expr_type_function:
+	if (e->data.func.func == f_rand)
+	    return 0;
+	for (i = 1; i <= e->data.func.argc; i++)
+	    if (!can_skip(e->data.func.args[i]))
+		return 0;
+	return 1;
+    case expr_type_binding:
+	/* variables may refer to it elsewhere */
+	return full_width(e->data.bind.val);
+    default:
+	return 1;
+    }
+}
+
+/* whether the condition a of if() selects argument i */
+static int selects(int argc, int i, DCELL a)
+{
+    if (IS_NULL_D(&a))
+	return 0;
+
+    switch (i) {
+    case 2:
+	return argc == 4 ? a > 0.0 : a != 0.0;
+    case 3:
+	return a == 0.0;
+    default:
+	return a < 0.0;
+    }
+}
+
+/* evaluate argument i of if() for the columns it is selected for;
+   runs of selected columns separated by less than RUN_GAP columns are
+   evaluated together */
+#define RUN_GAP 16
+
+static void evaluate_selected(expression * e, int i, const DCELL * cond,
+			      int col, int off, int ncols)
+{
+    expression *arg = e->data.func.args[i];
+    int argc = e->data.func.argc;
+    int j, start, end;
+
+    for (j = 0; j < ncols;) {
+	while (j < ncols && !selects(argc, i, cond[j]))
+	    j++;
+	if (j >= ncols)
+	    break;
+
+	start = j;
+	end = ++j;
+	for (; j < ncols && j - end < RUN_GAP; j++)
+	    if (selects(argc, i, cond[j]))
+		end = j + 1;
+
+	evaluate_tile(arg, col + start, off + start, end - start);
+    }
+}
+
+/* The arguments of if() are evaluated only for the columns their value
+   is selected for, and those of eval() but the last one only if they
+   bind variables. The other columns of their buffers are left
+   undefined. */
+static void evaluate_lazy(expression * e, int col, int off, int ncols)
+{
+    int argc = e->data.func.argc;
+    const DCELL *cond;
+    int i;
+
+    if (e->data.func.func == f_if) {
+	evaluate_tile(e->data.func.args[1], col, off, ncols);
+	cond = tile_buf(e->data.func.args[1], col, off);
+
+	for (i = 2; i <= argc; i++) {
+	    expression *arg = e->data.func.args[i];
+
+	    if (can_skip(arg))
+		evaluate_selected(e, i, cond, col, off, ncols);
+	    else
+		evaluate_tile(arg, col, off, ncols);
+	}
+    }
+    else {
+	for (i = 1; i < argc; i++) {
+	    expression *arg = e->data.func.args[i];
+
+	    if (!can_skip(arg))
+		evaluate_tile(arg, col, off, ncols);
+	}
+	evaluate_tile(e->data.func.args[argc], col, off, ncols);
+    }
+}
+
+static void evaluate_tile(expression * e, int col, int off, int ncols)
+{
+    int i;
+
+    switch (e->type) {
+    case expr_type_function:
+	if (e->data.func.argc == 0)
+	    break;
+	if (e->data.func.func == f_if || e->data.func.func == f_eval)
+	    evaluate_lazy(e, col, off, ncols);
+	else
+	    for (i = 1; i <= e->data.func.argc; i++)
+		evaluate_tile(e->data.func.args[i], col, off, ncols);
+	for (i = 1; i <= e->data.func.argc; i++)
+	    e->data.func.argv[i] = tile_buf(e->data.func.args[i], col, off);
+	e->data.func.argv[0] = tile_buf(e, col, off);
+	call_function(e, ncols);
+	break;
+    case expr_type_binding:
+	evaluate_tile(e->data.bind.val, col, off, ncols);
+	break;
+    }
+}
+
+/* evaluate one row of a list of bindings; w is NULL for the serial
+   evaluation of current_row */
+static void evaluate_row(expr_list * ee, const worker * w)
 {
-    evaluate(e->data.bind.val);
+    expr_list *l;
+    int col, ncols;
+
+    for (l = ee; l; l = l->next)
+	evaluate_leaves(l->exp, w);
+
+    for (col = 0; col < columns; col += TILE_COLS) {
+	ncols = columns - col < TILE_COLS ? columns - col : TILE_COLS;
+
+	for (l = ee; l; l = l->next) {
+	    expression *e = l->exp;
+	    expression *val = e->data.bind.val;
+
+	    evaluate_tile(e, col, 0, ncols);
+
+	    /* collect the tiles of the result */
+	    if (e->buf != val->buf)
+		memcpy((char *)e->buf + col * G_raster_size(e->res_type),
+		       val->buf, ncols * G_raster_size(e->res_type));
+	}
+    }
 }
 
 /****************************************************************************/
 
-static void evaluate(expression * e)
+/* Rows can be evaluated in any order as long as no expression refers
+   to other rows of a map or depends on the row being evaluated */
+
+static int parallel_safe(const expression * e)
 {
+    int i;
+
     switch (e->type) {
     case expr_type_constant:
-	evaluate_constant(e);
-	break;
     case expr_type_variable:
-	evaluate_variable(e);
+	return 1;
+    case expr_type_map:
+	return e->data.map.mod == 'M' &&
+	    e->data.map.row == 0 && e->data.map.depth == 0;
+    case expr_type_function:
+	if (e->data.func.func == f_rand ||
+	    e->data.func.func == f_row || e->data.func.func == f_y)
+	    return 0;
+	for (i = 1; i <= e->data.func.argc; i++)
+	    if (!parallel_safe(e->data.func.args[i]))
+		return 0;
+	return 1;
+    case expr_type_binding:
+	return parallel_safe(e->data.bind.val);
+    default:
+	return 0;
+    }
+}
+
+/* bindings and their copies, for the variables of a copied list */
+static const expression **bind_orig;
+static expression **bind_copy;
+static int num_binds, max_binds;
+
+static expression *find_binding(const expression * e)
+{
+    int i;
+
+    for (i = 0; i < num_binds; i++)
+	if (bind_orig[i] == e)
+	    return bind_copy[i];
+
+    G_fatal_error("internal error: find_binding: unknown variable");
+    return NULL;
+}
+
+/* copy an initialized expression, giving the copy its own buffers */
+static expression *copy_expression(const expression * e)
+{
+    expression *c = G_malloc(sizeof(expression));
+    int argc, i;
+
+    *c = *e;
+
+    switch (e->type) {
+    case expr_type_constant:
+	allocate_buf(c);
+	evaluate_constant(c);
 	break;
     case expr_type_map:
-	evaluate_map(e);
+	allocate_buf(c);
+	break;
+    case expr_type_variable:
+	c->data.var.bind = find_binding(e->data.var.bind);
+	set_buf(c, c->data.var.bind->data.bind.val->buf);
 	break;
     case expr_type_function:
-	evaluate_function(e);
+	argc = e->data.func.argc;
+	c->data.func.args = G_malloc((argc + 1) * sizeof(expression *));
+	c->data.func.argv = G_malloc((argc + 1) * sizeof(void *));
+	if (argc == 0)
+	    allocate_buf(c);
+	else
+	    allocate_tile(c);
+	c->data.func.argv[0] = c->buf;
+	for (i = 1; i <= argc; i++) {
+	    c->data.func.args[i] = copy_expression(e->data.func.args[i]);
+	    c->data.func.argv[i] = c->data.func.args[i]->buf;
+	}
 	break;
     case expr_type_binding:
-	evaluate_binding(e);
+	c->data.bind.val = copy_expression(e->data.bind.val);
+	set_buf(c, c->data.bind.val->buf);
+	if (num_binds >= max_binds) {
+	    max_binds += 10;
+	    bind_orig = G_realloc(bind_orig, max_binds * sizeof(expression *));
+	    bind_copy = G_realloc(bind_copy, max_binds * sizeof(expression *));
+	}
+	bind_orig[num_binds] = e;
+	bind_copy[num_binds] = c;
+	num_binds++;
 	break;
     default:
 	G_fatal_error(_("Unknown type: %d"), e->type);
     }
+
+    return c;
+}
+
+static expr_list *copy_list(expr_list * ee)
+{
+    expr_list *l, *head = NULL, **tail = &head;
+
+    num_binds = 0;
+
+    for (l = ee; l; l = l->next) {
+	*tail = list(copy_expression(l->exp), NULL);
+	allocate_result((*tail)->exp);
+	tail = &(*tail)->next;
+    }
+
+    return head;
+}
+
+/* free a copy made by copy_expression() */
+static void free_expression(expression * c)
+{
+    int i;
+
+    switch (c->type) {
+    case expr_type_constant:
+    case expr_type_map:
+	G_free(c->buf);
+	break;
+    case expr_type_function:
+	for (i = 1; i <= c->data.func.argc; i++)
+	    free_expression(c->data.func.args[i]);
+	G_free(c->data.func.args);
+	G_free(c->data.func.argv);
+	G_free(c->buf);
+	break;
+    case expr_type_binding:
+	free_expression(c->data.bind.val);
+	break;
+    default:
+	break;
+    }
+
+    G_free(c);
+}
+
+/* free a copy made by copy_list() */
+static void free_list(expr_list * l)
+{
+    expr_list *next;
+
+    for (; l; l = next) {
+	next = l->next;
+	/* the buffer given by allocate_result() */
+	if (!full_width(l->exp->data.bind.val))
+	    G_free(l->exp->buf);
+	free_expression(l->exp);
+	G_free(l);
+    }
+}
+
+/****************************************************************************/
+
+static void evaluate_block(void *closure)
+{
+    worker *w = closure;
+    expr_list *l;
+    int i, k;
+
+    for (i = 0; i < w->num_rows; i++) {
+	w->row = w->first_row + i;
+	evaluate_row(w->exprs, w);
+
+	for (l = w->exprs, k = 0; l; l = l->next, k++) {
+	    expression *e = l->exp;
+	    size_t size = columns * G_raster_size(e->res_type);
+
+	    memcpy((char *)w->out[k] + i * size, e->buf, size);
+	}
+    }
+}
+
+static void write_block(worker * w, expr_list * ee, int verbose)
+{
+    expr_list *l;
+    int i, k;
+
+    G_end_execute(&w->ref);
+
+    for (i = 0; i < w->num_rows; i++) {
+	if (verbose)
+	    G_percent(w->first_row + i, rows, 2);
+
+	for (l = ee, k = 0; l; l = l->next, k++) {
+	    expression *e = l->exp;
+	    size_t size = columns * G_raster_size(e->res_type);
+
+	    put_map_row(e->data.bind.fd, (char *)w->out[k] + i * size,
+			e->res_type);
+	}
+    }
+
+    w->num_rows = 0;
+}
+
+static void execute_serial(expr_list * ee, int verbose)
+{
+    expr_list *l;
+    int count, n;
+
+    count = rows * depths;
+    n = 0;
+
+    for (current_depth = 0; current_depth < depths; current_depth++)
+	for (current_row = 0; current_row < rows; current_row++) {
+	    if (verbose)
+		G_percent(n, count, 2);
+
+	    evaluate_row(ee, NULL);
+
+	    for (l = ee; l; l = l->next) {
+		expression *e = l->exp;
+		int fd = e->data.bind.fd;
+
+		put_map_row(fd, e->buf, e->res_type);
+	    }
+
+	    n++;
+	}
+}
+
+/*
+ * Evaluate blocks of BLOCK_ROWS rows on the worker threads. Each
+ * worker has a copy of the expressions with its own buffers and its
+ * own readers of the input maps. The blocks are handed out round robin
+ * and written by the calling thread in the order they were started.
+ *
+ * Returns 0 if the expressions can not be evaluated in parallel.
+ */
+static int execute_parallel(expr_list * ee, int verbose)
+{
+    int num_workers = G_num_workers();
+    int num_exprs = list_length(ee);
+    worker *workers;
+    expr_list *l;
+    int row, i, k;
+
+    if (num_workers <= 0 || depths != 1 || rows < 2 * BLOCK_ROWS)
+	return 0;
+
+    for (l = ee; l; l = l->next)
+	if (!parallel_safe(l->exp))
+	    return 0;
+
+    /* the calling thread evaluates a block if all workers are busy */
+    num_workers++;
+    workers = G_calloc(num_workers, sizeof(worker));
+
+    for (i = 0; i < num_workers; i++) {
+	worker *w = &workers[i];
+
+	w->readers = open_map_readers();
+	if (!w->readers) {
+	    while (--i >= 0)
+		close_map_readers(workers[i].readers);
+	    G_free(workers);
+	    return 0;
+	}
+
+	w->exprs = copy_list(ee);
+	w->out = G_malloc(num_exprs * sizeof(void *));
+	for (l = ee, k = 0; l; l = l->next, k++)
+	    w->out[k] = G_malloc((size_t) BLOCK_ROWS * columns *
+				 G_raster_size(l->exp->res_type));
+    }
+
+    G_debug(1, "execute: evaluating %d rows with %d workers", rows,
+	    num_workers);
+
+    for (row = 0, i = 0; row < rows; row += BLOCK_ROWS) {
+	worker *w = &workers[i];
+
+	/* the worker's previous block is the oldest one not written */
+	if (w->num_rows)
+	    write_block(w, ee, verbose);
+
+	w->first_row = row;
+	w->num_rows = rows - row < BLOCK_ROWS ? rows - row : BLOCK_ROWS;
+	G_begin_execute(evaluate_block, w, &w->ref, 0);
+
+	i = (i + 1) % num_workers;
+    }
+
+    for (k = 0; k < num_workers; k++) {
+	worker *w = &workers[(i + k) % num_workers];
+
+	if (w->num_rows)
+	    write_block(w, ee, verbose);
+    }
+
+    for (i = 0; i < num_workers; i++) {
+	worker *w = &workers[i];
+
+	close_map_readers(w->readers);
+	free_list(w->exprs);
+	for (k = 0; k < num_exprs; k++)
+	    G_free(w->out[k]);
+	G_free(w->out);
+    }
+
+    G_free(workers);
+
+    return 1;
 }
 
 /****************************************************************************/
@@ -256,26 +786,27 @@ static void setup_rand(void)
 void execute(expr_list * ee)
 {
     int verbose = isatty(2);
-    expr_list *l;
-    int count, n;
+    expr_list *l, *o;
 
     setup_region();
-    setup_maps();
     setup_rand();
 
-    exprs = ee;
+    for (l = ee; l; l = l->next)
+	if (l->exp->type != expr_type_binding)
+	    G_fatal_error("internal error: execute: invalid type: %d",
+			  l->exp->type);
+
+    /* ee is kept for the history of the output maps */
+    exprs = optimize(ee);
     G_set_error_routine(error_handler);
 
-    for (l = ee; l; l = l->next) {
+    for (l = exprs; l; l = l->next) {
 	expression *e = l->exp;
 	const char *var;
 	expression *val;
 
-	if (e->type != expr_type_binding)
-	    G_fatal_error("internal error: execute: invalid type: %d",
-			  e->type);
-
 	initialize(e);
+	allocate_result(e);
 
 	var = e->data.bind.var;
 	val = e->data.bind.val;
@@ -283,29 +814,16 @@ void execute(expr_list * ee)
 	e->data.bind.fd = open_output_map(var, val->res_type);
     }
 
-    count = rows * depths;
-    n = 0;
-
-    for (current_depth = 0; current_depth < depths; current_depth++)
-	for (current_row = 0; current_row < rows; current_row++) {
-	    if (verbose)
-		G_percent(n, count, 2);
-
-	    for (l = ee; l; l = l->next) {
-		expression *e = l->exp;
-		int fd = e->data.bind.fd;
-
-		evaluate(e);
-		put_map_row(fd, e->buf, e->res_type);
-	    }
+    /* the maps are opened by initialize() */
+    setup_maps();
 
-	    n++;
-	}
+    if (!execute_parallel(exprs, verbose))
+	execute_serial(exprs, verbose);
 
     if (verbose)
-	G_percent(n, count, 2);
+	G_percent(1, 1, 2);
 
-    for (l = ee; l; l = l->next) {
+    for (l = exprs, o = ee; l; l = l->next, o = o->next) {
 	expression *e = l->exp;
 	const char *var = e->data.bind.var;
 	expression *val = e->data.bind.val;
@@ -323,7 +841,7 @@ void execute(expr_list * ee)
 	    copy_history(var, val->data.map.idx);
 	}
 	else
-	    create_history(var, val);
+	    create_history(var, o->exp->data.bind.val);
     }
 
     G_unset_error_routine();
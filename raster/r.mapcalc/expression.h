@@ -2,9 +2,11 @@
 #ifndef __EXPRESSION_H_
 #define __EXPRESSION_H_
 
+#include <limits.h>
+
 struct expr_list;
 
-typedef int func_t(int argc, const int *argt, void **args);
+typedef int func_t(int argc, const int *argt, void **args, int ncols);
 typedef int args_t(int argc, int *argt);
 
 #define E_ARG_LO	1
@@ -111,11 +113,18 @@ extern expression *binding(const char *var, expression * val);
 
 extern func_desc func_descs[];
 
-#define IS_NULL_C(x) (G_is_c_null_value((x)))
-#define IS_NULL_F(x) (G_is_f_null_value((x)))
-#define IS_NULL_D(x) (G_is_d_null_value((x)))
+/* The null tests are done inline, so that the loops of the functions
+   have no calls and can be vectorized by the compiler. As in
+   G_is_[cfd]_null_value(), the CELL null is the smallest integer and
+   every NaN is a floating point null; arithmetic on floating point
+   nulls therefore gives nulls by itself. */
+#define NULL_CELL INT_MIN
+
+#define IS_NULL_C(x) (*(x) == NULL_CELL)
+#define IS_NULL_F(x) (*(x) != *(x))
+#define IS_NULL_D(x) (*(x) != *(x))
 
-#define SET_NULL_C(x) (G_set_c_null_value((x),1))
+#define SET_NULL_C(x) (*(x) = NULL_CELL)
 #define SET_NULL_F(x) (G_set_f_null_value((x),1))
 #define SET_NULL_D(x) (G_set_d_null_value((x),1))
 
@@ -35,6 +35,7 @@ typedef struct map
     int have_cats;
     int have_colors;
     int use_rowio;
+    RASTER_MAP_TYPE rowio_type;	/* type of the rows held by rowio */
     int min_row, max_row;
     int fd;
     struct Categories cats;
@@ -57,7 +58,7 @@ static int max_row = -INT_MAX;
 static int min_col = INT_MAX;
 static int max_col = -INT_MAX;
 
-static int max_rows_in_memory = 3;
+static int max_rows_in_memory = 64;
 
 static int read_row_type;
 
@@ -233,7 +234,7 @@ static int read_row(int fd, void *buf, int row, int dummy)
     if (G_get_raster_row(fd, (DCELL *) buf, row, read_row_type) < 0)
 	G_fatal_error(_("Unable to read raster map row %d"), row);
 
-    return 0;
+    return 1;
 }
 
 static void setup_map(map * m)
@@ -243,50 +244,57 @@ static void setup_map(map * m)
 	? sizeof(CELL)
 	: sizeof(double);
 
+    /* neighborhood references read the rows around the current one
+       from a window of nrows rows held by rowio */
     if (nrows > 1 && nrows <= max_rows_in_memory) {
 	if (rowio_setup(&m->rowio, m->fd, nrows,
 			columns * size, read_row, NULL) < 0)
 	    G_fatal_error(_("Rowio_setup failed"));
+	m->rowio_type = G_get_raster_map_type(m->fd);
 	m->use_rowio = 1;
     }
     else
 	m->use_rowio = 0;
 }
 
-static void read_map(map * m, void *buf, int res_type, int row, int col)
+static void set_null_row(void *buf, int res_type)
 {
     CELL *ibuf = buf;
     FCELL *fbuf = buf;
     DCELL *dbuf = buf;
-    void *bp;
+    int i;
 
-    if (row < 0 || row >= rows) {
-	int i;
+    switch (res_type) {
+    case CELL_TYPE:
+	for (i = 0; i < columns; i++)
+	    SET_NULL_C(&ibuf[i]);
+	break;
+    case FCELL_TYPE:
+	for (i = 0; i < columns; i++)
+	    SET_NULL_F(&fbuf[i]);
+	break;
+    case DCELL_TYPE:
+	for (i = 0; i < columns; i++)
+	    SET_NULL_D(&dbuf[i]);
+	break;
+    default:
+	G_fatal_error(_("Unknown type: %d"), res_type);
+	break;
+    }
+}
 
-	switch (res_type) {
-	case CELL_TYPE:
-	    for (i = 0; i < columns; i++)
-		SET_NULL_C(&ibuf[i]);
-	    break;
-	case FCELL_TYPE:
-	    for (i = 0; i < columns; i++)
-		SET_NULL_F(&fbuf[i]);
-	    break;
-	case DCELL_TYPE:
-	    for (i = 0; i < columns; i++)
-		SET_NULL_D(&dbuf[i]);
-	    break;
-	default:
-	    G_fatal_error(_("Unknown type: %d"), res_type);
-	    break;
-	}
+static void read_map(map * m, void *buf, int res_type, int row, int col)
+{
+    void *bp;
 
+    if (row < 0 || row >= rows) {
+	set_null_row(buf, res_type);
 	return;
     }
 
     set_read_row_type(res_type);
 
-    if (m->use_rowio) {
+    if (m->use_rowio && res_type == m->rowio_type) {
 	bp = rowio_get(&m->rowio, row);
 	if (!bp)
 	    G_fatal_error(_("Rowio_get failed"));
@@ -486,6 +494,53 @@ void get_map_row(int idx, int mod, int depth, int row, int col, void *buf,
     }
 }
 
+/* The parallel evaluator (see evaluate.c) reads the maps through one
+   set of readers per worker; only plain map references ('M') can be
+   read this way */
+
+struct Raster_reader **open_map_readers(void)
+{
+    struct Raster_reader **readers;
+    int i;
+
+    readers = G_calloc(num_maps + 1, sizeof(struct Raster_reader *));
+
+    for (i = 0; i < num_maps; i++) {
+	readers[i] = G_open_raster_reader(maps[i].fd);
+	if (!readers[i]) {
+	    close_map_readers(readers);
+	    return NULL;
+	}
+    }
+
+    return readers;
+}
+
+void close_map_readers(struct Raster_reader **readers)
+{
+    int i;
+
+    for (i = 0; i < num_maps && readers[i]; i++)
+	G_close_raster_reader(readers[i]);
+
+    G_free(readers);
+}
+
+void get_map_row_reader(struct Raster_reader **readers, int idx, int row,
+			int col, void *buf, int res_type)
+{
+    if (row < 0 || row >= rows) {
+	set_null_row(buf, res_type);
+	return;
+    }
+
+    if (G_reader_get_raster_row(readers[idx], buf, row, res_type) < 0)
+	G_fatal_error(_("Unable to read raster map row %d"), row);
+
+    if (col)
+	column_shift(buf, res_type, col);
+}
+
 void close_maps(void)
 {
     int i;
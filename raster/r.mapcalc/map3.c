@@ -554,6 +554,23 @@ void get_map_row(int idx, int mod, int depth, int row, int col, void *buf,
     }
 }
 
+/* 3D maps are always evaluated serially */
+
+struct Raster_reader **open_map_readers(void)
+{
+    return NULL;
+}
+
+void close_map_readers(struct Raster_reader **readers)
+{
+}
+
+void get_map_row_reader(struct Raster_reader **readers, int idx, int row,
+			int col, void *buf, int res_type)
+{
+    G_fatal_error("internal error: get_map_row_reader: no readers");
+}
+
 void close_maps(void)
 {
     int i;
@@ -34,6 +34,10 @@ extern void column_shift(void *buf, int res_type, int col);
 extern int is_var(const char *);
 extern char *format_expression(const expression *);
 
+/* optimize.c */
+
+extern expr_list *optimize(expr_list *);
+
 /* evaluate.c */
 
 extern void execute(expr_list *);
@@ -49,6 +53,11 @@ extern void get_map_row(int idx, int mod, int depth, int row, int col,
 			void *buf, int res_type);
 extern void close_maps(void);
 
+extern struct Raster_reader **open_map_readers(void);
+extern void close_map_readers(struct Raster_reader **readers);
+extern void get_map_row_reader(struct Raster_reader **readers, int idx,
+			       int row, int col, void *buf, int res_type);
+
 extern int open_output_map(const char *name, int res_type);
 extern void put_map_row(int fd, void *buf, int res_type);
 extern void close_output_map(int fd);
@@ -0,0 +1,435 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <grass/gis.h>
+#include <grass/glocale.h>
+
+#include "mapcalc.h"
+#include "func_proto.h"
+
+/****************************************************************************/
+
+/*
+ * The parsed expressions are rewritten before they are evaluated:
+ *
+ * - identical subexpressions are merged into one node (hash-consing),
+ *   so that the statements form a DAG. A function or map used more
+ *   than once is evaluated at its first use in a binding with a
+ *   generated name and referred to by variables afterwards, like a
+ *   variable of the script;
+ *
+ * - functions whose arguments are all constants are evaluated once
+ *   and replaced by the result, which evaluate.c fills in before the
+ *   first row.
+ *
+ * rand() is neither merged nor folded, and neither are bindings. The
+ * parsed expressions are left unchanged for the history of the
+ * output maps.
+ */
+
+/* a node of the DAG */
+typedef struct node
+{
+    expression *e;
+    unsigned int hash;
+    int uses;			/* references from other nodes */
+    int emitted;		/* seen by emit() */
+    expression *bind;		/* generated binding, if shared */
+    struct node *next;		/* same bucket of the node table */
+    struct node *next_ptr;	/* same bucket of the pointer table */
+} node;
+
+#define NUM_BUCKETS 1021
+
+static node *nodes[NUM_BUCKETS];
+static node *ptrs[NUM_BUCKETS];
+
+/* bindings and their rewritten copies */
+static const expression **bind_orig;
+static expression **bind_copy;
+static int num_binds, max_binds;
+
+static int num_nodes, num_shared, num_folded;
+
+/****************************************************************************/
+
+static unsigned int hash_ptr(const void *p)
+{
+    return (unsigned int)((size_t) p >> 4) % NUM_BUCKETS;
+}
+
+static unsigned int hash_expression(const expression * e)
+{
+    unsigned int h = e->type * 31 + e->res_type;
+    const unsigned char *p;
+    int i;
+
+    switch (e->type) {
+    case expr_type_constant:
+	if (e->res_type == CELL_TYPE)
+	    h = h * 31 + e->data.con.ival;
+	else
+	    for (p = (const unsigned char *)&e->data.con.fval, i = 0;
+		 i < sizeof(e->data.con.fval); i++)
+		h = h * 31 + p[i];
+	break;
+    case expr_type_variable:
+	h = h * 31 + hash_ptr(e->data.var.bind);
+	break;
+    case expr_type_map:
+	for (p = (const unsigned char *)e->data.map.name; *p; p++)
+	    h = h * 31 + *p;
+	h = h * 31 + e->data.map.mod;
+	h = h * 31 + e->data.map.row;
+	h = h * 31 + e->data.map.col;
+	h = h * 31 + e->data.map.depth;
+	break;
+    case expr_type_function:
+	h = h * 31 + hash_ptr((const void *)e->data.func.func);
+	for (i = 1; i <= e->data.func.argc; i++)
+	    h = h * 31 + hash_ptr(e->data.func.args[i]);
+	break;
+    }
+
+    return h;
+}
+
+static int same_expression(const expression * a, const expression * b)
+{
+    int i;
+
+    if (a->type != b->type || a->res_type != b->res_type)
+	return 0;
+
+    switch (a->type) {
+    case expr_type_constant:
+	if (a->res_type == CELL_TYPE)
+	    return a->data.con.ival == b->data.con.ival;
+	/* nulls (NaNs) are equal too */
+	return memcmp(&a->data.con.fval, &b->data.con.fval,
+		      sizeof(a->data.con.fval)) == 0;
+    case expr_type_variable:
+	return a->data.var.bind == b->data.var.bind;
+    case expr_type_map:
+	return strcmp(a->data.map.name, b->data.map.name) == 0 &&
+	    a->data.map.mod == b->data.map.mod &&
+	    a->data.map.row == b->data.map.row &&
+	    a->data.map.col == b->data.map.col &&
+	    a->data.map.depth == b->data.map.depth;
+    case expr_type_function:
+	if (a->data.func.func != b->data.func.func ||
+	    a->data.func.argc != b->data.func.argc)
+	    return 0;
+	for (i = 1; i <= a->data.func.argc; i++)
+	    if (a->data.func.args[i] != b->data.func.args[i])
+		return 0;
+	return 1;
+    default:
+	return 0;
+    }
+}
+
+static node *find_node(const expression * e)
+{
+    node *n;
+
+    for (n = ptrs[hash_ptr(e)]; n; n = n->next_ptr)
+	if (n->e == e)
+	    return n;
+
+    return NULL;
+}
+
+/* the node equal to e, which is freed if there is one already */
+static expression *intern(expression * e)
+{
+    unsigned int h = hash_expression(e);
+    node **bucket = &nodes[h % NUM_BUCKETS];
+    node *n;
+    int i;
+
+    for (n = *bucket; n; n = n->next) {
+	if (n->hash != h || !same_expression(n->e, e))
+	    continue;
+
+	n->uses++;
+
+	/* the arguments of e are those of n->e */
+	if (e->type == expr_type_function) {
+	    for (i = 1; i <= e->data.func.argc; i++) {
+		node *arg = find_node(e->data.func.args[i]);
+
+		if (arg)
+		    arg->uses--;
+	    }
+	    G_free(e->data.func.args);
+	    G_free(e->data.func.argv);
+	}
+	G_free(e);
+
+	return n->e;
+    }
+
+    n = G_calloc(1, sizeof(node));
+    n->e = e;
+    n->hash = h;
+    n->uses = 1;
+    n->next = *bucket;
+    *bucket = n;
+    n->next_ptr = ptrs[hash_ptr(e)];
+    ptrs[hash_ptr(e)] = n;
+
+    num_nodes++;
+
+    return e;
+}
+
+static expression *find_binding(const expression * e)
+{
+    int i;
+
+    for (i = 0; i < num_binds; i++)
+	if (bind_orig[i] == e)
+	    return bind_copy[i];
+
+    G_fatal_error("internal error: optimize: unknown variable");
+    return NULL;
+}
+
+/****************************************************************************/
+
+static int is_constant(const expression * e)
+{
+    return e->type == expr_type_constant;
+}
+
+/* evaluate a function of constants for a single cell */
+static expression *fold(expression * e)
+{
+    int argc = e->data.func.argc;
+    DCELL *cells = G_malloc((argc + 1) * sizeof(DCELL));
+    expression *c = NULL;
+    int i;
+
+    for (i = 0; i <= argc; i++)
+	e->data.func.argv[i] = &cells[i];
+
+    for (i = 1; i <= argc; i++) {
+	const expression *arg = e->data.func.args[i];
+
+	switch (arg->res_type) {
+	case CELL_TYPE:
+	    *(CELL *) & cells[i] = arg->data.con.ival;
+	    break;
+	case FCELL_TYPE:
+	    *(FCELL *) & cells[i] = arg->data.con.fval;
+	    break;
+	case DCELL_TYPE:
+	    cells[i] = arg->data.con.fval;
+	    break;
+	}
+    }
+
+    /* errors are left to be reported by evaluate.c */
+    if ((*e->data.func.func) (argc, e->data.func.argt,
+			      e->data.func.argv, 1) == 0) {
+	switch (e->res_type) {
+	case CELL_TYPE:
+	    c = constant_int(*(CELL *) & cells[0]);
+	    break;
+	case FCELL_TYPE:
+	    c = constant_float(*(FCELL *) & cells[0]);
+	    break;
+	case DCELL_TYPE:
+	    c = constant_double(cells[0]);
+	    break;
+	}
+    }
+
+    G_free(cells);
+
+    if (!c)
+	return e;
+
+    G_free(e->data.func.args);
+    G_free(e->data.func.argv);
+    G_free(e);
+
+    num_folded++;
+
+    return c;
+}
+
+static int foldable(const expression * e)
+{
+    int i;
+
+    if (e->data.func.argc == 0 || e->data.func.func == f_rand)
+	return 0;
+
+    for (i = 1; i <= e->data.func.argc; i++)
+	if (!is_constant(e->data.func.args[i]))
+	    return 0;
+
+    return 1;
+}
+
+/****************************************************************************/
+
+/* build the DAG of e */
+static expression *canonical(const expression * e)
+{
+    expression *c = G_malloc(sizeof(expression));
+    int argc, i;
+
+    *c = *e;
+    c->buf = NULL;
+
+    switch (e->type) {
+    case expr_type_constant:
+    case expr_type_map:
+	return intern(c);
+    case expr_type_variable:
+	c->data.var.bind = find_binding(e->data.var.bind);
+	return intern(c);
+    case expr_type_function:
+	argc = e->data.func.argc;
+	c->data.func.args = G_malloc((argc + 1) * sizeof(expression *));
+	c->data.func.argv = G_malloc((argc + 1) * sizeof(void *));
+	for (i = 1; i <= argc; i++)
+	    c->data.func.args[i] = canonical(e->data.func.args[i]);
+	if (foldable(c)) {
+	    for (i = 1; i <= argc; i++)
+		find_node(c->data.func.args[i])->uses--;
+	    c = fold(c);
+	    if (is_constant(c))
+		return intern(c);
+	    for (i = 1; i <= argc; i++)
+		find_node(c->data.func.args[i])->uses++;
+	}
+	if (c->data.func.func == f_rand)
+	    return c;
+	return intern(c);
+    case expr_type_binding:
+	/* a map written to the output keeps its own node, the categories
+	   and colors are copied from it */
+	if (e->data.bind.val->type == expr_type_map) {
+	    c->data.bind.val = G_malloc(sizeof(expression));
+	    *c->data.bind.val = *e->data.bind.val;
+	}
+	else
+	    c->data.bind.val = canonical(e->data.bind.val);
+	if (num_binds >= max_binds) {
+	    max_binds += 10;
+	    bind_orig = G_realloc(bind_orig, max_binds * sizeof(expression *));
+	    bind_copy = G_realloc(bind_copy, max_binds * sizeof(expression *));
+	}
+	bind_orig[num_binds] = e;
+	bind_copy[num_binds] = c;
+	num_binds++;
+	return c;
+    default:
+	G_fatal_error(_("Unknown type: %d"), e->type);
+	return NULL;
+    }
+}
+
+static expression *reference(expression * bind)
+{
+    expression *e = G_malloc(sizeof(expression));
+
+    e->type = expr_type_variable;
+    e->res_type = bind->res_type;
+    e->buf = NULL;
+    e->data.var.name = bind->data.bind.var;
+    e->data.var.bind = bind;
+
+    return e;
+}
+
+/* turn the DAG into a tree in the order of evaluation */
+static expression *emit(expression * e)
+{
+    node *n = find_node(e);
+    expression *c;
+    int i;
+
+    if (n && n->bind)
+	return reference(n->bind);
+
+    if (n && n->emitted) {
+	/* constants and variables are copied */
+	c = G_malloc(sizeof(expression));
+	*c = *e;
+	return c;
+    }
+
+    switch (e->type) {
+    case expr_type_function:
+	for (i = 1; i <= e->data.func.argc; i++)
+	    e->data.func.args[i] = emit(e->data.func.args[i]);
+	break;
+    case expr_type_binding:
+	e->data.bind.val = emit(e->data.bind.val);
+	break;
+    }
+
+    if (!n)
+	return e;
+
+    n->emitted = 1;
+
+    if (n->uses > 1 &&
+	(e->type == expr_type_function || e->type == expr_type_map)) {
+	char name[32];
+
+	sprintf(name, "_%d", ++num_shared);
+	n->bind = binding(G_store(name), e);
+	return n->bind;
+    }
+
+    return e;
+}
+
+static void free_nodes(void)
+{
+    node *n, *next;
+    int i;
+
+    for (i = 0; i < NUM_BUCKETS; i++) {
+	for (n = nodes[i]; n; n = next) {
+	    next = n->next;
+	    G_free(n);
+	}
+	nodes[i] = ptrs[i] = NULL;
+    }
+}
+
+/****************************************************************************/
+
+expr_list *optimize(expr_list * ee)
+{
+    expr_list *l, *head = NULL, **tail = &head;
+
+    num_binds = num_nodes = num_shared = num_folded = 0;
+
+    for (l = ee; l; l = l->next) {
+	*tail = list(canonical(l->exp), NULL);
+	tail = &(*tail)->next;
+    }
+
+    for (l = head; l; l = l->next)
+	l->exp = emit(l->exp);
+
+    free_nodes();
+
+    G_debug(1, "optimize: %d distinct nodes, %d shared, %d folded",
+	    num_nodes, num_shared, num_folded);
+
+    for (l = head; l; l = l->next)
+	G_debug(1, "plan: %s", format_expression(l->exp));
+
+    return head;
+}
+
+/****************************************************************************/
@@ -8,7 +8,7 @@
 and(a,b) = a && b
 ****************************************************************/
 
-int f_and(int argc, const int *argt, void **args)
+int f_and(int argc, const int *argt, void **args, int ncols)
 {
     CELL *res = args[0];
     CELL *arg1 = args[1];
@@ -26,11 +26,11 @@ int f_and(int argc, const int *argt, void **args)
     if (argt[0] != CELL_TYPE)
 	return E_RES_TYPE;
 
-    for (i = 0; i < columns; i++) {
-	if (IS_NULL_C(&arg1[i]) || IS_NULL_C(&arg2[i]))
-	    SET_NULL_C(&res[i]);
-	else
-	    res[i] = arg1[i] && arg2[i];
+    for (i = 0; i < ncols; i++) {
+	CELL a = arg1[i], b = arg2[i];
+
+	res[i] = (IS_NULL_C(&a) | IS_NULL_C(&b)) ? NULL_CELL
+	    : (a != 0) & (b != 0);
     }
 
     return 0;
@@ -15,7 +15,7 @@ Differs from and() in that the boolean axioms:
 hold even when x is null.
 ****************************************************************/
 
-int f_and2(int argc, const int *argt, void **args)
+int f_and2(int argc, const int *argt, void **args, int ncols)
 {
     CELL *res = args[0];
     CELL *arg1 = args[1];
@@ -33,15 +33,12 @@ int f_and2(int argc, const int *argt, void **args)
     if (argt[0] != CELL_TYPE)
 	return E_RES_TYPE;
 
-    for (i = 0; i < columns; i++) {
-	if (!IS_NULL_C(&arg1[i]) && !arg1[i])
-	    res[i] = 0;
-	else if (!IS_NULL_C(&arg2[i]) && !arg2[i])
-	    res[i] = 0;
-	else if (IS_NULL_C(&arg1[i]) || IS_NULL_C(&arg2[i]))
-	    SET_NULL_C(&res[i]);
-	else
-	    res[i] = 1;
+    /* null is not 0 */
+    for (i = 0; i < ncols; i++) {
+	CELL a = arg1[i], b = arg2[i];
+
+	res[i] = ((a == 0) | (b == 0)) ? 0
+	    : (IS_NULL_C(&a) | IS_NULL_C(&b)) ? NULL_CELL : 1;
     }
 
     return 0;
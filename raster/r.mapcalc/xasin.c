@@ -18,7 +18,7 @@ asin(x)  range [-90,90]
 
 #define RADIANS_TO_DEGREES (180.0 / M_PI)
 
-int f_asin(int argc, const int *argt, void **args)
+int f_asin(int argc, const int *argt, void **args, int ncols)
 {
     DCELL *res = args[0];
     DCELL *arg1 = args[1];
@@ -35,7 +35,7 @@ int f_asin(int argc, const int *argt, void **args)
     if (argt[1] != DCELL_TYPE)
 	return E_ARG_TYPE;
 
-    for (i = 0; i < columns; i++)
+    for (i = 0; i < ncols; i++)
 	if (IS_NULL_D(&arg1[i]))
 	    SET_NULL_D(&res[i]);
 	else {
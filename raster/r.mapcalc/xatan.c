@@ -19,7 +19,7 @@ atan(x,y) = atan(y/x) range[0,360]
 
 #define RADIANS_TO_DEGREES (180.0 / M_PI)
 
-int f_atan(int argc, const int *argt, void **args)
+int f_atan(int argc, const int *argt, void **args, int ncols)
 {
     DCELL *res = args[0];
     DCELL *arg1 = args[1];
@@ -42,7 +42,7 @@ int f_atan(int argc, const int *argt, void **args)
 
     arg2 = (argc > 1) ? args[2] : NULL;
 
-    for (i = 0; i < columns; i++)
+    for (i = 0; i < ncols; i++)
 	if (IS_NULL_D(&arg1[i]))
 	    SET_NULL_D(&res[i]);
 	else if (argc > 1 && IS_NULL_D(&arg2[i]))
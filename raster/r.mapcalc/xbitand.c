@@ -8,7 +8,7 @@
 bitand(a,b) = a & b
 ****************************************************************/
 
-int f_bitand(int argc, const int *argt, void **args)
+int f_bitand(int argc, const int *argt, void **args, int ncols)
 {
     CELL *res = args[0];
     CELL *arg1 = args[1];
@@ -26,7 +26,7 @@ int f_bitand(int argc, const int *argt, void **args)
     if (argt[0] != CELL_TYPE)
 	return E_RES_TYPE;
 
-    for (i = 0; i < columns; i++) {
+    for (i = 0; i < ncols; i++) {
 	if (IS_NULL_C(&arg1[i]) || IS_NULL_C(&arg2[i]))
 	    SET_NULL_C(&res[i]);
 	else
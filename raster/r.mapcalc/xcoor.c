@@ -11,7 +11,7 @@ y() northing at center of row
 z() height at center of depth
 **********************************************************************/
 
-int f_x(int argc, const int *argt, void **args)
+int f_x(int argc, const int *argt, void **args, int ncols)
 {
     DCELL *res = args[0];
     DCELL x;
@@ -25,7 +25,7 @@ int f_x(int argc, const int *argt, void **args)
 
     x = G_col_to_easting(0.5, &current_region2);
 
-    for (i = 0; i < columns; i++) {
+    for (i = 0; i < ncols; i++) {
 	res[i] = x;
 	x += current_region2.ew_res;
     }
@@ -33,7 +33,7 @@ int f_x(int argc, const int *argt, void **args)
     return 0;
 }
 
-int f_y(int argc, const int *argt, void **args)
+int f_y(int argc, const int *argt, void **args, int ncols)
 {
     DCELL *res = args[0];
     DCELL y;
@@ -47,13 +47,13 @@ int f_y(int argc, const int *argt, void **args)
 
     y = G_row_to_northing(current_row + 0.5, &current_region2);
 
-    for (i = 0; i < columns; i++)
+    for (i = 0; i < ncols; i++)
 	res[i] = y;
 
     return 0;
 }
 
-int f_z(int argc, const int *argt, void **args)
+int f_z(int argc, const int *argt, void **args, int ncols)
 {
     DCELL *res = args[0];
     int i;
@@ -64,7 +64,7 @@ int f_z(int argc, const int *argt, void **args)
     if (argt[0] != DCELL_TYPE)
 	return E_RES_TYPE;
 
-    for (i = 0; i < columns; i++)
+    for (i = 0; i < ncols; i++)
 	SET_NULL_D(&res[i]);
 
     return 0;
@@ -12,7 +12,7 @@ y() northing at center of row
 z() height at center of depth
 **********************************************************************/
 
-int f_x(int argc, const int *argt, void **args)
+int f_x(int argc, const int *argt, void **args, int ncols)
 {
     G3D_Region *window = &current_region3;
     DCELL *res = args[0];
@@ -27,7 +27,7 @@ int f_x(int argc, const int *argt, void **args)
 
     x = window->west + 0.5 * window->ew_res;
 
-    for (i = 0; i < columns; i++) {
+    for (i = 0; i < ncols; i++) {
 	res[i] = x;
 	x += window->ew_res;
     }
@@ -35,7 +35,7 @@ int f_x(int argc, const int *argt, void **args)
     return 0;
 }
 
-int f_y(int argc, const int *argt, void **args)
+int f_y(int argc, const int *argt, void **args, int ncols)
 {
     G3D_Region *window = &current_region3;
     DCELL *res = args[0];
@@ -50,13 +50,13 @@ int f_y(int argc, const int *argt, void **args)
 
     y = window->north - (current_row + 0.5) * window->ns_res;
 
-    for (i = 0; i < columns; i++)
+    for (i = 0; i < ncols; i++)
 	res[i] = y;
 
     return 0;
 }
 
-int f_z(int argc, const int *argt, void **args)
+int f_z(int argc, const int *argt, void **args, int ncols)
 {
     G3D_Region *window = &current_region3;
     DCELL *res = args[0];
@@ -71,7 +71,7 @@ int f_z(int argc, const int *argt, void **args)
 
     z = window->bottom + ((current_depth) + 0.5) * window->tb_res;
 
-    for (i = 0; i < columns; i++)
+    for (i = 0; i < ncols; i++)
 	res[i] = z;
 
     return 0;
@@ -8,7 +8,7 @@
 div(a,b) = a / b
 ****************************************************************/
 
-int f_div(int argc, const int *argt, void **args)
+int f_div(int argc, const int *argt, void **args, int ncols)
 {
     int i;
 
@@ -27,7 +27,7 @@ int f_div(int argc, const int *argt, void **args)
 	    CELL *arg1 = args[1];
 	    CELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = 0; i < ncols; i++) {
 		if (IS_NULL_C(&arg1[i]) || IS_NULL_C(&arg2[i]) ||
 		    arg2[i] == 0)
 		    SET_NULL_C(&res[i]);
@@ -41,17 +41,14 @@ int f_div(int argc, const int *argt, void **args)
 	    FCELL *res = args[0];
 	    FCELL *arg1 = args[1];
 	    FCELL *arg2 = args[2];
+	    FCELL null;
 
-	    for (i = 0; i < columns; i++) {
-		if (IS_NULL_F(&arg1[i]) || IS_NULL_F(&arg2[i]) ||
-		    arg2[i] == 0.0f)
-		    SET_NULL_F(&res[i]);
-		else {
-		    floating_point_exception = 0;
-		    res[i] = arg1[i] / arg2[i];
-		    if (floating_point_exception)
-			SET_NULL_F(&res[i]);
-		}
+	    SET_NULL_F(&null);
+
+	    for (i = 0; i < ncols; i++) {
+		res[i] = arg1[i] / arg2[i];
+		if (arg2[i] == 0.0f)
+		    res[i] = null;
 	    }
 	    return 0;
 	}
@@ -60,17 +57,14 @@ int f_div(int argc, const int *argt, void **args)
 	    DCELL *res = args[0];
 	    DCELL *arg1 = args[1];
 	    DCELL *arg2 = args[2];
+	    DCELL null;
 
-	    for (i = 0; i < columns; i++) {
-		if (IS_NULL_D(&arg1[i]) || IS_NULL_D(&arg2[i]) ||
-		    arg2[i] == 0.0)
-		    SET_NULL_D(&res[i]);
-		else {
-		    floating_point_exception = 0;
-		    res[i] = arg1[i] / arg2[i];
-		    if (floating_point_exception)
-			SET_NULL_D(&res[i]);
-		}
+	    SET_NULL_D(&null);
+
+	    for (i = 0; i < ncols; i++) {
+		res[i] = arg1[i] / arg2[i];
+		if (arg2[i] == 0.0)
+		    res[i] = null;
 	    }
 	    return 0;
 	}
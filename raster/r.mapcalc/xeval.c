@@ -10,7 +10,7 @@ eval(..,..,..,x) = x
    return last argument
 **********************************************************************/
 
-int f_eval(int argc, const int *argt, void **args)
+int f_eval(int argc, const int *argt, void **args, int ncols)
 {
     int i;
 
@@ -26,7 +26,7 @@ int f_eval(int argc, const int *argt, void **args)
 	    CELL *res = args[0];
 	    CELL *arg1 = args[argc];
 
-	    for (i = 0; i < columns; i++)
+	    for (i = 0; i < ncols; i++)
 		if (IS_NULL_C(&arg1[i]))
 		    SET_NULL_C(&res[i]);
 		else
@@ -39,7 +39,7 @@ int f_eval(int argc, const int *argt, void **args)
 	    FCELL *res = args[0];
 	    FCELL *arg1 = args[argc];
 
-	    for (i = 0; i < columns; i++)
+	    for (i = 0; i < ncols; i++)
 		if (IS_NULL_F(&arg1[i]))
 		    SET_NULL_F(&res[i]);
 		else
@@ -51,7 +51,7 @@ int f_eval(int argc, const int *argt, void **args)
 	    DCELL *res = args[0];
 	    DCELL *arg1 = args[argc];
 
-	    for (i = 0; i < columns; i++)
+	    for (i = 0; i < ncols; i++)
 		if (IS_NULL_D(&arg1[i]))
 		    SET_NULL_D(&res[i]);
 		else
@@ -14,7 +14,7 @@ exp(x,y) computes x raised to power y
   or exp(x,y) the result is NULL
 **********************************************************************/
 
-int f_exp(int argc, const int *argt, void **args)
+int f_exp(int argc, const int *argt, void **args, int ncols)
 {
     DCELL *res = args[0];
     DCELL *arg1 = args[1];
@@ -34,7 +34,7 @@ int f_exp(int argc, const int *argt, void **args)
 
     arg2 = (argc > 1) ? args[2] : NULL;
 
-    for (i = 0; i < columns; i++)
+    for (i = 0; i < ncols; i++)
 	if (IS_NULL_D(&arg1[i]))
 	    SET_NULL_D(&res[i]);
 	else if (argc > 1 && IS_NULL_D(&arg2[i]))
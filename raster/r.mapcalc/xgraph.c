@@ -27,7 +27,7 @@ int c_graph(int argc, int *argt)
     return 0;
 }
 
-int f_graph(int argc, const int *argt, void **args)
+int f_graph(int argc, const int *argt, void **args, int ncols)
 {
     DCELL **argz = (DCELL **) args;
     DCELL *res = argz[0];
@@ -47,7 +47,7 @@ int f_graph(int argc, const int *argt, void **args)
 	if (argt[i] != DCELL_TYPE)
 	    return E_ARG_TYPE;
 
-    for (i = 0; i < columns; i++) {
+    for (i = 0; i < ncols; i++) {
 #define X(j) (argz[2 + 2 * (j) + 0][i])
 #define Y(j) (argz[2 + 2 * (j) + 1][i])
 #define x (argz[1][i])
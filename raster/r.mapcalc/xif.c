@@ -11,7 +11,7 @@
  if(a,b,c,d)  d,c,b  b if a is positive, c if a is zero, d if a is negative
 ********************************************************************/
 
-static int f_if_i(int argc, const int *argt, void **args)
+static int f_if_i(int argc, const int *argt, void **args, int ncols)
 {
     CELL *res = args[0];
     DCELL *arg1 = args[1];
@@ -20,69 +20,38 @@ static int f_if_i(int argc, const int *argt, void **args)
     CELL *arg4 = (argc >= 4) ? args[4] : NULL;
     int i;
 
+    /* the selected value is copied even if it is null */
     switch (argc) {
     case 0:
 	return E_ARG_LO;
     case 1:
-	for (i = 0; i < columns; i++)
-	    if (IS_NULL_D(&arg1[i]))
-		SET_NULL_C(&res[i]);
-	    else
-		res[i] = arg1[i] != 0.0 ? 1 : 0;
+	for (i = 0; i < ncols; i++) {
+	    DCELL a = arg1[i];
+
+	    res[i] = IS_NULL_D(&a) ? NULL_CELL : a != 0.0;
+	}
 	break;
     case 2:
-	for (i = 0; i < columns; i++)
-	    if (IS_NULL_D(&arg1[i]))
-		SET_NULL_C(&res[i]);
-	    else if (arg1[i] == 0.0)
-		res[i] = 0;
-	    else {
-		if (IS_NULL_C(&arg2[i]))
-		    SET_NULL_C(&res[i]);
-		else
-		    res[i] = arg2[i];
-	    }
+	for (i = 0; i < ncols; i++) {
+	    DCELL a = arg1[i];
+
+	    res[i] = IS_NULL_D(&a) ? NULL_CELL : a == 0.0 ? 0 : arg2[i];
+	}
 	break;
     case 3:
-	for (i = 0; i < columns; i++)
-	    if (IS_NULL_D(&arg1[i]))
-		SET_NULL_C(&res[i]);
-	    else if (arg1[i] == 0.0) {
-		if (IS_NULL_C(&arg3[i]))
-		    SET_NULL_C(&res[i]);
-		else
-		    res[i] = arg3[i];
-	    }
-	    else {
-		if (IS_NULL_C(&arg2[i]))
-		    SET_NULL_C(&res[i]);
-		else
-		    res[i] = arg2[i];
-	    }
+	for (i = 0; i < ncols; i++) {
+	    DCELL a = arg1[i];
+
+	    res[i] = IS_NULL_D(&a) ? NULL_CELL : a == 0.0 ? arg3[i] : arg2[i];
+	}
 	break;
     case 4:
-	for (i = 0; i < columns; i++)
-	    if (IS_NULL_D(&arg1[i]))
-		SET_NULL_C(&res[i]);
-	    else if (arg1[i] == 0.0) {
-		if (IS_NULL_C(&arg3[i]))
-		    SET_NULL_C(&res[i]);
-		else
-		    res[i] = arg3[i];
-	    }
-	    else if (arg1[i] > 0.0) {
-		if (IS_NULL_C(&arg2[i]))
-		    SET_NULL_C(&res[i]);
-		else
-		    res[i] = arg2[i];
-	    }
-	    else {		/* (arg1[i] < 0.0) */
-
-		if (IS_NULL_C(&arg4[i]))
-		    SET_NULL_C(&res[i]);
-		else
-		    res[i] = arg4[i];
-	    }
+	for (i = 0; i < ncols; i++) {
+	    DCELL a = arg1[i];
+
+	    res[i] = IS_NULL_D(&a) ? NULL_CELL
+		: a == 0.0 ? arg3[i] : a > 0.0 ? arg2[i] : arg4[i];
+	}
 	break;
     default:
 	return E_ARG_HI;
@@ -91,73 +60,44 @@ static int f_if_i(int argc, const int *argt, void **args)
     return 0;
 }
 
-static int f_if_f(int argc, const int *argt, void **args)
+static int f_if_f(int argc, const int *argt, void **args, int ncols)
 {
     FCELL *res = args[0];
     DCELL *arg1 = args[1];
     FCELL *arg2 = (argc >= 2) ? args[2] : NULL;
     FCELL *arg3 = (argc >= 3) ? args[3] : NULL;
     FCELL *arg4 = (argc >= 4) ? args[4] : NULL;
+    FCELL null;
     int i;
 
+    SET_NULL_F(&null);
+
     switch (argc) {
     case 0:
 	return E_ARG_LO;
     case 1:
 	return E_ARG_TYPE;
     case 2:
-	for (i = 0; i < columns; i++)
-	    if (IS_NULL_D(&arg1[i]))
-		SET_NULL_F(&res[i]);
-	    else if (arg1[i] == 0.0)
-		res[i] = 0.0;
-	    else {
-		if (IS_NULL_F(&arg2[i]))
-		    SET_NULL_F(&res[i]);
-		else
-		    res[i] = arg2[i];
-	    }
+	for (i = 0; i < ncols; i++) {
+	    DCELL a = arg1[i];
+
+	    res[i] = IS_NULL_D(&a) ? null : a == 0.0 ? 0.0f : arg2[i];
+	}
 	break;
     case 3:
-	for (i = 0; i < columns; i++)
-	    if (IS_NULL_D(&arg1[i]))
-		SET_NULL_F(&res[i]);
-	    else if (arg1[i] == 0.0) {
-		if (IS_NULL_F(&arg3[i]))
-		    SET_NULL_F(&res[i]);
-		else
-		    res[i] = arg3[i];
-	    }
-	    else {
-		if (IS_NULL_F(&arg2[i]))
-		    SET_NULL_F(&res[i]);
-		else
-		    res[i] = arg2[i];
-	    }
+	for (i = 0; i < ncols; i++) {
+	    DCELL a = arg1[i];
+
+	    res[i] = IS_NULL_D(&a) ? null : a == 0.0 ? arg3[i] : arg2[i];
+	}
 	break;
     case 4:
-	for (i = 0; i < columns; i++)
-	    if (IS_NULL_D(&arg1[i]))
-		SET_NULL_F(&res[i]);
-	    else if (arg1[i] == 0.0) {
-		if (IS_NULL_F(&arg3[i]))
-		    SET_NULL_F(&res[i]);
-		else
-		    res[i] = arg3[i];
-	    }
-	    else if (arg1[i] > 0.0) {
-		if (IS_NULL_F(&arg2[i]))
-		    SET_NULL_F(&res[i]);
-		else
-		    res[i] = arg2[i];
-	    }
-	    else {		/* (arg1[i] < 0.0) */
-
-		if (IS_NULL_F(&arg4[i]))
-		    SET_NULL_F(&res[i]);
-		else
-		    res[i] = arg4[i];
-	    }
+	for (i = 0; i < ncols; i++) {
+	    DCELL a = arg1[i];
+
+	    res[i] = IS_NULL_D(&a) ? null
+		: a == 0.0 ? arg3[i] : a > 0.0 ? arg2[i] : arg4[i];
+	}
 	break;
     default:
 	return E_ARG_HI;
@@ -166,73 +106,44 @@ static int f_if_f(int argc, const int *argt, void **args)
     return 0;
 }
 
-static int f_if_d(int argc, const int *argt, void **args)
+static int f_if_d(int argc, const int *argt, void **args, int ncols)
 {
     DCELL *res = args[0];
     DCELL *arg1 = args[1];
     DCELL *arg2 = (argc >= 2) ? args[2] : NULL;
     DCELL *arg3 = (argc >= 3) ? args[3] : NULL;
     DCELL *arg4 = (argc >= 4) ? args[4] : NULL;
+    DCELL null;
     int i;
 
+    SET_NULL_D(&null);
+
     switch (argc) {
     case 0:
 	return E_ARG_LO;
     case 1:
 	return E_ARG_TYPE;
     case 2:
-	for (i = 0; i < columns; i++)
-	    if (IS_NULL_D(&arg1[i]))
-		SET_NULL_D(&res[i]);
-	    else if (arg1[i] == 0.0)
-		res[i] = 0.0;
-	    else {
-		if (IS_NULL_D(&arg2[i]))
-		    SET_NULL_D(&res[i]);
-		else
-		    res[i] = arg2[i];
-	    }
+	for (i = 0; i < ncols; i++) {
+	    DCELL a = arg1[i];
+
+	    res[i] = IS_NULL_D(&a) ? null : a == 0.0 ? 0.0 : arg2[i];
+	}
 	break;
     case 3:
-	for (i = 0; i < columns; i++)
-	    if (IS_NULL_D(&arg1[i]))
-		SET_NULL_D(&res[i]);
-	    else if (arg1[i] == 0.0) {
-		if (IS_NULL_D(&arg3[i]))
-		    SET_NULL_D(&res[i]);
-		else
-		    res[i] = arg3[i];
-	    }
-	    else {
-		if (IS_NULL_D(&arg2[i]))
-		    SET_NULL_D(&res[i]);
-		else
-		    res[i] = arg2[i];
-	    }
+	for (i = 0; i < ncols; i++) {
+	    DCELL a = arg1[i];
+
+	    res[i] = IS_NULL_D(&a) ? null : a == 0.0 ? arg3[i] : arg2[i];
+	}
 	break;
     case 4:
-	for (i = 0; i < columns; i++)
-	    if (IS_NULL_D(&arg1[i]))
-		SET_NULL_D(&res[i]);
-	    else if (arg1[i] == 0.0) {
-		if (IS_NULL_D(&arg3[i]))
-		    SET_NULL_D(&res[i]);
-		else
-		    res[i] = arg3[i];
-	    }
-	    else if (arg1[i] > 0.0) {
-		if (IS_NULL_D(&arg2[i]))
-		    SET_NULL_D(&res[i]);
-		else
-		    res[i] = arg2[i];
-	    }
-	    else {		/* (arg1[i] < 0.0) */
-
-		if (IS_NULL_D(&arg4[i]))
-		    SET_NULL_D(&res[i]);
-		else
-		    res[i] = arg4[i];
-	    }
+	for (i = 0; i < ncols; i++) {
+	    DCELL a = arg1[i];
+
+	    res[i] = IS_NULL_D(&a) ? null
+		: a == 0.0 ? arg3[i] : a > 0.0 ? arg2[i] : arg4[i];
+	}
 	break;
     default:
 	return E_ARG_HI;
@@ -241,7 +152,7 @@ static int f_if_d(int argc, const int *argt, void **args)
     return 0;
 }
 
-int f_if(int argc, const int *argt, void **args)
+int f_if(int argc, const int *argt, void **args, int ncols)
 {
     if (argc < 1)
 	return E_ARG_LO;
@@ -259,11 +170,11 @@ int f_if(int argc, const int *argt, void **args)
 
     switch (argt[0]) {
     case CELL_TYPE:
-	return f_if_i(argc, argt, args);
+	return f_if_i(argc, argt, args, ncols);
     case FCELL_TYPE:
-	return f_if_f(argc, argt, args);
+	return f_if_f(argc, argt, args, ncols);
     case DCELL_TYPE:
-	return f_if_d(argc, argt, args);
+	return f_if_d(argc, argt, args, ncols);
     default:
 	return E_INV_TYPE;
     }
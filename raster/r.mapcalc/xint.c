@@ -11,7 +11,7 @@ int(x)
   converts x to int
 **********************************************************************/
 
-int f_int(int argc, const int *argt, void **args)
+int f_int(int argc, const int *argt, void **args, int ncols)
 {
     CELL *res = args[0];
     int i;
@@ -29,7 +29,7 @@ int f_int(int argc, const int *argt, void **args)
 	{
 	    CELL *arg1 = args[1];
 
-	    for (i = 0; i < columns; i++)
+	    for (i = 0; i < ncols; i++)
 		if (IS_NULL_C(&arg1[i]))
 		    SET_NULL_C(&res[i]);
 		else
@@ -40,7 +40,7 @@ int f_int(int argc, const int *argt, void **args)
 	{
 	    FCELL *arg1 = args[1];
 
-	    for (i = 0; i < columns; i++)
+	    for (i = 0; i < ncols; i++)
 		if (IS_NULL_F(&arg1[i]))
 		    SET_NULL_C(&res[i]);
 		else
@@ -51,7 +51,7 @@ int f_int(int argc, const int *argt, void **args)
 	{
 	    DCELL *arg1 = args[1];
 
-	    for (i = 0; i < columns; i++)
+	    for (i = 0; i < ncols; i++)
 		if (IS_NULL_D(&arg1[i]))
 		    SET_NULL_C(&res[i]);
 		else
@@ -9,7 +9,7 @@ isnull(x)
   return 1 if x is null, 0 otherwise
 **********************************************************************/
 
-int f_isnull(int argc, const int *argt, void **args)
+int f_isnull(int argc, const int *argt, void **args, int ncols)
 {
     int *res = args[0];
     int i;
@@ -27,7 +27,7 @@ int f_isnull(int argc, const int *argt, void **args)
 	{
 	    CELL *arg1 = args[1];
 
-	    for (i = 0; i < columns; i++)
+	    for (i = 0; i < ncols; i++)
 		res[i] = IS_NULL_C(&arg1[i]) ? 1 : 0;
 	    return 0;
 	}
@@ -35,7 +35,7 @@ int f_isnull(int argc, const int *argt, void **args)
 	{
 	    FCELL *arg1 = args[1];
 
-	    for (i = 0; i < columns; i++)
+	    for (i = 0; i < ncols; i++)
 		res[i] = IS_NULL_F(&arg1[i]) ? 1 : 0;
 	    return 0;
 	}
@@ -43,7 +43,7 @@ int f_isnull(int argc, const int *argt, void **args)
 	{
 	    DCELL *arg1 = args[1];
 
-	    for (i = 0; i < columns; i++)
+	    for (i = 0; i < ncols; i++)
 		res[i] = IS_NULL_D(&arg1[i]) ? 1 : 0;
 	    return 0;
 	}
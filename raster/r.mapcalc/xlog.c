@@ -20,7 +20,7 @@ log(x,b)
   computing ln(b), the result is NULL
 **********************************************************************/
 
-int f_log(int argc, const int *argt, void **args)
+int f_log(int argc, const int *argt, void **args, int ncols)
 {
     DCELL *res = args[0];
     DCELL *arg1 = args[1];
@@ -42,7 +42,7 @@ int f_log(int argc, const int *argt, void **args)
     if (argc > 1 && argt[2] != DCELL_TYPE)
 	return E_ARG_TYPE;
 
-    for (i = 0; i < columns; i++)
+    for (i = 0; i < ncols; i++)
 	if (IS_NULL_D(&arg1[i]) || (arg1[i] <= 0.0))
 	    SET_NULL_D(&res[i]);
 	else if (argc > 1 && (IS_NULL_D(&arg2[i]) || (arg2[i] <= 0.0)))
@@ -43,18 +43,12 @@ static int dcmp(const void *aa, const void *bb)
     return 0;
 }
 
-int f_median(int argc, const int *argt, void **args)
+int f_median(int argc, const int *argt, void **args, int ncols)
 {
-    static void *array;
-    static int alloc;
-    int size = argc * G_raster_size(argt[0]);
+    /* per call, rows may be evaluated by several threads */
+    void *array = G_malloc(argc * G_raster_size(argt[0]));
     int i, j;
 
-    if (size > alloc) {
-	alloc = size;
-	array = G_realloc(array, size);
-    }
-
     switch (argt[argc]) {
     case CELL_TYPE:
 	{
@@ -64,7 +58,7 @@ int f_median(int argc, const int *argt, void **args)
 	    CELL *a1 = &a[(argc - 1) / 2];
 	    CELL *a2 = &a[argc / 2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = 0; i < ncols; i++) {
 		int nv = 0;
 
 		for (j = 0; j < argc && !nv; j++) {
@@ -82,7 +76,7 @@ int f_median(int argc, const int *argt, void **args)
 		}
 	    }
 
-	    return 0;
+	    break;
 	}
     case FCELL_TYPE:
 	{
@@ -92,7 +86,7 @@ int f_median(int argc, const int *argt, void **args)
 	    FCELL *a1 = &a[(argc - 1) / 2];
 	    FCELL *a2 = &a[argc / 2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = 0; i < ncols; i++) {
 		int nv = 0;
 
 		for (j = 0; j < argc && !nv; j++) {
@@ -110,7 +104,7 @@ int f_median(int argc, const int *argt, void **args)
 		}
 	    }
 
-	    return 0;
+	    break;
 	}
     case DCELL_TYPE:
 	{
@@ -120,7 +114,7 @@ int f_median(int argc, const int *argt, void **args)
 	    DCELL *a1 = &a[(argc - 1) / 2];
 	    DCELL *a2 = &a[argc / 2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = 0; i < ncols; i++) {
 		int nv = 0;
 
 		for (j = 0; j < argc && !nv; j++) {
@@ -138,9 +132,14 @@ int f_median(int argc, const int *argt, void **args)
 		}
 	    }
 
-	    return 0;
+	    break;
 	}
     default:
+	G_free(array);
 	return E_INV_TYPE;
     }
+
+    G_free(array);
+
+    return 0;
 }
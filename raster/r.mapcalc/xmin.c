@@ -10,7 +10,7 @@
 min(x0,x1,...,xn) returns minimum value
 ****************************************************************/
 
-int f_min(int argc, const int *argt, void **args)
+int f_min(int argc, const int *argt, void **args, int ncols)
 {
     int i, j;
 
@@ -23,22 +23,16 @@ int f_min(int argc, const int *argt, void **args)
 	    CELL *res = args[0];
 	    CELL **argz = (CELL **) args;
 
-	    for (i = 0; i < columns; i++) {
-		int nul = 0;
-		CELL min;
-
-		for (j = 1; j <= argc; j++)
-		    if (IS_NULL_C(&argz[j][i]))
-			nul = 1;
-		    else if (j == 1)
-			min = argz[j][i];
-		    else if (min > argz[j][i])
-			min = argz[j][i];
-		if (nul)
-		    SET_NULL_C(&res[i]);
-		else
-		    res[i] = min;
-	    }
+	    for (i = 0; i < ncols; i++)
+		res[i] = argz[1][i];
+
+	    for (j = 2; j <= argc; j++)
+		for (i = 0; i < ncols; i++) {
+		    CELL a = res[i], b = argz[j][i];
+
+		    res[i] = (IS_NULL_C(&a) | IS_NULL_C(&b)) ? NULL_CELL
+			: b < a ? b : a;
+		}
 	    return 0;
 	}
     case FCELL_TYPE:
@@ -46,22 +40,16 @@ int f_min(int argc, const int *argt, void **args)
 	    FCELL *res = args[0];
 	    FCELL **argz = (FCELL **) args;
 
-	    for (i = 0; i < columns; i++) {
-		int nul = 0;
-		FCELL min;
-
-		for (j = 1; j <= argc; j++)
-		    if (IS_NULL_F(&argz[j][i]))
-			nul = 1;
-		    else if (j == 1)
-			min = argz[j][i];
-		    else if (min > argz[j][i])
-			min = argz[j][i];
-		if (nul)
-		    SET_NULL_F(&res[i]);
-		else
-		    res[i] = min;
-	    }
+	    for (i = 0; i < ncols; i++)
+		res[i] = argz[1][i];
+
+	    /* b < a is false if a is null */
+	    for (j = 2; j <= argc; j++)
+		for (i = 0; i < ncols; i++) {
+		    FCELL a = res[i], b = argz[j][i];
+
+		    res[i] = (IS_NULL_F(&b) | (b < a)) ? b : a;
+		}
 
 	    return 0;
 	}
@@ -70,22 +58,16 @@ int f_min(int argc, const int *argt, void **args)
 	    DCELL *res = args[0];
 	    DCELL **argz = (DCELL **) args;
 
-	    for (i = 0; i < columns; i++) {
-		int nul = 0;
-		DCELL min;
-
-		for (j = 1; j <= argc; j++)
-		    if (IS_NULL_D(&argz[j][i]))
-			nul = 1;
-		    else if (j == 1)
-			min = argz[j][i];
-		    else if (min > argz[j][i])
-			min = argz[j][i];
-		if (nul)
-		    SET_NULL_D(&res[i]);
-		else
-		    res[i] = min;
-	    }
+	    for (i = 0; i < ncols; i++)
+		res[i] = argz[1][i];
+
+	    /* b < a is false if a is null */
+	    for (j = 2; j <= argc; j++)
+		for (i = 0; i < ncols; i++) {
+		    DCELL a = res[i], b = argz[j][i];
+
+		    res[i] = (IS_NULL_D(&b) | (b < a)) ? b : a;
+		}
 
 	    return 0;
 	}
@@ -8,7 +8,7 @@
 mod(a,b) = a % b
 ****************************************************************/
 
-int f_mod(int argc, const int *argt, void **args)
+int f_mod(int argc, const int *argt, void **args, int ncols)
 {
     int i;
 
@@ -27,7 +27,7 @@ int f_mod(int argc, const int *argt, void **args)
 	    CELL *arg1 = args[1];
 	    CELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = 0; i < ncols; i++) {
 		if (IS_NULL_C(&arg1[i]) || IS_NULL_C(&arg2[i]))
 		    SET_NULL_C(&res[i]);
 		else
@@ -41,7 +41,7 @@ int f_mod(int argc, const int *argt, void **args)
 	    FCELL *arg1 = args[1];
 	    FCELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = 0; i < ncols; i++) {
 		if (IS_NULL_F(&arg1[i]) || IS_NULL_F(&arg2[i]))
 		    SET_NULL_F(&res[i]);
 		else {
@@ -63,7 +63,7 @@ int f_mod(int argc, const int *argt, void **args)
 	    DCELL *arg1 = args[1];
 	    DCELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = 0; i < ncols; i++) {
 		if (IS_NULL_D(&arg1[i]) || IS_NULL_D(&arg2[i]))
 		    SET_NULL_D(&res[i]);
 		else {
@@ -51,25 +51,18 @@ static double mode(double *value, int argc)
     return mode_v;
 }
 
-int f_mode(int argc, const int *argt, void **args)
+int f_mode(int argc, const int *argt, void **args, int ncols)
 {
-    static double *value;
-    static int value_size;
-    int size = argc * sizeof(double);
+    double *value = G_malloc(argc * sizeof(double));
     int i, j;
 
-    if (size > value_size) {
-	value_size = size;
-	value = G_realloc(value, value_size);
-    }
-
     switch (argt[argc]) {
     case CELL_TYPE:
 	{
 	    CELL *res = args[0];
 	    CELL **argv = (CELL **) & args[1];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = 0; i < ncols; i++) {
 		int nv = 0;
 
 		for (j = 0; j < argc && !nv; j++) {
@@ -84,14 +77,14 @@ int f_mode(int argc, const int *argt, void **args)
 		else
 		    res[i] = (CELL) mode(value, argc);
 	    }
-	    return 0;
+	    break;
 	}
     case FCELL_TYPE:
 	{
 	    FCELL *res = args[0];
 	    FCELL **argv = (FCELL **) & args[1];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = 0; i < ncols; i++) {
 		int nv = 0;
 
 		for (j = 0; j < argc && !nv; j++) {
@@ -106,14 +99,14 @@ int f_mode(int argc, const int *argt, void **args)
 		else
 		    res[i] = (FCELL) mode(value, argc);
 	    }
-	    return 0;
+	    break;
 	}
     case DCELL_TYPE:
 	{
 	    DCELL *res = args[0];
 	    DCELL **argv = (DCELL **) & args[1];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = 0; i < ncols; i++) {
 		int nv = 0;
 
 		for (j = 0; j < argc && !nv; j++) {
@@ -128,9 +121,14 @@ int f_mode(int argc, const int *argt, void **args)
 		else
 		    res[i] = (DCELL) mode(value, argc);
 	    }
-	    return 0;
+	    break;
 	}
     default:
+	G_free(value);
 	return E_INV_TYPE;
     }
+
+    G_free(value);
+
+    return 0;
 }
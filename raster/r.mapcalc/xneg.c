@@ -8,7 +8,7 @@
 neg(x) = -x
 **********************************************************************/
 
-int f_neg(int argc, const int *argt, void **args)
+int f_neg(int argc, const int *argt, void **args, int ncols)
 {
     int i;
 
@@ -26,11 +26,11 @@ int f_neg(int argc, const int *argt, void **args)
 	    CELL *res = args[0];
 	    CELL *arg1 = args[1];
 
-	    for (i = 0; i < columns; i++)
-		if (IS_NULL_C(&arg1[i]))
-		    SET_NULL_C(&res[i]);
-		else
-		    res[i] = -arg1[i];
+	    for (i = 0; i < ncols; i++) {
+		CELL a = arg1[i];
+
+		res[i] = IS_NULL_C(&a) ? NULL_CELL : -a;
+	    }
 	    return 0;
 	}
     case FCELL_TYPE:
@@ -38,11 +38,8 @@ int f_neg(int argc, const int *argt, void **args)
 	    FCELL *res = args[0];
 	    FCELL *arg1 = args[1];
 
-	    for (i = 0; i < columns; i++)
-		if (IS_NULL_F(&arg1[i]))
-		    SET_NULL_F(&res[i]);
-		else
-		    res[i] = -arg1[i];
+	    for (i = 0; i < ncols; i++)
+		res[i] = -arg1[i];
 	    return 0;
 	}
     case DCELL_TYPE:
@@ -50,11 +47,8 @@ int f_neg(int argc, const int *argt, void **args)
 	    DCELL *res = args[0];
 	    DCELL *arg1 = args[1];
 
-	    for (i = 0; i < columns; i++)
-		if (IS_NULL_D(&arg1[i]))
-		    SET_NULL_D(&res[i]);
-		else
-		    res[i] = -arg1[i];
+	    for (i = 0; i < ncols; i++)
+		res[i] = -arg1[i];
 	    return 0;
 	}
     default:
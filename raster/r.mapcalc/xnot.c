@@ -8,7 +8,7 @@
 not(a) = !a
 ****************************************************************/
 
-int f_not(int argc, const int *argt, void **args)
+int f_not(int argc, const int *argt, void **args, int ncols)
 {
     CELL *res = args[0];
     CELL *arg1 = args[1];
@@ -25,11 +25,10 @@ int f_not(int argc, const int *argt, void **args)
     if (argt[0] != CELL_TYPE)
 	return E_RES_TYPE;
 
-    for (i = 0; i < columns; i++) {
-	if (IS_NULL_C(&arg1[i]))
-	    SET_NULL_C(&res[i]);
-	else
-	    res[i] = !arg1[i];
+    for (i = 0; i < ncols; i++) {
+	CELL a = arg1[i];
+
+	res[i] = IS_NULL_C(&a) ? NULL_CELL : a == 0;
     }
 
     return 0;
@@ -8,7 +8,7 @@
 null() null values
 ****************************************************************/
 
-int f_null(int argc, const int *argt, void **args)
+int f_null(int argc, const int *argt, void **args, int ncols)
 {
     CELL *res = args[0];
     int i;
@@ -19,7 +19,7 @@ int f_null(int argc, const int *argt, void **args)
     if (argt[0] != CELL_TYPE)
 	return E_RES_TYPE;
 
-    for (i = 0; i < columns; i++)
+    for (i = 0; i < ncols; i++)
 	SET_NULL_C(&res[i]);
 
     return 0;
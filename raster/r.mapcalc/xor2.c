@@ -15,7 +15,7 @@ Differs from or() in that the boolean axioms:
 hold even when x is null.
 ****************************************************************/
 
-int f_or2(int argc, const int *argt, void **args)
+int f_or2(int argc, const int *argt, void **args, int ncols)
 {
     CELL *res = args[0];
     CELL *arg1 = args[1];
@@ -33,15 +33,12 @@ int f_or2(int argc, const int *argt, void **args)
     if (argt[0] != CELL_TYPE)
 	return E_RES_TYPE;
 
-    for (i = 0; i < columns; i++) {
-	if (!IS_NULL_C(&arg1[i]) && arg1[i])
-	    res[i] = 1;
-	else if (!IS_NULL_C(&arg2[i]) && arg2[i])
-	    res[i] = 1;
-	else if (IS_NULL_C(&arg1[i]) || IS_NULL_C(&arg2[i]))
-	    SET_NULL_C(&res[i]);
-	else
-	    res[i] = 0;
+    for (i = 0; i < ncols; i++) {
+	CELL a = arg1[i], b = arg2[i];
+	int na = IS_NULL_C(&a), nb = IS_NULL_C(&b);
+
+	res[i] = ((!na & (a != 0)) | (!nb & (b != 0))) ? 1
+	    : (na | nb) ? NULL_CELL : 0;
     }
 
     return 0;
@@ -24,7 +24,7 @@ static int ipow(int x, int y)
     return res;
 }
 
-int f_pow(int argc, const int *argt, void **args)
+int f_pow(int argc, const int *argt, void **args, int ncols)
 {
     int i;
 
@@ -43,7 +43,7 @@ int f_pow(int argc, const int *argt, void **args)
 	    CELL *arg1 = args[1];
 	    CELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = 0; i < ncols; i++) {
 		if (IS_NULL_C(&arg1[i]) || IS_NULL_C(&arg2[i]) || arg2[i] < 0)
 		    SET_NULL_C(&res[i]);
 		else
@@ -57,7 +57,7 @@ int f_pow(int argc, const int *argt, void **args)
 	    FCELL *arg1 = args[1];
 	    FCELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = 0; i < ncols; i++) {
 		if (IS_NULL_F(&arg1[i]) || IS_NULL_F(&arg2[i]))
 		    SET_NULL_F(&res[i]);
 		else if (arg1[i] < 0 && arg2[i] != ceil(arg2[i]))
@@ -77,7 +77,7 @@ int f_pow(int argc, const int *argt, void **args)
 	    DCELL *arg1 = args[1];
 	    DCELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = 0; i < ncols; i++) {
 		if (IS_NULL_D(&arg1[i]) || IS_NULL_D(&arg2[i]))
 		    SET_NULL_D(&res[i]);
 		else if (arg1[i] < 0 && arg2[i] != ceil(arg2[i]))
@@ -16,7 +16,7 @@ rand(lo,hi) random values between a and b
 #define mrand48() ((long)rand())
 #endif
 
-int f_rand(int argc, const int *argt, void **args)
+int f_rand(int argc, const int *argt, void **args, int ncols)
 {
     int i;
 
@@ -32,7 +32,7 @@ int f_rand(int argc, const int *argt, void **args)
 	    CELL *arg1 = args[1];
 	    CELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = 0; i < ncols; i++) {
 		unsigned long x = (unsigned long)mrand48();
 		int lo = arg1[i];
 		int hi = arg2[i];
@@ -53,7 +53,7 @@ int f_rand(int argc, const int *argt, void **args)
 	    FCELL *arg1 = args[1];
 	    FCELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = 0; i < ncols; i++) {
 		double x = drand48();
 		FCELL lo = arg1[i];
 		FCELL hi = arg2[i];
@@ -74,7 +74,7 @@ int f_rand(int argc, const int *argt, void **args)
 	    DCELL *arg1 = args[1];
 	    DCELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = 0; i < ncols; i++) {
 		double x = drand48();
 		DCELL lo = arg1[i];
 		DCELL hi = arg2[i];
@@ -11,7 +11,7 @@ nsres() north-south resolution
 tbres() top-bottom resolution
 ****************************************************************/
 
-int f_ewres(int argc, const int *argt, void **args)
+int f_ewres(int argc, const int *argt, void **args, int ncols)
 {
     DCELL *res = args[0];
     int i;
@@ -22,13 +22,13 @@ int f_ewres(int argc, const int *argt, void **args)
     if (argt[0] != DCELL_TYPE)
 	return E_RES_TYPE;
 
-    for (i = 0; i < columns; i++)
+    for (i = 0; i < ncols; i++)
 	res[i] = current_region2.ew_res;
 
     return 0;
 }
 
-int f_nsres(int argc, const int *argt, void **args)
+int f_nsres(int argc, const int *argt, void **args, int ncols)
 {
     DCELL *res = args[0];
     int i;
@@ -39,13 +39,13 @@ int f_nsres(int argc, const int *argt, void **args)
     if (argt[0] != DCELL_TYPE)
 	return E_RES_TYPE;
 
-    for (i = 0; i < columns; i++)
+    for (i = 0; i < ncols; i++)
 	res[i] = current_region2.ns_res;
 
     return 0;
 }
 
-int f_tbres(int argc, const int *argt, void **args)
+int f_tbres(int argc, const int *argt, void **args, int ncols)
 {
     DCELL *res = args[0];
     int i;
@@ -56,7 +56,7 @@ int f_tbres(int argc, const int *argt, void **args)
     if (argt[0] != DCELL_TYPE)
 	return E_RES_TYPE;
 
-    for (i = 0; i < columns; i++)
+    for (i = 0; i < ncols; i++)
 	SET_NULL_D(&res[i]);
 
     return 0;
@@ -12,7 +12,7 @@ nsres() north-south resolution
 tbres() top-bottom resolution
 ****************************************************************/
 
-int f_ewres(int argc, const int *argt, void **args)
+int f_ewres(int argc, const int *argt, void **args, int ncols)
 {
     DCELL *res = args[0];
     int i;
@@ -23,13 +23,13 @@ int f_ewres(int argc, const int *argt, void **args)
     if (argt[0] != DCELL_TYPE)
 	return E_RES_TYPE;
 
-    for (i = 0; i < columns; i++)
+    for (i = 0; i < ncols; i++)
 	res[i] = current_region3.ew_res;
 
     return 0;
 }
 
-int f_nsres(int argc, const int *argt, void **args)
+int f_nsres(int argc, const int *argt, void **args, int ncols)
 {
     DCELL *res = args[0];
     int i;
@@ -40,13 +40,13 @@ int f_nsres(int argc, const int *argt, void **args)
     if (argt[0] != DCELL_TYPE)
 	return E_RES_TYPE;
 
-    for (i = 0; i < columns; i++)
+    for (i = 0; i < ncols; i++)
 	res[i] = current_region3.ns_res;
 
     return 0;
 }
 
-int f_tbres(int argc, const int *argt, void **args)
+int f_tbres(int argc, const int *argt, void **args, int ncols)
 {
     DCELL *res = args[0];
     int i;
@@ -57,7 +57,7 @@ int f_tbres(int argc, const int *argt, void **args)
     if (argt[0] != DCELL_TYPE)
 	return E_RES_TYPE;
 
-    for (i = 0; i < columns; i++)
+    for (i = 0; i < ncols; i++)
 	res[i] = current_region3.tb_res;
 
     return 0;
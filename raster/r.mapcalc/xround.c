@@ -43,7 +43,7 @@ static int i_round(double x)
 
 /**********************************************************************/
 
-int f_round(int argc, const int *argt, void **args)
+int f_round(int argc, const int *argt, void **args, int ncols)
 {
     int *res = args[0];
     int i;
@@ -61,7 +61,7 @@ int f_round(int argc, const int *argt, void **args)
 	{
 	    CELL *arg1 = args[1];
 
-	    for (i = 0; i < columns; i++)
+	    for (i = 0; i < ncols; i++)
 		if (IS_NULL_C(&arg1[i]))
 		    SET_NULL_C(&res[i]);
 		else
@@ -72,7 +72,7 @@ int f_round(int argc, const int *argt, void **args)
 	{
 	    FCELL *arg1 = args[1];
 
-	    for (i = 0; i < columns; i++)
+	    for (i = 0; i < ncols; i++)
 		if (IS_NULL_F(&arg1[i]))
 		    SET_NULL_C(&res[i]);
 		else
@@ -83,7 +83,7 @@ int f_round(int argc, const int *argt, void **args)
 	{
 	    DCELL *arg1 = args[1];
 
-	    for (i = 0; i < columns; i++)
+	    for (i = 0; i < ncols; i++)
 		if (IS_NULL_D(&arg1[i]))
 		    SET_NULL_C(&res[i]);
 		else
@@ -10,7 +10,7 @@ row() row number
 depth() depth number
 **********************************************************************/
 
-int f_col(int argc, const int *argt, void **args)
+int f_col(int argc, const int *argt, void **args, int ncols)
 {
     CELL *res = args[0];
     int i;
@@ -21,13 +21,13 @@ int f_col(int argc, const int *argt, void **args)
     if (argt[0] != CELL_TYPE)
 	return E_RES_TYPE;
 
-    for (i = 0; i < columns; i++)
+    for (i = 0; i < ncols; i++)
 	res[i] = i + 1;
 
     return 0;
 }
 
-int f_row(int argc, const int *argt, void **args)
+int f_row(int argc, const int *argt, void **args, int ncols)
 {
     CELL *res = args[0];
     int row = current_row + 1;
@@ -39,13 +39,13 @@ int f_row(int argc, const int *argt, void **args)
     if (argt[0] != CELL_TYPE)
 	return E_RES_TYPE;
 
-    for (i = 0; i < columns; i++)
+    for (i = 0; i < ncols; i++)
 	res[i] = row;
 
     return 0;
 }
 
-int f_depth(int argc, const int *argt, void **args)
+int f_depth(int argc, const int *argt, void **args, int ncols)
 {
     CELL *res = args[0];
     int depth = current_depth + 1;
@@ -57,7 +57,7 @@ int f_depth(int argc, const int *argt, void **args)
     if (argt[0] != CELL_TYPE)
 	return E_RES_TYPE;
 
-    for (i = 0; i < columns; i++)
+    for (i = 0; i < ncols; i++)
 	res[i] = depth;
 
     return 0;
@@ -17,7 +17,7 @@ sin(x)
 
 #define DEGREES_TO_RADIANS (M_PI / 180.0)
 
-int f_sin(int argc, const int *argt, void **args)
+int f_sin(int argc, const int *argt, void **args, int ncols)
 {
     DCELL *res = args[0];
     DCELL *arg1 = args[1];
@@ -34,7 +34,7 @@ int f_sin(int argc, const int *argt, void **args)
     if (argt[1] != DCELL_TYPE)
 	return E_ARG_TYPE;
 
-    for (i = 0; i < columns; i++)
+    for (i = 0; i < ncols; i++)
 	if (IS_NULL_D(&arg1[i]))
 	    SET_NULL_D(&res[i]);
 	else {
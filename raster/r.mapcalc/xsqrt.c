@@ -9,11 +9,10 @@
 /**********************************************************************
 sqrt(x) 
 
-  if floating point exception occurs during the evaluation of sqrt(x)
-  the result is NULL
+  the result is NULL if x is negative
 **********************************************************************/
 
-int f_sqrt(int argc, const int *argt, void **args)
+int f_sqrt(int argc, const int *argt, void **args, int ncols)
 {
     DCELL *res = args[0];
     DCELL *arg1 = args[1];
@@ -30,15 +29,9 @@ int f_sqrt(int argc, const int *argt, void **args)
     if (argt[1] != DCELL_TYPE)
 	return E_ARG_TYPE;
 
-    for (i = 0; i < columns; i++)
-	if (IS_NULL_D(&arg1[i]) || (arg1[i] < 0.0))
-	    SET_NULL_D(&res[i]);
-	else {
-	    floating_point_exception = 0;
-	    res[i] = sqrt(arg1[i]);
-	    if (floating_point_exception)
-		SET_NULL_D(&res[i]);
-	}
+    /* the square root of a null or negative number is a NaN */
+    for (i = 0; i < ncols; i++)
+	res[i] = sqrt(arg1[i]);
 
     return 0;
 }
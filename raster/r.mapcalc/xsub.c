@@ -8,7 +8,7 @@
 sub(a,b) = a - b
 ****************************************************************/
 
-int f_sub(int argc, const int *argt, void **args)
+int f_sub(int argc, const int *argt, void **args, int ncols)
 {
     int i;
 
@@ -27,11 +27,10 @@ int f_sub(int argc, const int *argt, void **args)
 	    CELL *arg1 = args[1];
 	    CELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
-		if (IS_NULL_C(&arg1[i]) || IS_NULL_C(&arg2[i]))
-		    SET_NULL_C(&res[i]);
-		else
-		    res[i] = arg1[i] - arg2[i];
+	    for (i = 0; i < ncols; i++) {
+		CELL a = arg1[i], b = arg2[i];
+
+		res[i] = (IS_NULL_C(&a) | IS_NULL_C(&b)) ? NULL_CELL : a - b;
 	    }
 	    return 0;
 	}
@@ -41,12 +40,8 @@ int f_sub(int argc, const int *argt, void **args)
 	    FCELL *arg1 = args[1];
 	    FCELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
-		if (IS_NULL_F(&arg1[i]) || IS_NULL_F(&arg2[i]))
-		    SET_NULL_F(&res[i]);
-		else
-		    res[i] = arg1[i] - arg2[i];
-	    }
+	    for (i = 0; i < ncols; i++)
+		res[i] = arg1[i] - arg2[i];
 	    return 0;
 	}
     case DCELL_TYPE:
@@ -55,12 +50,8 @@ int f_sub(int argc, const int *argt, void **args)
 	    DCELL *arg1 = args[1];
 	    DCELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
-		if (IS_NULL_D(&arg1[i]) || IS_NULL_D(&arg2[i]))
-		    SET_NULL_D(&res[i]);
-		else
-		    res[i] = arg1[i] - arg2[i];
-	    }
+	    for (i = 0; i < ncols; i++)
+		res[i] = arg1[i] - arg2[i];
 	    return 0;
 	}
     default:
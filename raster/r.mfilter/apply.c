@@ -1,5 +1,24 @@
 #include "filter.h"
 
+/* round v / divisor to the nearest integer. negative numbers are
+   rounded a little differently than non-negative numbers */
+static CELL divide(CELL v, int divisor)
+{
+    int round;
+
+    if (!divisor)
+	return 0;
+
+    if (round = divisor / 2) {
+	if ((round > 0 && v > 0) || (round < 0 && v < 0))
+	    v += round;
+	else
+	    v -= round;
+    }
+
+    return v / divisor;
+}
+
 /**************************************************************
  * apply_filter: apply the filter to a single neighborhood
  *
@@ -11,7 +30,6 @@ CELL apply_filter(FILTER * filter, CELL ** input)
     int **matrix;
     int size;
     int divisor;
-    int round;
     register int r, c;
     register CELL v;
 
@@ -35,20 +53,69 @@ CELL apply_filter(FILTER * filter, CELL ** input)
 		    divisor += matrix[r][c];
     }
 
-    /* now round the result to nearest integer. negative numbers are rounded
-       a little differently than non-negative numbers
-     */
-    if (divisor) {
-	if (round = divisor / 2) {
-	    if ((round > 0 && v > 0) || (round < 0 && v < 0))
-		v += round;
-	    else
-		v -= round;
-	}
-	v /= divisor;
+    return divide(v, divisor);
+}
+
+/**************************************************************
+ * apply_separable: apply a separable filter to a whole row
+ *
+ *  filter:    filter to be applied, with rowf and colf
+ *  input:     input buffers
+ *  result:    filtered values for the neighborhoods starting
+ *             at columns 0 to ncells-1 of the buffers
+ *
+ * the columns of the buffers are weighted by rowf first and the
+ * sums are then weighted along the row by colf, which takes
+ * 2*size instead of size*size products per cell. the results are
+ * those of apply_filter().
+ **************************************************************/
+int apply_separable(FILTER * filter, CELL ** input, CELL * result,
+		    int ncells)
+{
+    static CELL *sum, *dsum;
+    static int nalloc;
+    int size = filter->size;
+    int width = ncells + size - 1;
+    register int r, c;
+    register CELL v;
+
+    if (nalloc < width) {
+	nalloc = width;
+	sum = (CELL *) G_realloc(sum, nalloc * sizeof(CELL));
+	dsum = (CELL *) G_realloc(dsum, nalloc * sizeof(CELL));
     }
-    else
+
+    for (c = 0; c < width; c++) {
 	v = 0;
+	for (r = 0; r < size; r++)
+	    v += input[r][c] * filter->rowf[r];
+	sum[c] = v;
+    }
+
+    /* zero divisor: the divisor matrix is added up where the cell
+       value is not zero, as in apply_filter() */
+    if (filter->divisor == 0)
+	for (c = 0; c < width; c++) {
+	    v = 0;
+	    for (r = 0; r < size; r++)
+		if (input[r][c])
+		    v += filter->drowf[r];
+	    dsum[c] = v;
+	}
+
+    for (c = 0; c < ncells; c++) {
+	int divisor = filter->divisor;
+
+	v = 0;
+	for (r = 0; r < size; r++)
+	    v += sum[c + r] * filter->colf[r];
+
+	if (divisor == 0)
+	    for (r = 0; r < size; r++)
+		divisor += dsum[c + r] * filter->dcolf[r];
+
+	result[c] = divide(v, divisor);
+    }
 
-    return v;
+    return 0;
 }
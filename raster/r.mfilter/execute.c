@@ -85,19 +85,29 @@ int execute_filter(ROWIO * r, int out, FILTER * filter, CELL * cell)
 	    *cp++ = bufs[mid][i];
 
 	/* filter row */
-	col = ccount;
-	while (col--) {
-	    if (zero_only) {
-		if (!box[mid][mid])
+	if (filter->rowf && dx == 1) {
+	    apply_separable(filter, box, cp, ccount);
+	    if (zero_only)
+		for (col = 0; col < ccount; col++)
+		    if (box[mid][mid + col])
+			cp[col] = box[mid][mid + col];
+	    cp += ccount;
+	}
+	else {
+	    col = ccount;
+	    while (col--) {
+		if (zero_only) {
+		    if (!box[mid][mid])
+			*cp++ = apply_filter(filter, box);
+		    else
+			*cp++ = box[mid][mid];
+		}
+		else {
 		    *cp++ = apply_filter(filter, box);
-		else
-		    *cp++ = box[mid][mid];
-	    }
-	    else {
-		*cp++ = apply_filter(filter, box);
+		}
+		for (i = 0; i < size; i++)
+		    box[i] += dx;
 	    }
-	    for (i = 0; i < size; i++)
-		box[i] += dx;
 	}
 
 	/* copy border */
@@ -7,6 +7,8 @@ typedef struct
     int divisor;		/* filter scale factor */
     int type;			/* sequential or parallel */
     int start;			/* starting corner */
+    int *rowf, *colf;		/* matrix[r][c] = rowf[r] * colf[c], if any */
+    int *drowf, *dcolf;		/* the same for dmatrix */
 } FILTER;
 
 #define PARALLEL 1
@@ -18,6 +20,7 @@ typedef struct
 
 /* apply.c */
 CELL apply_filter(FILTER *, CELL **);
+int apply_separable(FILTER *, CELL **, CELL *, int);
 
 /* getfilt.c */
 FILTER *get_filter(char *, int *, char *);
@@ -3,6 +3,67 @@
 #include "filter.h"
 #include "local_proto.h"
 
+static int gcd(int a, int b)
+{
+    while (b) {
+	int t = a % b;
+
+	a = b;
+	b = t;
+    }
+
+    return a < 0 ? -a : a;
+}
+
+/* factor matrix into a column and a row of integers, if it has rank 1.
+   all the rows are then multiples of the first non-zero row divided by
+   the gcd of its values, by integer factors */
+static int factor(int **matrix, int n, int **rowf, int **colf)
+{
+    int *u, *v;
+    int p, q, g;
+    int row, col;
+
+    for (p = 0; p < n; p++) {
+	for (q = 0; q < n; q++)
+	    if (matrix[p][q])
+		break;
+	if (q < n)
+	    break;
+    }
+    if (p == n)
+	return 0;
+
+    u = (int *)G_malloc(n * sizeof(int));
+    v = (int *)G_malloc(n * sizeof(int));
+
+    for (col = 0, g = 0; col < n; col++)
+	g = gcd(g, matrix[p][col]);
+    for (col = 0; col < n; col++)
+	v[col] = matrix[p][col] / g;
+
+    for (row = 0; row < n; row++) {
+	if (matrix[row][q] % v[q])
+	    break;
+	u[row] = matrix[row][q] / v[q];
+	for (col = 0; col < n; col++)
+	    if (matrix[row][col] != u[row] * v[col])
+		break;
+	if (col < n)
+	    break;
+    }
+
+    if (row < n) {
+	G_free(u);
+	G_free(v);
+	return 0;
+    }
+
+    *rowf = u;
+    *colf = v;
+    return 1;
+}
+
 FILTER *get_filter(char *name, int *nfilters, char *title)
 {
     FILE *fd;
@@ -155,6 +216,26 @@ FILTER *get_filter(char *name, int *nfilters, char *title)
 	G_fatal_error(_("Illegal filter file format"));
     }
 
+    /* parallel filters of rank 1 can be applied as two 1-D filters */
+    for (n = 0; n < count; n++) {
+	f = &filter[n];
+	f->rowf = f->colf = f->drowf = f->dcolf = NULL;
+
+	if (f->type != PARALLEL ||
+	    !factor(f->matrix, f->size, &f->rowf, &f->colf))
+	    continue;
+
+	if (f->divisor == 0 &&
+	    !factor(f->dmatrix, f->size, &f->drowf, &f->dcolf)) {
+	    G_free(f->rowf);
+	    G_free(f->colf);
+	    f->rowf = f->colf = NULL;
+	    continue;
+	}
+
+	G_debug(1, "filter %d is separable", n + 1);
+    }
+
     *nfilters = count;
     return filter;
 }
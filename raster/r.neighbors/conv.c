@@ -0,0 +1,341 @@
+#include <math.h>
+#include <grass/gis.h>
+#include <grass/gmath.h>
+#include "ncb.h"
+#include "local_proto.h"
+
+#if defined(HAVE_FFTW_H) || defined(HAVE_DFFTW_H) || defined(HAVE_FFTW3_H)
+#define HAVE_FFT
+#endif
+
+/*
+   weighted average and sum of a whole row as convolutions of the
+   values and of the mask of non-null values with the weights: the
+   average is their ratio, the sum the first one. the result is null
+   where the sum of the weights of the non-null values is zero, as in
+   w_ave() and w_sum().
+
+   separable weights (weights[i][j] = u[i] * v[j], such as gaussian or
+   equal weights) are applied to the columns of the bufs first and then
+   along the row. with FFTW, other large weight matrices are applied by
+   multiplying the spectra of the rows of the bufs with those of the
+   rows of the weights; the rows are split into overlapping segments.
+ */
+
+/* smallest neighborhood for which the FFT pays off */
+#define MIN_FFT_SIZE 15
+
+static int width;		/* columns of the bufs used for the row */
+static DCELL *num, *den;	/* the two convolutions for the row */
+static int exact;		/* whether both are integers */
+
+static DCELL *u, *v;		/* factors of separable weights */
+static DCELL *col_num, *col_den;	/* columns weighted by u */
+
+#ifdef HAVE_FFT
+static int use_fft;
+#endif
+
+static int separable(void)
+{
+    int n = ncb.nsize;
+    DCELL max = 0.0;
+    int p = 0, q = 0;
+    int i, j;
+
+    for (i = 0; i < n; i++)
+	for (j = 0; j < n; j++)
+	    if (fabs(ncb.weights[i][j]) > max) {
+		max = fabs(ncb.weights[i][j]);
+		p = i;
+		q = j;
+	    }
+
+    if (max == 0.0)
+	return 0;
+
+    u = G_malloc(n * sizeof(DCELL));
+    v = G_malloc(n * sizeof(DCELL));
+
+    for (i = 0; i < n; i++)
+	u[i] = ncb.weights[i][q];
+    for (j = 0; j < n; j++)
+	v[j] = ncb.weights[p][j] / ncb.weights[p][q];
+
+    for (i = 0; i < n; i++)
+	for (j = 0; j < n; j++)
+	    if (fabs(ncb.weights[i][j] - u[i] * v[j]) > 1e-12 * max) {
+		G_free(u);
+		G_free(v);
+		return 0;
+	    }
+
+    return 1;
+}
+
+static void separable_row(void)
+{
+    int n = ncb.nsize;
+    int row, col, j;
+
+    for (col = 0; col < width; col++)
+	col_num[col] = col_den[col] = 0.0;
+
+    for (row = 0; row < n; row++) {
+	const DCELL *buf = ncb.buf[row];
+
+	for (col = 0; col < width; col++)
+	    if (!G_is_d_null_value(&buf[col])) {
+		col_num[col] += u[row] * buf[col];
+		col_den[col] += u[row];
+	    }
+    }
+
+    for (col = 0; col < width - n + 1; col++) {
+	DCELL a = 0.0, b = 0.0;
+
+	for (j = 0; j < n; j++) {
+	    a += v[j] * col_num[col + j];
+	    b += v[j] * col_den[col + j];
+	}
+
+	num[col] = a;
+	den[col] = b;
+    }
+}
+
+/****************************************************************************/
+
+#ifdef HAVE_FFT
+
+/*
+   each segment of a row is transformed with the values as real part
+   and the mask of non-null values as imaginary part. as the weights
+   are real, the inverse transform of the sum of the products of the
+   spectra with those of the reversed rows of the weights gives the
+   numerator as real part and the denominator as imaginary part.
+ */
+
+static int seg_size;		/* length of the transforms, a power of 2 */
+static int seg_step;		/* results per segment */
+static int num_segs;
+
+static double (**spectra)[2];	/* per row of the bufs, all segments */
+static double (**kernel)[2];	/* per row of the weights */
+static double (*acc)[2];
+static int *count;		/* non-null values per column of the bufs */
+static DCELL min_den;		/* smaller denominators are zero */
+static int primed;
+
+static void transform_row(double (*spec)[2], const DCELL * buf)
+{
+    int s, k;
+
+    for (s = 0; s < num_segs; s++) {
+	double (*data)[2] = spec + s * seg_size;
+	int start = s * seg_step;
+
+	for (k = 0; k < seg_size; k++) {
+	    int col = start + k;
+
+	    if (col >= width || G_is_d_null_value(&buf[col])) {
+		data[k][0] = 0.0;
+		data[k][1] = 0.0;
+	    }
+	    else {
+		data[k][0] = buf[col];
+		data[k][1] = 1.0;
+	    }
+	}
+
+	fft2(-1, data, seg_size, seg_size, 1);
+    }
+}
+
+static void init_fft(void)
+{
+    int n = ncb.nsize;
+    DCELL wsum = 0.0;
+    int i, j;
+
+    seg_size = G_math_max_pow2(4 * n);
+    seg_step = seg_size - n + 1;
+    num_segs = (width - n + 1 + seg_step - 1) / seg_step;
+
+    kernel = G_malloc(n * sizeof(*kernel));
+    for (i = 0; i < n; i++) {
+	kernel[i] = G_calloc(seg_size, sizeof(**kernel));
+	for (j = 0; j < n; j++) {
+	    kernel[i][n - 1 - j][0] = ncb.weights[i][j];
+	    wsum += fabs(ncb.weights[i][j]);
+	}
+	fft2(-1, kernel[i], seg_size, seg_size, 1);
+    }
+
+    spectra = G_malloc(n * sizeof(*spectra));
+    for (i = 0; i < n; i++)
+	spectra[i] = G_malloc(num_segs * seg_size * sizeof(**spectra));
+
+    acc = G_malloc(seg_size * sizeof(*acc));
+    count = G_malloc(width * sizeof(int));
+
+    min_den = 1e-9 * wsum;
+}
+
+/*
+   called once for every row read: only the newest row of the bufs has
+   to be transformed, the spectra of the others are rotated like the
+   bufs themselves
+ */
+static void fft_row(void)
+{
+    int n = ncb.nsize;
+    double scale = sqrt((double)seg_size);
+    int row, s, k, col, total;
+
+    if (!primed) {
+	for (row = 0; row < n; row++)
+	    transform_row(spectra[row], ncb.buf[row]);
+	primed = 1;
+    }
+    else {
+	double (*temp)[2] = spectra[0];
+
+	for (row = 1; row < n; row++)
+	    spectra[row - 1] = spectra[row];
+	spectra[n - 1] = temp;
+	transform_row(temp, ncb.buf[n - 1]);
+    }
+
+    for (s = 0; s < num_segs; s++) {
+	int start = s * seg_step;
+
+	for (k = 0; k < seg_size; k++)
+	    acc[k][0] = acc[k][1] = 0.0;
+
+	for (row = 0; row < n; row++) {
+	    const double (*a)[2] = spectra[row] + s * seg_size;
+	    const double (*b)[2] = kernel[row];
+
+	    for (k = 0; k < seg_size; k++) {
+		acc[k][0] += a[k][0] * b[k][0] - a[k][1] * b[k][1];
+		acc[k][1] += a[k][0] * b[k][1] + a[k][1] * b[k][0];
+	    }
+	}
+
+	fft2(1, acc, seg_size, seg_size, 1);
+
+	for (k = n - 1; k < seg_size; k++) {
+	    col = start + k - (n - 1);
+	    if (col >= width - n + 1)
+		break;
+	    num[col] = acc[k][0] * scale;
+	    den[col] = acc[k][1] * scale;
+	}
+    }
+
+    /* rounding errors make empty windows look like tiny weights */
+    for (col = 0; col < width; col++) {
+	count[col] = 0;
+	for (row = 0; row < n; row++)
+	    if (!G_is_d_null_value(&ncb.buf[row][col]))
+		count[col]++;
+    }
+
+    for (col = 0, total = 0; col < width; col++) {
+	total += count[col];
+	if (col >= n)
+	    total -= count[col - n];
+	if (col >= n - 1 && (total == 0 || fabs(den[col - n + 1]) < min_den))
+	    den[col - n + 1] = 0.0;
+    }
+}
+
+#endif /* HAVE_FFT */
+
+/****************************************************************************/
+
+/* whether the weights are integers */
+static int integer_weights(void)
+{
+    int i, j;
+
+    for (i = 0; i < ncb.nsize; i++)
+	for (j = 0; j < ncb.nsize; j++)
+	    if (ncb.weights[i][j] != floor(ncb.weights[i][j]))
+		return 0;
+
+    return 1;
+}
+
+/* whether the weights can be applied as a convolution; integer is set
+   for CELL maps */
+int init_convolution(int ncols, int integer)
+{
+    width = ncols + ncb.nsize - 1;
+    exact = integer && integer_weights();
+
+    if (separable()) {
+	col_num = G_malloc(width * sizeof(DCELL));
+	col_den = G_malloc(width * sizeof(DCELL));
+    }
+#ifdef HAVE_FFT
+    else if (ncb.nsize >= MIN_FFT_SIZE) {
+	use_fft = 1;
+	init_fft();
+    }
+#endif
+    else
+	return 0;
+
+    num = G_malloc(ncols * sizeof(DCELL));
+    den = G_malloc(ncols * sizeof(DCELL));
+
+    return 1;
+}
+
+static void convolve_row(int ncols)
+{
+    int col;
+
+#ifdef HAVE_FFT
+    if (use_fft)
+	fft_row();
+    else
+#endif
+	separable_row();
+
+    /* the sums of integers are integers, as with w_ave() and w_sum(),
+       whatever the rounding errors of the factors or of the FFT */
+    if (exact)
+	for (col = 0; col < ncols; col++) {
+	    num[col] = floor(num[col] + 0.5);
+	    den[col] = floor(den[col] + 0.5);
+	}
+}
+
+void s_ave_w(DCELL * result, int ncols)
+{
+    int col;
+
+    convolve_row(ncols);
+
+    for (col = 0; col < ncols; col++)
+	if (den[col] == 0.0)
+	    G_set_d_null_value(&result[col], 1);
+	else
+	    result[col] = num[col] / den[col];
+}
+
+void s_sum_w(DCELL * result, int ncols)
+{
+    int col;
+
+    convolve_row(ncols);
+
+    for (col = 0; col < ncols; col++)
+	if (den[col] == 0.0)
+	    G_set_d_null_value(&result[col], 1);
+	else
+	    result[col] = num[col];
+}
@@ -8,6 +8,15 @@ extern void weights_mask(void);
 extern int gather(DCELL *, int);
 extern int gather_w(DCELL(*)[2], int);
 
+/* sliding.c */
+typedef void slide_func(DCELL *, int);
+extern slide_func s_ave, s_median, s_min, s_max, s_range, s_stddev, s_sum,
+    s_var;
+
+/* conv.c */
+extern int init_convolution(int, int);
+extern slide_func s_ave_w, s_sum_w;
+
 /* readcell.c */
 extern int readcell(int, int, int, int);
 
@@ -33,6 +33,8 @@ struct menu
 {
     stat_func *method;		/* routine to compute new value */
     stat_func_w *method_w;	/* routine to compute new value (weighted) */
+    slide_func *slide;		/* routine to compute a row with a sliding window */
+    slide_func *slide_w;	/* routine to compute a row by convolution */
     ifunc cat_names;		/* routine to make category names */
     int copycolr;		/* flag if color table can be copied */
     int half;			/* whether to add 0.5 to result */
@@ -44,20 +46,25 @@ struct menu
 
 /* modify this table to add new methods */
 static struct menu menu[] = {
-    {c_ave, w_ave, NO_CATS, 1, 1, "average", "average value"},
-    {c_median, w_median, NO_CATS, 1, 0, "median", "median value"},
-    {c_mode, w_mode, NO_CATS, 1, 0, "mode", "most frequently occuring value"},
-    {c_min, NULL, NO_CATS, 1, 0, "minimum", "lowest value"},
-    {c_max, NULL, NO_CATS, 1, 0, "maximum", "highest value"},
-    {c_range, NULL, NO_CATS, 1, 0, "range", "range value"},
-    {c_stddev, w_stddev, NO_CATS, 0, 1, "stddev", "standard deviation"},
-    {c_sum, w_sum, NO_CATS, 1, 0, "sum", "sum of values"},
-    {c_var, w_var, NO_CATS, 0, 1, "variance", "statistical variance"},
-    {c_divr, NULL, divr_cats, 0, 0, "diversity",
+    {c_ave, w_ave, s_ave, s_ave_w, NO_CATS, 1, 1, "average",
+     "average value"},
+    {c_median, w_median, s_median, NULL, NO_CATS, 1, 0, "median",
+     "median value"},
+    {c_mode, w_mode, NULL, NULL, NO_CATS, 1, 0, "mode",
+     "most frequently occuring value"},
+    {c_min, NULL, s_min, NULL, NO_CATS, 1, 0, "minimum", "lowest value"},
+    {c_max, NULL, s_max, NULL, NO_CATS, 1, 0, "maximum", "highest value"},
+    {c_range, NULL, s_range, NULL, NO_CATS, 1, 0, "range", "range value"},
+    {c_stddev, w_stddev, s_stddev, NULL, NO_CATS, 0, 1, "stddev",
+     "standard deviation"},
+    {c_sum, w_sum, s_sum, s_sum_w, NO_CATS, 1, 0, "sum", "sum of values"},
+    {c_var, w_var, s_var, NULL, NO_CATS, 0, 1, "variance",
+     "statistical variance"},
+    {c_divr, NULL, NULL, NULL, divr_cats, 0, 0, "diversity",
      "number of different values"},
-    {c_intr, NULL, intr_cats, 0, 0, "interspersion",
+    {c_intr, NULL, NULL, NULL, intr_cats, 0, 0, "interspersion",
      "number of values different than center value"},
-    {0, 0, 0, 0, 0, 0, 0}
+    {0, 0, 0, 0, 0, 0, 0, 0, 0}
 };
 
 struct ncb ncb;
@@ -78,6 +85,7 @@ int main(int argc, char *argv[])
     int half;
     stat_func *newvalue;
     stat_func_w *newvalue_w;
+    slide_func *slide;
     ifunc cat_names;
     struct Colors colr;
     struct Cell_head cellhd;
@@ -296,6 +304,15 @@ int main(int argc, char *argv[])
     if (flag.circle->answer)
 	circle_mask();
 
+    /* compute whole rows at once if the window is used as a whole or
+       if the weights can be applied as a convolution */
+    if (newvalue_w)
+	slide = menu[method].slide_w &&
+	    init_convolution(ncols, map_type == CELL_TYPE)
+	    ? menu[method].slide_w : NULL;
+    else
+	slide = ncb.mask ? NULL : menu[method].slide;
+
     if (newvalue_w)
 	values_w =
 	    (DCELL(*)[2]) G_malloc(ncb.nsize * ncb.nsize * 2 * sizeof(DCELL));
@@ -305,6 +322,17 @@ int main(int argc, char *argv[])
     for (row = 0; row < nrows; row++) {
 	G_percent(row, nrows, 2);
 	readcell(in_fd, readrow++, nrows, ncols);
+
+	if (slide) {
+	    slide(result, ncols);
+	    if (half)
+		for (col = 0; col < ncols; col++)
+		    if (!G_is_d_null_value(&result[col]))
+			result[col] += 0.5;
+	    G_put_d_raster_row(out_fd, result);
+	    continue;
+	}
+
 	for (col = 0; col < ncols; col++) {
 	    DCELL *rp = &result[col];
 
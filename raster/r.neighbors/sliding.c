@@ -0,0 +1,469 @@
+#include <math.h>
+#include <grass/gis.h>
+#include "ncb.h"
+#include "local_proto.h"
+
+/*
+   compute a whole row of the output for a square neighborhood without
+   weights, updating the statistics as the window moves by one column
+   instead of gathering all nsize*nsize values for every cell.
+
+   the columns of the bufs are summarized first (counts and sums, or
+   minimum and maximum of the nsize rows); the window statistics are
+   then updated by the column entering and the column leaving the
+   window. the median is kept in an order statistic tree.
+ */
+
+static int width;		/* columns of the bufs used for the row */
+
+static int *count;		/* per column of the bufs */
+static DCELL *sum1, *sum2;
+static DCELL *col_min, *col_max;
+
+static int *queue;		/* columns for the minimum/maximum */
+
+static void allocate_columns(int ncols)
+{
+    if (width)
+	return;
+
+    width = ncols + ncb.nsize - 1;
+
+    count = G_malloc(width * sizeof(int));
+    sum1 = G_malloc(width * sizeof(DCELL));
+    sum2 = G_malloc(width * sizeof(DCELL));
+    col_min = G_malloc(width * sizeof(DCELL));
+    col_max = G_malloc(width * sizeof(DCELL));
+    queue = G_malloc(width * sizeof(int));
+}
+
+/****************************************************************************/
+
+/* sums of the values less shift, which keeps the sum of squares small
+   compared to the variance */
+static void column_sums(DCELL shift)
+{
+    int row, col;
+
+    for (col = 0; col < width; col++) {
+	count[col] = 0;
+	sum1[col] = sum2[col] = 0.0;
+    }
+
+    for (row = 0; row < ncb.nsize; row++) {
+	const DCELL *buf = ncb.buf[row];
+
+	for (col = 0; col < width; col++) {
+	    DCELL d;
+
+	    if (G_is_d_null_value(&buf[col]))
+		continue;
+
+	    d = buf[col] - shift;
+	    count[col]++;
+	    sum1[col] += d;
+	    sum2[col] += d * d;
+	}
+    }
+}
+
+/* as c_var(), for the window starting at col */
+static DCELL window_var(int col)
+{
+    DCELL sum = 0.0, sumsq = 0.0, ave;
+    int n = 0;
+    int row, i;
+
+    for (row = 0; row < ncb.nsize; row++)
+	for (i = col; i < col + ncb.nsize; i++)
+	    if (!G_is_d_null_value(&ncb.buf[row][i])) {
+		sum += ncb.buf[row][i];
+		n++;
+	    }
+
+    ave = sum / n;
+
+    for (row = 0; row < ncb.nsize; row++)
+	for (i = col; i < col + ncb.nsize; i++)
+	    if (!G_is_d_null_value(&ncb.buf[row][i])) {
+		DCELL d = ncb.buf[row][i] - ave;
+
+		sumsq += d * d;
+	    }
+
+    return sumsq / n;
+}
+
+/* below this fraction of the mean square the variance obtained from
+   the sums is mostly rounding error */
+#define MIN_VAR 1e-8
+
+enum
+{ SUM, AVE, VAR, STDDEV };
+
+static void window_sums(DCELL * result, int ncols, int what)
+{
+    const DCELL *center = ncb.buf[ncb.dist] + ncb.dist;
+    DCELL shift = 0.0, s1 = 0.0, s2 = 0.0, var;
+    int n = 0;
+    int i, col;
+
+    allocate_columns(ncols);
+
+    for (col = 0; col < ncols; col++)
+	if (!G_is_d_null_value(&center[col])) {
+	    shift = center[col];
+	    break;
+	}
+
+    column_sums(shift);
+
+    for (col = 0; col < ncols; col++) {
+	int last = col + ncb.nsize - 1;
+
+	/* start afresh now and then so that rounding errors do not
+	   accumulate along the row */
+	if (col % ncb.nsize == 0) {
+	    n = 0;
+	    s1 = s2 = 0.0;
+	    for (i = col; i <= last; i++) {
+		n += count[i];
+		s1 += sum1[i];
+		s2 += sum2[i];
+	    }
+	}
+	else {
+	    n += count[last] - count[col - 1];
+	    s1 += sum1[last] - sum1[col - 1];
+	    s2 += sum2[last] - sum2[col - 1];
+	}
+
+	if (n == 0) {
+	    G_set_d_null_value(&result[col], 1);
+	    continue;
+	}
+
+	switch (what) {
+	case SUM:
+	    result[col] = shift * n + s1;
+	    break;
+	case AVE:
+	    result[col] = shift + s1 / n;
+	    break;
+	default:
+	    var = (s2 - s1 * s1 / n) / n;
+	    if (var < MIN_VAR * s2 / n)
+		var = window_var(col);
+	    result[col] = what == VAR ? var : sqrt(var);
+	    break;
+	}
+    }
+}
+
+void s_sum(DCELL * result, int ncols)
+{
+    window_sums(result, ncols, SUM);
+}
+
+void s_ave(DCELL * result, int ncols)
+{
+    window_sums(result, ncols, AVE);
+}
+
+void s_var(DCELL * result, int ncols)
+{
+    window_sums(result, ncols, VAR);
+}
+
+void s_stddev(DCELL * result, int ncols)
+{
+    window_sums(result, ncols, STDDEV);
+}
+
+/****************************************************************************/
+
+static void column_extrema(void)
+{
+    int row, col;
+
+    G_set_d_null_value(col_min, width);
+    G_set_d_null_value(col_max, width);
+
+    for (row = 0; row < ncb.nsize; row++) {
+	const DCELL *buf = ncb.buf[row];
+
+	for (col = 0; col < width; col++) {
+	    if (G_is_d_null_value(&buf[col]))
+		continue;
+
+	    if (G_is_d_null_value(&col_min[col]) || col_min[col] > buf[col])
+		col_min[col] = buf[col];
+	    if (G_is_d_null_value(&col_max[col]) || col_max[col] < buf[col])
+		col_max[col] = buf[col];
+	}
+    }
+}
+
+/*
+   the minimum (sign 1) or maximum (sign -1) of the column values in
+   the window: the queue holds the columns of the window which may
+   still become the extremum, their values being increasing (sign 1)
+   or decreasing (sign -1) from head to tail.
+ */
+static void window_extremum(DCELL * result, const DCELL * values, int sign)
+{
+    int head = 0, tail = 0;
+    int i, col;
+
+    for (i = 0; i < width; i++) {
+	if (!G_is_d_null_value(&values[i])) {
+	    while (tail > head &&
+		   sign * values[queue[tail - 1]] >= sign * values[i])
+		tail--;
+	    queue[tail++] = i;
+	}
+
+	col = i - ncb.nsize + 1;
+	if (col < 0)
+	    continue;
+
+	while (tail > head && queue[head] < col)
+	    head++;
+
+	if (tail > head)
+	    result[col] = values[queue[head]];
+	else
+	    G_set_d_null_value(&result[col], 1);
+    }
+}
+
+void s_min(DCELL * result, int ncols)
+{
+    allocate_columns(ncols);
+    column_extrema();
+    window_extremum(result, col_min, 1);
+}
+
+void s_max(DCELL * result, int ncols)
+{
+    allocate_columns(ncols);
+    column_extrema();
+    window_extremum(result, col_max, -1);
+}
+
+void s_range(DCELL * result, int ncols)
+{
+    static DCELL *max;
+    int col;
+
+    if (!max)
+	max = G_allocate_d_raster_buf();
+
+    allocate_columns(ncols);
+    column_extrema();
+    window_extremum(result, col_min, 1);
+    window_extremum(max, col_max, -1);
+
+    for (col = 0; col < ncols; col++)
+	if (!G_is_d_null_value(&result[col]))
+	    result[col] = max[col] - result[col];
+}
+
+/****************************************************************************/
+
+/*
+   order statistic tree: a treap of the distinct values in the window
+   with their number of occurrences. the size of a node is the number
+   of values in its subtree. node 0 is the empty tree.
+ */
+
+struct node
+{
+    DCELL value;
+    int count;
+    int size;
+    unsigned int prio;
+    int left, right;
+};
+
+static struct node *tree;
+static int root;
+static int num_nodes;		/* nodes used since the tree was emptied */
+static int free_node;		/* list of deleted nodes, linked by left */
+static unsigned int seed = 1;
+
+static void empty_tree(void)
+{
+    if (!tree)
+	tree = G_calloc(ncb.nsize * ncb.nsize + 1, sizeof(struct node));
+
+    root = 0;
+    num_nodes = 0;
+    free_node = 0;
+}
+
+static int new_node(DCELL value)
+{
+    int t;
+
+    if (free_node) {
+	t = free_node;
+	free_node = tree[t].left;
+    }
+    else
+	t = ++num_nodes;
+
+    seed = seed * 1103515245 + 12345;
+
+    tree[t].value = value;
+    tree[t].count = tree[t].size = 1;
+    tree[t].prio = seed;
+    tree[t].left = tree[t].right = 0;
+
+    return t;
+}
+
+static void update(int t)
+{
+    tree[t].size = tree[tree[t].left].size + tree[tree[t].right].size +
+	tree[t].count;
+}
+
+static int rotate_right(int t)
+{
+    int l = tree[t].left;
+
+    tree[t].left = tree[l].right;
+    tree[l].right = t;
+    update(t);
+    update(l);
+
+    return l;
+}
+
+static int rotate_left(int t)
+{
+    int r = tree[t].right;
+
+    tree[t].right = tree[r].left;
+    tree[r].left = t;
+    update(t);
+    update(r);
+
+    return r;
+}
+
+static int insert(int t, DCELL value)
+{
+    struct node *n;
+
+    if (!t)
+	return new_node(value);
+
+    n = &tree[t];
+    n->size++;
+
+    if (value < n->value) {
+	n->left = insert(n->left, value);
+	if (tree[n->left].prio > n->prio)
+	    t = rotate_right(t);
+    }
+    else if (value > n->value) {
+	n->right = insert(n->right, value);
+	if (tree[n->right].prio > n->prio)
+	    t = rotate_left(t);
+    }
+    else
+	n->count++;
+
+    return t;
+}
+
+static int merge(int a, int b)
+{
+    if (!a)
+	return b;
+    if (!b)
+	return a;
+
+    if (tree[a].prio > tree[b].prio) {
+	tree[a].right = merge(tree[a].right, b);
+	update(a);
+	return a;
+    }
+
+    tree[b].left = merge(a, tree[b].left);
+    update(b);
+    return b;
+}
+
+/* value must be in the tree */
+static int delete(int t, DCELL value)
+{
+    struct node *n = &tree[t];
+    int m;
+
+    n->size--;
+
+    if (value < n->value)
+	n->left = delete(n->left, value);
+    else if (value > n->value)
+	n->right = delete(n->right, value);
+    else if (--n->count == 0) {
+	m = merge(n->left, n->right);
+	n->left = free_node;
+	free_node = t;
+	return m;
+    }
+
+    return t;
+}
+
+/* the k-th smallest value, counting from 0 */
+static DCELL select_value(int k)
+{
+    int t = root;
+
+    for (;;) {
+	int l = tree[t].left;
+
+	if (k < tree[l].size)
+	    t = l;
+	else {
+	    k -= tree[l].size;
+	    if (k < tree[t].count)
+		return tree[t].value;
+	    k -= tree[t].count;
+	    t = tree[t].right;
+	}
+    }
+}
+
+void s_median(DCELL * result, int ncols)
+{
+    int row, i, col, n;
+
+    allocate_columns(ncols);
+    empty_tree();
+
+    for (i = 0; i < width; i++) {
+	for (row = 0; row < ncb.nsize; row++)
+	    if (!G_is_d_null_value(&ncb.buf[row][i]))
+		root = insert(root, ncb.buf[row][i]);
+
+	col = i - ncb.nsize + 1;
+	if (col < 0)
+	    continue;
+
+	/* as c_median() */
+	n = tree[root].size;
+	if (n == 0)
+	    G_set_d_null_value(&result[col], 1);
+	else
+	    result[col] = (select_value((n - 1) / 2) + select_value(n / 2)) / 2;
+
+	for (row = 0; row < ncb.nsize; row++)
+	    if (!G_is_d_null_value(&ncb.buf[row][col]))
+		root = delete(root, ncb.buf[row][col]);
+    }
+}
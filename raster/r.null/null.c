@@ -139,7 +139,9 @@ int main(int argc, char *argv[])
 
     map_type = G_raster_map_type(name, mapset);
 
-    if (only_null && G_find_file_misc("cell_misc", "null", name, mapset))
+    if (only_null &&
+	(G_find_file_misc("cell_misc", "null", name, mapset) ||
+	 G_find_file_misc("cell_misc", "nullcmpr", name, mapset)))
 	G_fatal_error(_("Raster map <%s> already has a null bitmap file"), name);
 
     if (map_type == CELL_TYPE) {
@@ -170,6 +172,9 @@ int main(int argc, char *argv[])
 	for (col = 0; col < G__null_bitstream_size(cellhd.cols); col++)
 	    null_bits[col] = 0;
 
+	G__file_name_misc(path, "cell_misc", "nullcmpr", name, mapset);
+	unlink(path);
+
 	null_fd = G_open_new_misc("cell_misc", "null", name);
 
 	G_verbose_message(_("Writing new null file for raster map <%s>..."),
@@ -196,6 +201,8 @@ int main(int argc, char *argv[])
 	null_fd = G_open_new_misc("cell_misc", "null", name);
 	G__file_name_misc(path, "cell_misc", "null", name, mapset);
 	unlink(path);
+	G__file_name_misc(path, "cell_misc", "nullcmpr", name, mapset);
+	unlink(path);
 
 	G_done_msg(_("Raster map <%s> modified."), name);
 
@@ -79,16 +79,345 @@ static DCELL **bufs;
 static int method;
 static int row_scale, col_scale;
 
+/* source rows held in bufs */
+static int buf_row0, buf_rows;
+
+/* source rows and columns of the output rows and columns, with the
+   fractions covered at the edges (-w) */
+static int *col_map, *row_map;
+static double *col_mapw, *row_mapw;
+
+/* output row being computed */
+static int maprow0, maprow1;
+static double mapy0, mapy1;
+
+/* the output columns are split among the worker threads */
+struct chunk
+{
+    int col0, col1;
+    DCELL *values;		/* values of a cell, for the stat functions */
+    DCELL(*values_w)[2];
+    DCELL *count, *sum, *sumsq, *min, *max;	/* running aggregates */
+    char *null;
+    void *ref;			/* task handle, see G_begin_execute() */
+};
+
+static struct chunk *chunks;
+static int num_chunks;
+
+static void init_chunks(void)
+{
+    int i;
+
+    num_chunks = G_num_workers() + 1;
+    if (num_chunks > dst_w.cols)
+	num_chunks = dst_w.cols;
+
+    chunks = G_calloc(num_chunks, sizeof(struct chunk));
+
+    for (i = 0; i < num_chunks; i++) {
+	struct chunk *c = &chunks[i];
+	int n;
+
+	c->col0 = (int)((double)dst_w.cols * i / num_chunks);
+	c->col1 = (int)((double)dst_w.cols * (i + 1) / num_chunks);
+	n = c->col1 - c->col0;
+
+	c->values = G_malloc(row_scale * col_scale * sizeof(DCELL));
+	c->values_w = G_malloc(row_scale * col_scale * 2 * sizeof(DCELL));
+	c->count = G_malloc(n * sizeof(DCELL));
+	c->sum = G_malloc(n * sizeof(DCELL));
+	c->sumsq = G_malloc(n * sizeof(DCELL));
+	c->min = G_malloc(n * sizeof(DCELL));
+	c->max = G_malloc(n * sizeof(DCELL));
+	c->null = G_malloc(n);
+    }
+}
+
+static void run_chunks(void (*func) (void *))
+{
+    int i;
+
+    for (i = 0; i < num_chunks; i++)
+	G_begin_execute(func, &chunks[i], &chunks[i].ref, 0);
+
+    for (i = 0; i < num_chunks; i++)
+	G_end_execute(&chunks[i].ref);
+}
+
+/* read source rows maprow0 to maprow1 - 1 into bufs; the rows shared
+   with the previous output row are not read again */
+static void read_rows(void)
+{
+    int count = maprow1 - maprow0;
+    int keep = 0;
+    int i;
+
+    if (buf_rows > 0 && maprow0 >= buf_row0 &&
+	maprow0 < buf_row0 + buf_rows) {
+	int skip = maprow0 - buf_row0;
+
+	keep = buf_rows - skip;
+	if (keep > count)
+	    keep = count;
+
+	/* rotate the kept rows to the front */
+	for (; skip > 0; skip--) {
+	    DCELL *tmp = bufs[0];
+
+	    for (i = 1; i < row_scale; i++)
+		bufs[i - 1] = bufs[i];
+	    bufs[row_scale - 1] = tmp;
+	}
+    }
+
+    G_set_window(&src_w);
+
+    for (i = keep; i < count; i++)
+	G_get_d_raster_row(infile, bufs[i], maprow0 + i);
+
+    buf_row0 = maprow0;
+    buf_rows = count;
+}
+
+/****************************************************************************/
+
+/*
+   average, sum, minimum, maximum, variance and standard deviation are
+   accumulated row by row for all the columns of a chunk instead of
+   gathering the values of each cell. the values of a cell are added
+   in the same order as by the stat functions, so that the results are
+   the same.
+ */
+
+static int streaming_method(int weighted)
+{
+    stat_func *fn = menu[method].method;
+
+    if (weighted)
+	return fn == c_ave || fn == c_sum;
+
+    return fn == c_ave || fn == c_sum || fn == c_min || fn == c_max ||
+	fn == c_var || fn == c_stddev;
+}
+
+static void finish_chunk(struct chunk *c)
+{
+    stat_func *fn = menu[method].method;
+    int k;
+
+    for (k = 0; k < c->col1 - c->col0; k++) {
+	DCELL *dst = &outbuf[c->col0 + k];
+
+	if ((c->null[k] && nulls) || c->count[k] == 0)
+	    G_set_d_null_value(dst, 1);
+	else if (fn == c_ave)
+	    *dst = c->sum[k] / c->count[k];
+	else if (fn == c_sum)
+	    *dst = c->sum[k];
+	else if (fn == c_min)
+	    *dst = c->min[k];
+	else if (fn == c_max)
+	    *dst = c->max[k];
+	else if (fn == c_var)
+	    *dst = c->sumsq[k] / c->count[k];
+	else
+	    *dst = sqrt(c->sumsq[k] / c->count[k]);
+    }
+}
+
+static void aggregate_unweighted(void *closure)
+{
+    struct chunk *c = closure;
+    stat_func *fn = menu[method].method;
+    int n = c->col1 - c->col0;
+    int i, j, k;
+
+    for (k = 0; k < n; k++) {
+	c->count[k] = c->sum[k] = c->sumsq[k] = 0.0;
+	c->null[k] = 0;
+    }
+
+    for (i = 0; i < buf_rows; i++) {
+	const DCELL *buf = bufs[i];
+
+	for (k = 0; k < n; k++) {
+	    int col = c->col0 + k;
+
+	    for (j = col_map[col]; j < col_map[col + 1]; j++) {
+		DCELL v = buf[j];
+
+		if (G_is_d_null_value(&v)) {
+		    c->null[k] = 1;
+		    continue;
+		}
+
+		if (c->count[k] == 0 || c->min[k] > v)
+		    c->min[k] = v;
+		if (c->count[k] == 0 || c->max[k] < v)
+		    c->max[k] = v;
+		c->count[k]++;
+		c->sum[k] += v;
+	    }
+	}
+    }
+
+    /* squared deviations from the average, as c_var() */
+    if (fn == c_var || fn == c_stddev)
+	for (i = 0; i < buf_rows; i++) {
+	    const DCELL *buf = bufs[i];
+
+	    for (k = 0; k < n; k++) {
+		int col = c->col0 + k;
+		DCELL ave = c->sum[k] / c->count[k];
+
+		for (j = col_map[col]; j < col_map[col + 1]; j++) {
+		    DCELL d = buf[j] - ave;
+
+		    if (!G_is_d_null_value(&buf[j]))
+			c->sumsq[k] += d * d;
+		}
+	    }
+	}
+
+    finish_chunk(c);
+}
+
+static void aggregate_weighted(void *closure)
+{
+    struct chunk *c = closure;
+    int n = c->col1 - c->col0;
+    int i, j, k;
+
+    for (k = 0; k < n; k++) {
+	c->count[k] = c->sum[k] = 0.0;
+	c->null[k] = 0;
+    }
+
+    for (i = maprow0; i < maprow1; i++) {
+	const DCELL *buf = bufs[i - maprow0];
+	double ky = (i == maprow0) ? 1 - (mapy0 - maprow0)
+	    : (i == maprow1 - 1) ? 1 - (maprow1 - mapy1)
+	    : 1;
+
+	for (k = 0; k < n; k++) {
+	    int col = c->col0 + k;
+	    double x0 = col_mapw[col + 0];
+	    double x1 = col_mapw[col + 1];
+	    int mapcol0 = (int)floor(x0);
+	    int mapcol1 = (int)ceil(x1);
+
+	    for (j = mapcol0; j < mapcol1; j++) {
+		double kx = (j == mapcol0) ? 1 - (x0 - mapcol0)
+		    : (j == mapcol1 - 1) ? 1 - (mapcol1 - x1)
+		    : 1;
+		DCELL v = buf[j];
+
+		if (G_is_d_null_value(&v)) {
+		    c->null[k] = 1;
+		    continue;
+		}
+
+		c->sum[k] += v * (kx * ky);
+		c->count[k] += kx * ky;
+	    }
+	}
+    }
+
+    finish_chunk(c);
+}
+
+/****************************************************************************/
+
+static void gather_unweighted(void *closure)
+{
+    struct chunk *c = closure;
+    stat_func *method_fn = menu[method].method;
+    DCELL *values = c->values;
+    int col;
+
+    for (col = c->col0; col < c->col1; col++) {
+	int mapcol0 = col_map[col + 0];
+	int mapcol1 = col_map[col + 1];
+	int null = 0;
+	int n = 0;
+	int i, j;
+
+	for (i = maprow0; i < maprow1; i++)
+	    for (j = mapcol0; j < mapcol1; j++) {
+		DCELL *src = &bufs[i - maprow0][j];
+		DCELL *dst = &values[n++];
+
+		if (G_is_d_null_value(src)) {
+		    G_set_d_null_value(dst, 1);
+		    null = 1;
+		}
+		else
+		    *dst = *src;
+	    }
+
+	if (null && nulls)
+	    G_set_d_null_value(&outbuf[col], 1);
+	else
+	    (*method_fn) (&outbuf[col], values, n, NULL);
+    }
+}
+
+static void gather_weighted(void *closure)
+{
+    struct chunk *c = closure;
+    stat_func_w *method_fn = menu[method].method_w;
+    DCELL(*values)[2] = c->values_w;
+    int col;
+
+    for (col = c->col0; col < c->col1; col++) {
+	double x0 = col_mapw[col + 0];
+	double x1 = col_mapw[col + 1];
+	int mapcol0 = (int)floor(x0);
+	int mapcol1 = (int)ceil(x1);
+	int null = 0;
+	int n = 0;
+	int i, j;
+
+	for (i = maprow0; i < maprow1; i++) {
+	    double ky = (i == maprow0) ? 1 - (mapy0 - maprow0)
+		: (i == maprow1 - 1) ? 1 - (maprow1 - mapy1)
+		: 1;
+
+	    for (j = mapcol0; j < mapcol1; j++) {
+		double kx = (j == mapcol0) ? 1 - (x0 - mapcol0)
+		    : (j == mapcol1 - 1) ? 1 - (mapcol1 - x1)
+		    : 1;
+
+		DCELL *src = &bufs[i - maprow0][j];
+		DCELL *dst = &values[n++][0];
+
+		if (G_is_d_null_value(src)) {
+		    G_set_d_null_value(&dst[0], 1);
+		    null = 1;
+		}
+		else {
+		    dst[0] = *src;
+		    dst[1] = kx * ky;
+		}
+	    }
+	}
+
+	if (null && nulls)
+	    G_set_d_null_value(&outbuf[col], 1);
+	else
+	    (*method_fn) (&outbuf[col], values, n, NULL);
+    }
+}
+
+/****************************************************************************/
+
 static void resamp_unweighted(void)
 {
-    stat_func *method_fn;
-    DCELL *values;
-    int *col_map, *row_map;
+    void (*func) (void *);
     int row, col;
 
-    method_fn = menu[method].method;
-
-    values = G_malloc(row_scale * col_scale * sizeof(DCELL));
+    func = streaming_method(0) ? aggregate_unweighted : gather_unweighted;
 
     col_map = G_malloc((dst_w.cols + 1) * sizeof(int));
     row_map = G_malloc((dst_w.rows + 1) * sizeof(int));
@@ -106,43 +435,13 @@ static void resamp_unweighted(void)
     }
 
     for (row = 0; row < dst_w.rows; row++) {
-	int maprow0 = row_map[row + 0];
-	int maprow1 = row_map[row + 1];
-	int count = maprow1 - maprow0;
-	int i;
+	maprow0 = row_map[row + 0];
+	maprow1 = row_map[row + 1];
 
 	G_percent(row, dst_w.rows, 2);
 
-	G_set_window(&src_w);
-
-	for (i = 0; i < count; i++)
-	    G_get_d_raster_row(infile, bufs[i], maprow0 + i);
-
-	for (col = 0; col < dst_w.cols; col++) {
-	    int mapcol0 = col_map[col + 0];
-	    int mapcol1 = col_map[col + 1];
-	    int null = 0;
-	    int n = 0;
-	    int i, j;
-
-	    for (i = maprow0; i < maprow1; i++)
-		for (j = mapcol0; j < mapcol1; j++) {
-		    DCELL *src = &bufs[i - maprow0][j];
-		    DCELL *dst = &values[n++];
-
-		    if (G_is_d_null_value(src)) {
-			G_set_d_null_value(dst, 1);
-			null = 1;
-		    }
-		    else
-			*dst = *src;
-		}
-
-	    if (null && nulls)
-		G_set_d_null_value(&outbuf[col], 1);
-	    else
-		(*method_fn) (&outbuf[col], values, n, NULL);
-	}
+	read_rows();
+	run_chunks(func);
 
 	G_set_window(&dst_w);
 	G_put_d_raster_row(outfile, outbuf);
@@ -151,84 +450,36 @@ static void resamp_unweighted(void)
 
 static void resamp_weighted(void)
 {
-    stat_func_w *method_fn;
-
-    DCELL(*values)[2];
-    double *col_map, *row_map;
+    void (*func) (void *);
     int row, col;
 
-    method_fn = menu[method].method_w;
+    func = streaming_method(1) ? aggregate_weighted : gather_weighted;
 
-    values = G_malloc(row_scale * col_scale * 2 * sizeof(DCELL));
-
-    col_map = G_malloc((dst_w.cols + 1) * sizeof(double));
-    row_map = G_malloc((dst_w.rows + 1) * sizeof(double));
+    col_mapw = G_malloc((dst_w.cols + 1) * sizeof(double));
+    row_mapw = G_malloc((dst_w.rows + 1) * sizeof(double));
 
     for (col = 0; col <= dst_w.cols; col++) {
 	double x = G_col_to_easting(col, &dst_w);
 
-	col_map[col] = G_easting_to_col(x, &src_w);
+	col_mapw[col] = G_easting_to_col(x, &src_w);
     }
 
     for (row = 0; row <= dst_w.rows; row++) {
 	double y = G_row_to_northing(row, &dst_w);
 
-	row_map[row] = G_northing_to_row(y, &src_w);
+	row_mapw[row] = G_northing_to_row(y, &src_w);
     }
 
     for (row = 0; row < dst_w.rows; row++) {
-	double y0 = row_map[row + 0];
-	double y1 = row_map[row + 1];
-	int maprow0 = (int)floor(y0);
-	int maprow1 = (int)ceil(y1);
-	int count = maprow1 - maprow0;
-	int i;
+	mapy0 = row_mapw[row + 0];
+	mapy1 = row_mapw[row + 1];
+	maprow0 = (int)floor(mapy0);
+	maprow1 = (int)ceil(mapy1);
 
 	G_percent(row, dst_w.rows, 2);
 
-	G_set_window(&src_w);
-
-	for (i = 0; i < count; i++)
-	    G_get_d_raster_row(infile, bufs[i], maprow0 + i);
-
-	for (col = 0; col < dst_w.cols; col++) {
-	    double x0 = col_map[col + 0];
-	    double x1 = col_map[col + 1];
-	    int mapcol0 = (int)floor(x0);
-	    int mapcol1 = (int)ceil(x1);
-	    int null = 0;
-	    int n = 0;
-	    int i, j;
-
-	    for (i = maprow0; i < maprow1; i++) {
-		double ky = (i == maprow0) ? 1 - (y0 - maprow0)
-		    : (i == maprow1 - 1) ? 1 - (maprow1 - y1)
-		    : 1;
-
-		for (j = mapcol0; j < mapcol1; j++) {
-		    double kx = (j == mapcol0) ? 1 - (x0 - mapcol0)
-			: (j == mapcol1 - 1) ? 1 - (mapcol1 - x1)
-			: 1;
-
-		    DCELL *src = &bufs[i - maprow0][j];
-		    DCELL *dst = &values[n++][0];
-
-		    if (G_is_d_null_value(src)) {
-			G_set_d_null_value(&dst[0], 1);
-			null = 1;
-		    }
-		    else {
-			dst[0] = *src;
-			dst[1] = kx * ky;
-		    }
-		}
-	    }
-
-	    if (null && nulls)
-		G_set_d_null_value(&outbuf[col], 1);
-	    else
-		(*method_fn) (&outbuf[col], values, n, NULL);
-	}
+	read_rows();
+	run_chunks(func);
 
 	G_set_window(&dst_w);
 	G_put_d_raster_row(outfile, outbuf);
@@ -344,6 +595,8 @@ int main(int argc, char *argv[])
     /* prevent complaints about window changes */
     G_suppress_warnings(1);
 
+    init_chunks();
+
     if (flag.weight->answer && menu[method].method_w)
 	resamp_weighted();
     else
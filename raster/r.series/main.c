@@ -15,6 +15,7 @@
  *****************************************************************************/
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
 #include <unistd.h>
 
 #include <grass/gis.h>
@@ -58,7 +59,6 @@ struct input
 {
     const char *name, *mapset;
     int fd;
-    DCELL *buf;
 };
 
 struct output
@@ -69,8 +69,59 @@ struct output
     stat_func *method_fn;
     double quantile;
     double threshold;
+    int quant_index;		/* in the quantiles of each cell, or -1 */
+};
+
+/* rows read by a worker at a time */
+#define BLOCK_ROWS 16
+
+struct worker
+{
+    struct Raster_reader **readers;	/* private readers of the open inputs */
+    DCELL **bufs;		/* a row of each open input */
+    DCELL *values, *values_tmp;
+    DCELL *quant_results;
+    DCELL **out;		/* block of rows of each output */
+    int first_row, num_rows;	/* block of rows assigned to the worker */
+    void *ref;			/* task handle, see G_begin_execute() */
 };
 
+static int num_inputs;
+static struct input *inputs;
+static int num_outputs;
+static struct output *outputs;
+
+/* all the quantiles of a cell are computed from one partitioning */
+static double *quants;
+static int num_quants;
+
+static int nulls;		/* propagate nulls */
+static int have_range;
+static double lo, hi;
+
+static int nrows, ncols;
+
+/* the inputs read: all of them, or a batch */
+static int first_input, num_open;
+
+static int num_workers;
+static struct worker *workers;
+
+/* running aggregates of a band of rows, updated by each batch of
+   inputs in turn */
+static int batch_mode;
+static struct
+{
+    int first_row, num_rows;
+    int *count;
+    DCELL *sum, *mean, *m2, *min, *max;
+    int *minx, *maxx;
+    char *null;
+} band;
+
+/* bytes of the running aggregates per cell */
+#define BAND_CELL_SIZE (3 * sizeof(int) + 5 * sizeof(DCELL) + 1)
+
 static char *build_method_list(void)
 {
     char *buf = G_malloc(1024);
@@ -90,6 +141,32 @@ static char *build_method_list(void)
     return buf;
 }
 
+/* the quantile computed by a method, or -1 */
+static double method_quantile(stat_func * method_fn, double quantile)
+{
+    if (method_fn == c_quart1)
+	return 0.25;
+    if (method_fn == c_quart3)
+	return 0.75;
+    if (method_fn == c_perc90)
+	return 0.90;
+    if (method_fn == c_quant)
+	return quantile;
+
+    return -1;
+}
+
+/* whether a method can be computed from the running aggregates,
+   without all the values of a cell at once */
+static int batch_method(stat_func * method_fn)
+{
+    return method_fn == c_ave || method_fn == c_count ||
+	method_fn == c_min || method_fn == c_minx ||
+	method_fn == c_max || method_fn == c_maxx ||
+	method_fn == c_range || method_fn == c_sum ||
+	method_fn == c_var || method_fn == c_stddev;
+}
+
 static int find_method(const char *method_name)
 {
     int i;
@@ -103,12 +180,380 @@ static int find_method(const char *method_name)
     return -1;
 }
 
+/****************************************************************************/
+
+static void open_inputs(void)
+{
+    int i;
+
+    for (i = first_input; i < first_input + num_open; i++) {
+	struct input *p = &inputs[i];
+
+	p->fd = G_open_cell_old(p->name, p->mapset);
+	if (p->fd < 0)
+	    G_fatal_error(_("Unable to open raster map <%s> in mapset <%s>"),
+			  p->name, p->mapset);
+    }
+}
+
+static void close_inputs(void)
+{
+    int i;
+
+    for (i = first_input; i < first_input + num_open; i++)
+	G_close_cell(inputs[i].fd);
+}
+
+/* with several workers, each one reads the inputs with its own readers */
+static void open_readers(void)
+{
+    int i, k;
+
+    if (num_workers < 2)
+	return;
+
+    for (k = 0; k < num_workers; k++)
+	for (i = 0; i < num_open; i++) {
+	    workers[k].readers[i] =
+		G_open_raster_reader(inputs[first_input + i].fd);
+	    if (!workers[k].readers[i])
+		G_fatal_error(_("Unable to read raster map <%s>"),
+			      inputs[first_input + i].name);
+	}
+}
+
+static void close_readers(void)
+{
+    int i, k;
+
+    if (num_workers < 2)
+	return;
+
+    for (k = 0; k < num_workers; k++)
+	for (i = 0; i < num_open; i++)
+	    G_close_raster_reader(workers[k].readers[i]);
+}
+
+static void init_workers(int max_open)
+{
+    int k, i;
+
+    num_workers = G_num_workers();
+    /* the calling thread reads a block if all workers are busy */
+    num_workers = num_workers > 0 ? num_workers + 1 : 1;
+
+    workers = G_calloc(num_workers, sizeof(struct worker));
+
+    for (k = 0; k < num_workers; k++) {
+	struct worker *w = &workers[k];
+
+	w->readers = G_malloc(max_open * sizeof(struct Raster_reader *));
+	w->bufs = G_malloc(max_open * sizeof(DCELL *));
+	for (i = 0; i < max_open; i++)
+	    w->bufs[i] = G_allocate_d_raster_buf();
+
+	w->values = G_malloc(num_inputs * sizeof(DCELL));
+	w->values_tmp = G_malloc(num_inputs * sizeof(DCELL));
+	w->quant_results = G_malloc(num_outputs * sizeof(DCELL));
+
+	w->out = G_malloc(num_outputs * sizeof(DCELL *));
+	for (i = 0; i < num_outputs; i++)
+	    w->out[i] = G_malloc(BLOCK_ROWS * ncols * sizeof(DCELL));
+    }
+
+    G_debug(1, "r.series: %d workers", num_workers);
+}
+
+/****************************************************************************/
+
+static void read_inputs(struct worker *w, int row)
+{
+    int i;
+
+    for (i = 0; i < num_open; i++)
+	if (num_workers > 1)
+	    G_reader_get_raster_row(w->readers[i], w->bufs[i], row,
+				    DCELL_TYPE);
+	else
+	    G_get_d_raster_row(inputs[first_input + i].fd, w->bufs[i], row);
+}
+
+/* the value of an open input, null outside the range */
+static DCELL get_value(const struct worker *w, int i, int col)
+{
+    DCELL v = w->bufs[i][col];
+
+    if (have_range && !G_is_d_null_value(&v) && (v < lo || v > hi))
+	G_set_d_null_value(&v, 1);
+
+    return v;
+}
+
+/* the k-th row of the block of the outputs, from all the inputs */
+static void compute_row(struct worker *w, int k)
+{
+    DCELL *values = w->values;
+    DCELL *values_tmp = w->values_tmp;
+    int col, i;
+
+    for (col = 0; col < ncols; col++) {
+	int null = 0;
+
+	for (i = 0; i < num_inputs; i++) {
+	    values[i] = get_value(w, i, col);
+	    if (G_is_d_null_value(&values[i]))
+		null = 1;
+	}
+
+	if (num_quants > 0 && !(null && nulls)) {
+	    memcpy(values_tmp, values, num_inputs * sizeof(DCELL));
+	    c_quants(w->quant_results, values_tmp, num_inputs, quants,
+		     num_quants);
+	}
+
+	for (i = 0; i < num_outputs; i++) {
+	    struct output *out = &outputs[i];
+	    DCELL *result = &w->out[i][k * ncols + col];
+
+	    if (null && nulls)
+		G_set_d_null_value(result, 1);
+	    else if (out->quant_index >= 0)
+		*result = w->quant_results[out->quant_index];
+	    else {
+		memcpy(values_tmp, values, num_inputs * sizeof(DCELL));
+		(*out->method_fn) (result, values_tmp, num_inputs,
+				   &out->threshold);
+	    }
+	}
+    }
+}
+
+/* add a row of the open inputs to the running aggregates of the band */
+static void accumulate_row(struct worker *w, int row)
+{
+    int col, i;
+
+    for (col = 0; col < ncols; col++) {
+	int c = (row - band.first_row) * ncols + col;
+
+	for (i = 0; i < num_open; i++) {
+	    DCELL v = get_value(w, i, col);
+	    DCELL delta;
+	    int n;
+
+	    if (G_is_d_null_value(&v)) {
+		band.null[c] = 1;
+		continue;
+	    }
+
+	    n = ++band.count[c];
+	    band.sum[c] += v;
+
+	    /* Welford's update of the mean and the squared deviations */
+	    delta = v - band.mean[c];
+	    band.mean[c] += delta / n;
+	    band.m2[c] += delta * (v - band.mean[c]);
+
+	    if (n == 1 || band.min[c] > v) {
+		band.min[c] = v;
+		band.minx[c] = first_input + i;
+	    }
+	    if (n == 1 || band.max[c] < v) {
+		band.max[c] = v;
+		band.maxx[c] = first_input + i;
+	    }
+	}
+    }
+}
+
+static void process_block(void *closure)
+{
+    struct worker *w = closure;
+    int k;
+
+    for (k = 0; k < w->num_rows; k++) {
+	read_inputs(w, w->first_row + k);
+
+	if (batch_mode)
+	    accumulate_row(w, w->first_row + k);
+	else
+	    compute_row(w, k);
+    }
+}
+
+/****************************************************************************/
+
+static void write_block(struct worker *w)
+{
+    int k, i;
+
+    G_end_execute(&w->ref);
+
+    for (k = 0; k < w->num_rows; k++)
+	for (i = 0; i < num_outputs; i++)
+	    G_put_d_raster_row(outputs[i].fd, &w->out[i][k * ncols]);
+
+    w->num_rows = 0;
+}
+
+/* all inputs are open; the blocks are handed to the workers round
+   robin and written in order */
+static void process_all(void)
+{
+    int row, i, k;
+
+    first_input = 0;
+    num_open = num_inputs;
+    open_inputs();
+    open_readers();
+
+    for (row = 0, i = 0; row < nrows; row += BLOCK_ROWS) {
+	struct worker *w = &workers[i];
+
+	/* the worker's previous block is the oldest one not written */
+	if (w->num_rows)
+	    write_block(w);
+
+	G_percent(row, nrows, 2);
+
+	w->first_row = row;
+	w->num_rows = nrows - row < BLOCK_ROWS ? nrows - row : BLOCK_ROWS;
+	G_begin_execute(process_block, w, &w->ref, 0);
+
+	i = (i + 1) % num_workers;
+    }
+
+    for (k = 0; k < num_workers; k++) {
+	struct worker *w = &workers[(i + k) % num_workers];
+
+	if (w->num_rows)
+	    write_block(w);
+    }
+
+    G_percent(nrows, nrows, 2);
+
+    close_readers();
+    close_inputs();
+}
+
+static DCELL batch_value(stat_func * method_fn, int c)
+{
+    int n = band.count[c];
+    DCELL result;
+
+    if ((nulls && band.null[c]) || (n == 0 && method_fn != c_count)) {
+	G_set_d_null_value(&result, 1);
+	return result;
+    }
+
+    if (method_fn == c_count)
+	return n;
+    if (method_fn == c_ave)
+	return band.sum[c] / n;
+    if (method_fn == c_sum)
+	return band.sum[c];
+    if (method_fn == c_min)
+	return band.min[c];
+    if (method_fn == c_minx)
+	return band.minx[c];
+    if (method_fn == c_max)
+	return band.max[c];
+    if (method_fn == c_maxx)
+	return band.maxx[c];
+    if (method_fn == c_range)
+	return band.max[c] - band.min[c];
+    if (method_fn == c_var)
+	return band.m2[c] / n;
+
+    return sqrt(band.m2[c] / n);
+}
+
+/* at most batch inputs are open at a time: each band of rows is read
+   from every batch of inputs in turn */
+static void process_batches(int batch, int band_rows)
+{
+    int num_batches = (num_inputs + batch - 1) / batch;
+    int num_bands = (nrows + band_rows - 1) / band_rows;
+    int size = band_rows * ncols;
+    int step = 0;
+    int row, col, i, k;
+
+    band.count = G_malloc(size * sizeof(int));
+    band.sum = G_malloc(size * sizeof(DCELL));
+    band.mean = G_malloc(size * sizeof(DCELL));
+    band.m2 = G_malloc(size * sizeof(DCELL));
+    band.min = G_malloc(size * sizeof(DCELL));
+    band.max = G_malloc(size * sizeof(DCELL));
+    band.minx = G_malloc(size * sizeof(int));
+    band.maxx = G_malloc(size * sizeof(int));
+    band.null = G_malloc(size);
+
+    G_debug(1, "r.series: %d bands of %d rows, %d batches of %d inputs",
+	    num_bands, band_rows, num_batches, batch);
+
+    for (band.first_row = 0; band.first_row < nrows;
+	 band.first_row += band_rows) {
+	band.num_rows = nrows - band.first_row < band_rows
+	    ? nrows - band.first_row : band_rows;
+	size = band.num_rows * ncols;
+
+	memset(band.count, 0, size * sizeof(int));
+	memset(band.null, 0, size);
+	for (i = 0; i < size; i++)
+	    band.sum[i] = band.mean[i] = band.m2[i] = 0.0;
+
+	for (first_input = 0; first_input < num_inputs; first_input += batch) {
+	    G_percent(step++, num_bands * num_batches, 2);
+
+	    num_open = num_inputs - first_input < batch
+		? num_inputs - first_input : batch;
+	    open_inputs();
+	    open_readers();
+
+	    /* the blocks update separate rows of the aggregates */
+	    for (row = band.first_row, i = 0;
+		 row < band.first_row + band.num_rows; row += BLOCK_ROWS) {
+		struct worker *w = &workers[i];
+		int last = band.first_row + band.num_rows;
+
+		G_end_execute(&w->ref);
+		w->first_row = row;
+		w->num_rows = last - row < BLOCK_ROWS ? last - row : BLOCK_ROWS;
+		G_begin_execute(process_block, w, &w->ref, 0);
+
+		i = (i + 1) % num_workers;
+	    }
+
+	    for (k = 0; k < num_workers; k++)
+		G_end_execute(&workers[k].ref);
+
+	    close_readers();
+	    close_inputs();
+	}
+
+	for (row = 0; row < band.num_rows; row++) {
+	    for (i = 0; i < num_outputs; i++) {
+		struct output *out = &outputs[i];
+
+		for (col = 0; col < ncols; col++)
+		    out->buf[col] = batch_value(out->method_fn,
+						row * ncols + col);
+
+		G_put_d_raster_row(out->fd, out->buf);
+	    }
+	}
+    }
+
+    G_percent(step, num_bands * num_batches, 2);
+}
+
 int main(int argc, char *argv[])
 {
     struct GModule *module;
     struct
     {
 	struct Option *input, *output, *method, *quantile, *threshold, *range;
+	struct Option *batch, *memory;
     } parm;
     struct
     {
@@ -117,15 +562,8 @@ int main(int argc, char *argv[])
 	struct Flag *nulls;
     } flag;
     int i;
-    int num_inputs;
-    struct input *inputs;
-    int num_outputs;
-    struct output *outputs;
     struct History history;
-    DCELL *values, *values_tmp;
-    int nrows, ncols;
-    int row, col;
-    double lo, hi;
+    int batch, band_rows;
 
     G_gisinit(argv[0]);
 
@@ -179,6 +617,21 @@ int main(int argc, char *argv[])
     flag.nulls->key = 'n';
     flag.nulls->description = _("Propagate NULLs");
 
+    parm.batch = G_define_option();
+    parm.batch->key = "batch";
+    parm.batch->type = TYPE_INTEGER;
+    parm.batch->required = NO;
+    parm.batch->description =
+	_("Number of input maps open at a time (all if not given)");
+
+    parm.memory = G_define_option();
+    parm.memory->key = "memory";
+    parm.memory->type = TYPE_INTEGER;
+    parm.memory->required = NO;
+    parm.memory->answer = "300";
+    parm.memory->description =
+	_("Maximum memory for the aggregates of batch= (in MB)");
+
     if (G_parser(argc, argv))
 	exit(EXIT_FAILURE);
 
@@ -190,10 +643,13 @@ int main(int argc, char *argv[])
     }
 
     if (parm.range->answer) {
+	have_range = 1;
 	lo = atof(parm.range->answers[0]);
 	hi = atof(parm.range->answers[1]);
     }
 
+    nulls = flag.nulls->answer;
+
     /* process the input maps */
     for (i = 0; parm.input->answers[i]; i++) ;
     num_inputs = i;
@@ -212,13 +668,15 @@ int main(int argc, char *argv[])
 	    G_fatal_error(_("Raster map <%s> not found"), p->name);
 	else
 	    G_message(_("Reading raster map <%s>..."), p->name);
-	p->fd = G_open_cell_old(p->name, p->mapset);
-	if (p->fd < 0)
-	    G_fatal_error(_("Unable to open raster map <%s> in mapset <%s>"),
-			  p->name, p->mapset);
-	p->buf = G_allocate_d_raster_buf();
     }
 
+    batch = parm.batch->answer ? atoi(parm.batch->answer) : num_inputs;
+    if (batch < 1)
+	G_fatal_error(_("batch= must be positive"));
+    if (batch > num_inputs)
+	batch = num_inputs;
+    batch_mode = batch < num_inputs;
+
     /* process the output maps */
     for (i = 0; parm.output->answers[i]; i++) ;
     num_outputs = i;
@@ -229,6 +687,9 @@ int main(int argc, char *argv[])
 
     outputs = G_calloc(num_outputs, sizeof(struct output));
 
+    quants = G_malloc(num_outputs * sizeof(double));
+    num_quants = 0;
+
     for (i = 0; i < num_outputs; i++) {
 	struct output *out = &outputs[i];
 	const char *output_name = parm.output->answers[i];
@@ -237,12 +698,21 @@ int main(int argc, char *argv[])
 
 	out->name = output_name;
 	out->method_fn = menu[method].method;
+	if (batch_mode && !batch_method(out->method_fn))
+	    G_fatal_error(_("Method <%s> needs all input maps at once, "
+			    "batch= can not be used"), method_name);
 	out->quantile = (parm.quantile->answer && parm.quantile->answers[i])
 	    ? atof(parm.quantile->answers[i])
 	    : 0;
 	out->threshold = (parm.threshold->answer && parm.threshold->answers[i])
 	    ? atof(parm.threshold->answers[i])
 	    : 0;
+	out->quant_index = -1;
+	if (method_quantile(out->method_fn, out->quantile) >= 0) {
+	    out->quant_index = num_quants;
+	    quants[num_quants++] =
+		method_quantile(out->method_fn, out->quantile);
+	}
 	out->buf = G_allocate_d_raster_buf();
 	out->fd = G_open_raster_new(
 	    output_name, menu[method].is_int ? CELL_TYPE : DCELL_TYPE);
@@ -250,55 +720,25 @@ int main(int argc, char *argv[])
 	    G_fatal_error(_("Unable to create raster map <%s>"), out->name);
     }
 
-    /* initialise variables */
-    values = G_malloc(num_inputs * sizeof(DCELL));
-    values_tmp = G_malloc(num_inputs * sizeof(DCELL));
-
     nrows = G_window_rows();
     ncols = G_window_cols();
 
+    init_workers(batch);
+
     /* process the data */
     G_verbose_message(_("Percent complete..."));
 
-    for (row = 0; row < nrows; row++) {
-	G_percent(row, nrows, 2);
-
-	for (i = 0; i < num_inputs; i++)
-	    G_get_d_raster_row(inputs[i].fd, inputs[i].buf, row);
-
-	for (col = 0; col < ncols; col++) {
-	    int null = 0;
-
-	    for (i = 0; i < num_inputs; i++) {
-		DCELL v = inputs[i].buf[col];
-
-		if (G_is_d_null_value(&v))
-		    null = 1;
-		else if (parm.range->answer && (v < lo || v > hi)) {
-		    G_set_d_null_value(&v, 1);
-		    null = 1;
-		}
-
-		values[i] = v;
-	    }
-
-	    for (i = 0; i < num_outputs; i++) {
-		struct output *out = &outputs[i];
-
-		if (null && flag.nulls->answer)
-		    G_set_d_null_value(&out->buf[col], 1);
-		else {
-		    memcpy(values_tmp, values, num_inputs * sizeof(DCELL));
-		    (*out->method_fn)(&out->buf[col], values_tmp, num_inputs, &out->threshold);
-		}
-	    }
-	}
-
-	for (i = 0; i < num_outputs; i++)
-	    G_put_d_raster_row(outputs[i].fd, outputs[i].buf);
+    if (batch_mode) {
+	band_rows = (int)(atoi(parm.memory->answer) * 1048576.0 /
+			  (BAND_CELL_SIZE * ncols));
+	if (band_rows < 1)
+	    band_rows = 1;
+	if (band_rows > nrows)
+	    band_rows = nrows;
+	process_batches(batch, band_rows);
     }
-
-    G_percent(row, nrows, 2);
+    else
+	process_all();
 
     /* close maps */
     for (i = 0; i < num_outputs; i++) {
@@ -311,8 +751,5 @@ int main(int argc, char *argv[])
 	G_write_history(out->name, &history);
     }
 
-    for (i = 0; i < num_inputs; i++)
-	G_close_cell(inputs[i].fd);
-
     exit(EXIT_SUCCESS);
 }
@@ -362,6 +362,9 @@ int main(int argc, char *argv[])
 	null_fd = G_open_new_misc("cell_misc", "null", raster->answer);
 	G__file_name_misc(path, "cell_misc", "null", raster->answer, mapset);
 	unlink(path);
+	G__file_name_misc(path, "cell_misc", "nullcmpr", raster->answer,
+			  mapset);
+	unlink(path);
 	close(null_fd);
 
 	G_done_msg(_("Done."));
@@ -703,17 +703,17 @@ int main(int argc, char *argv[])
     /*   Open initialize and segment all files  */
 
     dtm_in_fd = open(dtm_in_file, 2);
-    segment_init(&dtm_in_seg, dtm_in_fd, segments_in_memory);
+    segment_init_mmap(&dtm_in_seg, dtm_in_fd, segments_in_memory);
 
     cost_in_fd = open(cost_in_file, 2);
-    segment_init(&cost_in_seg, cost_in_fd, segments_in_memory);
+    segment_init_mmap(&cost_in_seg, cost_in_fd, segments_in_memory);
 
     out_fd = open(out_file, 2);
-    segment_init(&out_seg, out_fd, segments_in_memory);
+    segment_init_mmap(&out_seg, out_fd, segments_in_memory);
 
     if (dir == 1) {
 	dir_out_fd = open(dir_out_file, 2);
-	segment_init(&out_seg2, dir_out_fd, segments_in_memory);
+	segment_init_mmap(&out_seg2, dir_out_fd, segments_in_memory);
     }
 
     /*   Write the cost layer in the segmented file  */
@@ -32,6 +32,12 @@
 #define TSTSTR(a)	(fprintf (stderr, "%s\n", a))
 #define TST(a)		(fprintf (stderr, "%e\n", (double) (a)))
 
+/* flow accumulation is either DCELL or, where counts of cells are
+ * accumulated (SFD without flow map), int; see init_vars() */
+#define WAT_GET(i) (wat ? wat[(i)] : (DCELL) wat_int[(i)])
+#define WAT_PUT(i, v) \
+	(wat ? (void) (wat[(i)] = (v)) : (void) (wat_int[(i)] = (int) (v)))
+
 #define POINT       struct points
 POINT {
     SHORT r, c; /* , downr, downc */
@@ -51,8 +57,10 @@ extern RAMSEG dis_seg, alt_seg, wat_seg, asp_seg, bas_seg, haf_seg;
 extern RAMSEG r_h_seg, dep_seg;
 extern RAMSEG slp_seg, s_l_seg, s_g_seg, l_s_seg;
 extern int *astar_pts;
-extern CELL *dis, *alt, *asp, *bas, *haf, *r_h, *dep;
+extern CELL *dis, *alt, *bas, *haf, *r_h, *dep;
+extern signed char *asp;
 extern DCELL *wat;
+extern int *wat_int;
 extern int ril_fd;
 extern double *s_l, *s_g, *l_s;
 extern CELL one, zero;
@@ -85,6 +93,7 @@ int close_array_seg(void);
 CELL def_basin(int, int, CELL, double, CELL);
 
 /* do_astar.c */
+int init_buckets(CELL, CELL);
 int do_astar(void);
 int add_pt(SHORT, SHORT, CELL, CELL);
 int drop_pt(void);
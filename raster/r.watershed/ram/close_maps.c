@@ -36,7 +36,7 @@ int close_maps(void)
 		for (r = 0; r < nrows; r++) {
 		    G_set_d_null_value(dbuf, ncols);	/* reset row to all NULL */
 		    for (c = 0; c < ncols; c++) {
-			dvalue = wat[SEG_INDEX(wat_seg, r, c)];
+			dvalue = WAT_GET(SEG_INDEX(wat_seg, r, c));
 			if (G_is_d_null_value(&dvalue) == 0 && dvalue) {
 			    dvalue = ABS(dvalue);
 			    dbuf[c] = dvalue;
@@ -51,7 +51,7 @@ int close_maps(void)
 		for (r = 0; r < nrows; r++) {
 		    G_set_d_null_value(dbuf, ncols);	/* reset row to all NULL */
 		    for (c = 0; c < ncols; c++) {
-			dvalue = wat[SEG_INDEX(wat_seg, r, c)];
+			dvalue = WAT_GET(SEG_INDEX(wat_seg, r, c));
 			if (G_is_d_null_value(&dvalue) == 0 && dvalue) {
 			    dbuf[c] = dvalue;
 			    dvalue = ABS(dvalue);
@@ -169,7 +169,7 @@ int close_maps(void)
 		bas_thres = 60;
 	    for (r = 0; r < nrows; r++) {
 		for (c = 0; c < ncols; c++) {
-		    buf[c] = wat[SEG_INDEX(wat_seg, r, c)];
+		    buf[c] = WAT_GET(SEG_INDEX(wat_seg, r, c));
 		    if (buf[c] < 0) {
 			buf[c] = 0;
 		    }
@@ -194,6 +194,7 @@ int close_maps(void)
        G_free_colors(&colors);
      */
     G_free(wat);
+    G_free(wat_int);
 
     if (ls_flag) {
 	fd = G_open_raster_new(ls_name, DCELL_TYPE);
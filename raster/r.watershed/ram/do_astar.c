@@ -5,6 +5,95 @@
 
 double get_slope2(CELL, CELL, double);
 
+/*
+   priority-flood: when the range of the elevations (integer, or
+   scaled to integer for FP maps) is moderate, the search list is a
+   bucket queue with one FIFO per elevation instead of the heap.
+   points of equal elevation come out in the order they were added,
+   just as with the heap, so that the results do not change, but
+   adding and dropping a point takes constant time, whole plateaus
+   being passed through the same FIFO. a bitmap of the non-empty
+   buckets is scanned for the lowest one. the points of a bucket are
+   linked through heap_index, which is indexed by point then, in a
+   circle: only the last point of a bucket is kept, its successor is
+   the first one. at most a quarter as many buckets as points are used
+   to keep the memory needed small.
+ */
+
+static int use_buckets;
+static CELL bucket_min;
+static int num_buckets, lowest;
+static int *bucket_tail;
+static unsigned int *bucket_bits;
+
+int init_buckets(CELL ele_min, CELL ele_max)
+{
+    int num_words;
+
+    if (ele_min > ele_max ||
+	(double)ele_max - ele_min + 1 > (double)do_points / 4 + MIN_BUCKETS)
+	return 0;
+
+    use_buckets = 1;
+    bucket_min = ele_min;
+    num_buckets = ele_max - ele_min + 1;
+    lowest = num_buckets;
+    num_words = (num_buckets + 31) / 32;
+
+    bucket_tail = (int *)G_malloc(num_buckets * sizeof(int));
+    bucket_bits = (unsigned int *)G_calloc(num_words, sizeof(unsigned int));
+
+    G_debug(1, "A* Search: %d elevation buckets", num_buckets);
+
+    return 1;
+}
+
+static void add_bucket(int point, CELL ele)
+{
+    int b = ele - bucket_min;
+    int tail;
+
+    if (bucket_bits[b >> 5] & (1U << (b & 31))) {
+	tail = bucket_tail[b];
+	heap_index[point] = heap_index[tail];
+	heap_index[tail] = point;
+    }
+    else {
+	bucket_bits[b >> 5] |= 1U << (b & 31);
+	heap_index[point] = point;
+    }
+    bucket_tail[b] = point;
+
+    if (b < lowest)
+	lowest = b;
+}
+
+/* the list must not be empty */
+static int drop_bucket(void)
+{
+    int w = lowest >> 5;
+    unsigned int bits = bucket_bits[w] & (~0U << (lowest & 31));
+    int b, point, tail;
+
+    while (!bits)
+	bits = bucket_bits[++w];
+
+    for (b = w << 5; !(bits & 1); b++)
+	bits >>= 1;
+    lowest = b;
+
+    tail = bucket_tail[b];
+    point = heap_index[tail];
+    if (point == tail)
+	bucket_bits[w] &= ~(1U << (b & 31));
+    else
+	heap_index[tail] = heap_index[point];
+
+    heap_size--;
+
+    return point;
+}
+
 int do_astar(void)
 {
     int count;
@@ -41,7 +130,6 @@ int do_astar(void)
     ns_res = window.ns_res;
 
     count = 0;
-    first_astar = heap_index[1];
     first_cum = do_points;
 
     /* A* Search: search uphill, get downhill paths */
@@ -50,9 +138,7 @@ int do_astar(void)
 
 	/* start with point with lowest elevation, in case of equal elevation
 	 * of following points, oldest point = point added earliest */
-	index_doer = astar_pts[1];
-
-	drop_pt();
+	index_doer = drop_pt();
 
 	/* add astar points to sorted list for flow accumulation */
 	astar_pts[first_cum] = index_doer;
@@ -117,8 +203,8 @@ int do_astar(void)
 		    if (asp[index_up] < 0) {
 			asp[index_up] = drain[upr - r + 1][upc - c + 1];
 
-			if (wat[index_doer] > 0)
-			    wat[index_doer] = -wat[index_doer];
+			if (WAT_GET(index_doer) > 0)
+			    WAT_PUT(index_doer, -WAT_GET(index_doer));
 		    }
 		}
 	    }  /* end if in region */
@@ -130,6 +216,10 @@ int do_astar(void)
 
     flag_destroy(in_list);
     G_free(heap_index);
+    if (use_buckets) {
+	G_free(bucket_tail);
+	G_free(bucket_bits);
+    }
 
     return 0;
 }
@@ -159,6 +249,11 @@ int add_pt(SHORT r, SHORT c, CELL ele, CELL downe)
     if (heap_size > do_points)
 	G_fatal_error(_("heapsize too large"));
 
+    if (use_buckets) {
+	add_bucket(SEG_INDEX(alt_seg, r, c), ele);
+	return 0;
+    }
+
     heap_index[heap_size] = nxt_avail_pt++;
 
     astar_pts[heap_size] = SEG_INDEX(alt_seg, r, c);
@@ -171,16 +266,23 @@ int add_pt(SHORT r, SHORT c, CELL ele, CELL downe)
 }
 
 /* new drop point routine for min heap */
+/* returns the point dropped */
 int drop_pt(void)
 {
     register int child, childr, parent;
     CELL ele, eler;
     register int i;
+    int point;
+
+    if (use_buckets)
+	return drop_bucket();
+
+    point = astar_pts[1];
 
     if (heap_size == 1) {
 	heap_index[1] = -1;
 	heap_size = 0;
-	return 0;
+	return point;
     }
 
     /* start with root */
@@ -236,7 +338,7 @@ int drop_pt(void)
     /* the actual drop */
     heap_size--;
 
-    return 0;
+    return point;
 }
 
 /* standard sift-up routine for d-ary min heap */
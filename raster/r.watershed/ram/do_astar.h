@@ -4,4 +4,7 @@
 #define GET_PARENT(c) (int) (((c) - 2) / 3 + 1)
 #define GET_CHILD(p) (int) (((p) * 3) - 1)
 
+/* elevation buckets used even for few points */
+#define MIN_BUCKETS 65536
+
 #endif /* __DO_ASTAR_H__ */
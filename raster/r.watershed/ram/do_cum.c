@@ -3,72 +3,239 @@
 #include <grass/glocale.h>
 
 
-int do_cum(void)
+/*
+   with worker threads, the SFD flow is accumulated by basins: the
+   cells draining to the same outlet form a tree which the flow of no
+   other cell enters, so that the trees can be processed in parallel,
+   each in the order of the A* search, with the same results. the trees
+   are packed into tasks of about equal numbers of cells and the points
+   of a task are made consecutive in astar_pts. meanwhile the swale
+   flags are kept in one byte per cell, as the bits of a flag byte may
+   belong to different tasks.
+ */
+
+struct task
+{
+    int first, last;		/* range of astar_pts */
+    void *ref;			/* task handle, see G_begin_execute() */
+};
+
+/* tasks per thread, for the load balance */
+#define TASKS_PER_THREAD 4
+
+static SHORT asp_r[9] = { 0, -1, -1, -1, 0, 1, 1, 1, 0 };
+static SHORT asp_c[9] = { 0, 1, 0, -1, -1, -1, 0, 1, 1 };
+
+static int swale_thres;
+static char *swale_bytes;	/* NULL: the swale flags are used */
+
+static int get_swale(int index, int r, int c)
+{
+    if (swale_bytes)
+	return swale_bytes[index];
+
+    return FLAG_GET(swale, r, c);
+}
+
+static void set_swale(int index, int r, int c)
+{
+    if (swale_bytes)
+	swale_bytes[index] = 1;
+    else
+	FLAG_SET(swale, r, c);
+}
+
+/* the point the flow of this_index goes to, -1 if none */
+static int downstream(int this_index)
+{
+    SHORT r, c, dr, dc;
+    CELL aspect;
+
+    aspect = asp[this_index];
+    if (aspect <= 0)
+	return -1;
+
+    seg_index_rc(alt_seg, this_index, &r, &c);
+    dr = r + asp_r[aspect];
+    dc = c + asp_c[aspect];
+    if (dr < 0 || dr >= nrows || dc < 0 || dc >= ncols)
+	return -1;
+
+    return SEG_INDEX(wat_seg, dr, dc);
+}
+
+static void cum_point(int this_index)
 {
     SHORT r, c, dr, dc;
     CELL is_swale, aspect;
     DCELL value, valued;
-    int killer, threshold, count;
-    SHORT asp_r[9] = { 0, -1, -1, -1, 0, 1, 1, 1, 0 };
-    SHORT asp_c[9] = { 0, 1, 0, -1, -1, -1, 0, 1, 1 };
-    int this_index, down_index;
-
-    G_message(_("SECTION 3: Accumulating Surface Flow with SFD."));
+    int down_index;
 
-    count = 0;
-    if (bas_thres <= 0)
-	threshold = 60;
+    aspect = asp[this_index];
+    seg_index_rc(alt_seg, this_index, &r, &c);
+    if (aspect > 0) {
+	dr = r + asp_r[aspect];
+	dc = c + asp_c[aspect];
+    }
     else
-	threshold = bas_thres;
-    for (killer = 1; killer <= do_points; killer++) {
-	G_percent(killer, do_points, 1);
-	this_index = astar_pts[killer];
-	aspect = asp[this_index];
-	seg_index_rc(alt_seg, this_index, &r, &c);
-	if (aspect > 0) {
-	    dr = r + asp_r[aspect];
-	    dc = c + asp_c[aspect];
+	dr = dc = -1;
+    if (dr >= 0 && dr < nrows && dc >= 0 && dc < ncols) { /* if ((dr = astar_pts[killer].downr) > -1) { */
+	down_index = SEG_INDEX(wat_seg, dr, dc);
+	value = WAT_GET(this_index);
+	if ((int)(ABS(value) + 0.5) >= swale_thres)
+	    set_swale(this_index, r, c);
+	valued = WAT_GET(down_index);
+	if (value > 0) {
+	    if (valued > 0)
+		valued += value;
+	    else
+		valued -= value;
 	}
-	else
-	    dr = dc = -1;
-	if (dr >= 0 && dr < nrows && dc >= 0 && dc < ncols) { /* if ((dr = astar_pts[killer].downr) > -1) { */
-	    down_index = SEG_INDEX(wat_seg, dr, dc);
-	    value = wat[this_index];
-	    if ((int)(ABS(value) + 0.5) >= threshold)
-		FLAG_SET(swale, r, c);
-	    valued = wat[down_index];
-	    if (value > 0) {
-		if (valued > 0)
-		    valued += value;
-		else
-		    valued -= value;
-	    }
-	    else {
-		if (valued < 0)
-		    valued += value;
-		else
-		    valued = value - valued;
-	    }
-	    wat[down_index] = valued;
-	    valued = ABS(valued) + 0.5;
-	    is_swale = FLAG_GET(swale, r, c);
-	    /* update asp for depression */
-	    if (is_swale && pit_flag) {
-		if (aspect > 0 && asp[down_index] == 0) {
-		    aspect = -aspect;
-		    asp[this_index] = aspect;
-		}
-	    }
-	    if (is_swale || ((int)valued) >= threshold) {
-		FLAG_SET(swale, dr, dc);
+	else {
+	    if (valued < 0)
+		valued += value;
+	    else
+		valued = value - valued;
+	}
+	WAT_PUT(down_index, valued);
+	valued = ABS(valued) + 0.5;
+	is_swale = get_swale(this_index, r, c);
+	/* update asp for depression */
+	if (is_swale && pit_flag) {
+	    if (aspect > 0 && asp[down_index] == 0) {
+		aspect = -aspect;
+		asp[this_index] = aspect;
 	    }
-	    else {
-		if (er_flag && !is_swale)
-		    slope_length(r, c, dr, dc);
+	}
+	if (is_swale || ((int)valued) >= swale_thres) {
+	    set_swale(down_index, dr, dc);
+	}
+	else {
+	    if (er_flag && !is_swale)
+		slope_length(r, c, dr, dc);
+	}
+    }
+}
+
+static void cum_task(void *closure)
+{
+    struct task *t = closure;
+    int killer;
+
+    for (killer = t->first; killer < t->last; killer++)
+	cum_point(astar_pts[killer]);
+}
+
+static void cum_basins(void)
+{
+    RAMSEG seg;
+    int size = size_array(&seg, nrows, ncols);
+    int *basin, *basin_size, *order;
+    int num_basins, max_basins, num_tasks, max_cells, cells;
+    struct task *tasks;
+    int killer, this_index, down_index, b, t;
+    SHORT r, c;
+
+    /* the basins, from the outlets upstream */
+    basin = (int *)G_malloc(size * sizeof(int));
+    basin_size = NULL;
+    num_basins = max_basins = 0;
+    for (killer = do_points; killer >= 1; killer--) {
+	this_index = astar_pts[killer];
+	down_index = downstream(this_index);
+	if (down_index < 0) {
+	    if (num_basins == max_basins) {
+		max_basins += AR_INCR * 64;
+		basin_size = (int *)G_realloc(basin_size,
+					      max_basins * sizeof(int));
 	    }
+	    b = num_basins++;
+	    basin_size[b] = 0;
+	}
+	else
+	    b = basin[down_index];
+	basin[this_index] = b;
+	basin_size[b]++;
+    }
+
+    /* pack the basins into tasks, basin_size becomes the task */
+    max_cells = do_points / (TASKS_PER_THREAD * (G_num_workers() + 1)) + 1;
+    t = cells = 0;
+    for (b = 0; b < num_basins; b++) {
+	if (cells > 0 && cells + basin_size[b] > max_cells) {
+	    t++;
+	    cells = 0;
 	}
+	cells += basin_size[b];
+	basin_size[b] = t;
+    }
+    num_tasks = t + 1;
+
+    G_debug(1, "SFD: %d basins in %d tasks", num_basins, num_tasks);
+
+    /* make the points of a task consecutive, keeping their order */
+    tasks = (struct task *)G_calloc(num_tasks, sizeof(struct task));
+    for (killer = 1; killer <= do_points; killer++)
+	tasks[basin_size[basin[astar_pts[killer]]]].last++;
+    for (t = 0, cells = 1; t < num_tasks; t++) {
+	tasks[t].first = cells;
+	cells += tasks[t].last;
+	tasks[t].last = tasks[t].first;
+    }
+    order = (int *)G_malloc((do_points + 1) * sizeof(int));
+    for (killer = 1; killer <= do_points; killer++) {
+	this_index = astar_pts[killer];
+	order[tasks[basin_size[basin[this_index]]].last++] = this_index;
     }
     G_free(astar_pts);
+    astar_pts = order;
+    G_free(basin);
+    G_free(basin_size);
+
+    swale_bytes = (char *)G_malloc(size);
+    for (r = 0; r < nrows; r++)
+	for (c = 0; c < ncols; c++)
+	    swale_bytes[SEG_INDEX(wat_seg, r, c)] =
+		FLAG_GET(swale, r, c) ? 1 : 0;
+
+    for (t = 0; t < num_tasks; t++)
+	G_begin_execute(cum_task, &tasks[t], &tasks[t].ref, 0);
+
+    for (t = 0; t < num_tasks; t++) {
+	G_end_execute(&tasks[t].ref);
+	G_percent(t + 1, num_tasks, 1);
+    }
+
+    for (r = 0; r < nrows; r++)
+	for (c = 0; c < ncols; c++)
+	    if (swale_bytes[SEG_INDEX(wat_seg, r, c)])
+		FLAG_SET(swale, r, c);
+
+    G_free(swale_bytes);
+    swale_bytes = NULL;
+    G_free(tasks);
+}
+
+int do_cum(void)
+{
+    int killer;
+
+    G_message(_("SECTION 3: Accumulating Surface Flow with SFD."));
+
+    if (bas_thres <= 0)
+	swale_thres = 60;
+    else
+	swale_thres = bas_thres;
+
+    if (G_num_workers() > 0)
+	cum_basins();
+    else
+	for (killer = 1; killer <= do_points; killer++) {
+	    G_percent(killer, do_points, 1);
+	    cum_point(astar_pts[killer]);
+	}
+
+    G_free(astar_pts);
 
     return 0;
 }
@@ -114,6 +281,7 @@ int do_cum_mfd(void)
     SHORT asp_c[9] = { 0, 1, 0, -1, -1, -1, 0, 1, 1 };
     int this_index, down_index, nbr_index;
 
+    /* fractions of flow are distributed, wat is used as DCELL */
     G_message(_("SECTION 3: Accumulating Surface Flow with MFD."));
     G_debug(1, "MFD convergence factor set to %d.", c_fac);
 
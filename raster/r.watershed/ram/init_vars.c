@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include "Gwater.h"
 #include <grass/gis.h>
 #include <grass/glocale.h>
@@ -9,7 +10,7 @@ int ele_round(double);
 int init_vars(int argc, char *argv[])
 {
     SHORT r, c;
-    CELL *buf, alt_value, asp_value, block_value;
+    CELL *buf, alt_value, asp_value, block_value, ele_min, ele_max;
     DCELL dvalue, wat_value;
     void *elebuf, *ptr;
     int fd, index, ele_map_type;
@@ -129,11 +130,23 @@ int init_vars(int argc, char *argv[])
 
     alt =
 	(CELL *) G_malloc(sizeof(CELL) * size_array(&alt_seg, nrows, ncols));
-    wat =
-	(DCELL *) G_malloc(sizeof(DCELL) *
-			   size_array(&wat_seg, nrows, ncols));
+    /* SFD without flow map accumulates counts of cells, which an int
+       holds exactly in half the memory */
+    if (mfd || run_flag) {
+	wat =
+	    (DCELL *) G_malloc(sizeof(DCELL) *
+			       size_array(&wat_seg, nrows, ncols));
+	wat_int = NULL;
+    }
+    else {
+	wat = NULL;
+	wat_int =
+	    (int *)G_malloc(sizeof(int) * size_array(&wat_seg, nrows, ncols));
+    }
+    /* drainage directions are -8 to 8 */
     asp =
-	(CELL *) G_malloc(size_array(&asp_seg, nrows, ncols) * sizeof(CELL));
+	(signed char *)G_malloc(size_array(&asp_seg, nrows, ncols) *
+				sizeof(signed char));
 
     if (er_flag) {
 	r_h =
@@ -161,6 +174,8 @@ int init_vars(int argc, char *argv[])
     /* intialize accumulation and drainage direction */
     MASK_flag = 0;
     do_points = nrows * ncols;
+    ele_min = INT_MAX;
+    ele_max = -INT_MAX;
     for (r = 0; r < nrows; r++) {
 	G_get_raster_row(fd, elebuf, r, ele_map_type);
 	ptr = elebuf;
@@ -177,7 +192,11 @@ int init_vars(int argc, char *argv[])
 		FLAG_SET(worked, r, c);
 		FLAG_SET(in_list, r, c);
 		G_set_c_null_value(&alt_value, 1);
-		G_set_d_null_value(&wat_value, 1);
+		/* set to zero below, an int can not be null */
+		if (wat)
+		    G_set_d_null_value(&wat_value, 1);
+		else
+		    wat_value = 0.0;
 		do_points--;
 	    }
 	    else {
@@ -194,10 +213,14 @@ int init_vars(int argc, char *argv[])
 		    dvalue *= ele_scale;
 		    alt_value = ele_round(dvalue);
 		}
+		if (ele_min > alt_value)
+		    ele_min = alt_value;
+		if (ele_max < alt_value)
+		    ele_max = alt_value;
 		wat_value = 1.0;
 	    }
 	    alt[index] = alt_value;
-	    wat[index] = wat_value;
+	    WAT_PUT(index, wat_value);
 	    asp[index] = 0;
 	    if (er_flag) {
 		r_h[index] = alt_value;
@@ -223,12 +246,12 @@ int init_vars(int argc, char *argv[])
 		if (MASK_flag) {
 		    index = FLAG_GET(worked, r, c);
 		    if (!index)
-			wat[SEG_INDEX(wat_seg, r, c)] = buf[c];
+			WAT_PUT(SEG_INDEX(wat_seg, r, c), buf[c]);
 		    else
-			wat[SEG_INDEX(wat_seg, r, c)] = 0.0;
+			WAT_PUT(SEG_INDEX(wat_seg, r, c), 0.0);
 		}
 		else
-		    wat[SEG_INDEX(wat_seg, r, c)] = buf[c];
+		    WAT_PUT(SEG_INDEX(wat_seg, r, c), buf[c]);
 	    }
 	}
 	G_close_cell(fd);
@@ -296,9 +319,14 @@ int init_vars(int argc, char *argv[])
 
     astar_pts = (int *) G_malloc((do_points + 1) * sizeof(int));
 
-    /* heap_index will track astar_pts in ternary min-heap */
-    /* heap_index is one-based */
-    heap_index = (int *)G_malloc((do_points + 1) * sizeof(int));
+    if (init_buckets(ele_min, ele_max))
+	/* heap_index links the points of an elevation bucket */
+	heap_index = (int *)G_malloc(size_array(&alt_seg, nrows, ncols) *
+				     sizeof(int));
+    else
+	/* heap_index will track astar_pts in ternary min-heap */
+	/* heap_index is one-based */
+	heap_index = (int *)G_malloc((do_points + 1) * sizeof(int));
 
     G_message(_("SECTION 1b (of %1d): Determining Offmap Flow."), tot_parts);
 
@@ -311,7 +339,7 @@ int init_vars(int argc, char *argv[])
 	    G_percent(r, nrows, 3);
 	    for (c = 0; c < ncols; c++) {
 		if (FLAG_GET(worked, r, c)) {
-		    wat[SEG_INDEX(wat_seg, r, c)] = 0;
+		    WAT_PUT(SEG_INDEX(wat_seg, r, c), 0);
 		}
 		else {
 		    if (er_flag)
@@ -319,13 +347,13 @@ int init_vars(int argc, char *argv[])
 		    asp_value = asp[SEG_INDEX(asp_seg, r, c)];
 		    if (r == 0 || c == 0 || r == nrows - 1 ||
 			c == ncols - 1 || asp_value != 0) {
-			wat_value = wat[SEG_INDEX(wat_seg, r, c)];
+			wat_value = WAT_GET(SEG_INDEX(wat_seg, r, c));
 			if (wat_value > 0)
-			    wat[SEG_INDEX(wat_seg, r, c)] = -wat_value;
+			    WAT_PUT(SEG_INDEX(wat_seg, r, c), -wat_value);
 			/* set depression */
 			if (asp_value) {
 			    asp_value = 0;
-			    wat[SEG_INDEX(wat_seg, r, c)] = ABS(wat_value);
+			    WAT_PUT(SEG_INDEX(wat_seg, r, c), ABS(wat_value));
 			}
 			else if (r == 0)
 			    asp_value = -2;
@@ -343,65 +371,65 @@ int init_vars(int argc, char *argv[])
 			alt_value = alt[SEG_INDEX(alt_seg, r, c)];
 			add_pt(r, c, alt_value, alt_value);
 			asp[SEG_INDEX(asp_seg, r, c)] = -2;
-			wat_value = wat[SEG_INDEX(wat_seg, r, c)];
+			wat_value = WAT_GET(SEG_INDEX(wat_seg, r, c));
 			if (wat_value > 0)
-			    wat[SEG_INDEX(wat_seg, r, c)] = -wat_value;
+			    WAT_PUT(SEG_INDEX(wat_seg, r, c), -wat_value);
 		    }
 		    else if (FLAG_GET(worked, r + 1, c)) {
 			alt_value = alt[SEG_INDEX(alt_seg, r, c)];
 			add_pt(r, c, alt_value, alt_value);
 			asp[SEG_INDEX(asp_seg, r, c)] = -6;
-			wat_value = wat[SEG_INDEX(wat_seg, r, c)];
+			wat_value = WAT_GET(SEG_INDEX(wat_seg, r, c));
 			if (wat_value > 0)
-			    wat[SEG_INDEX(wat_seg, r, c)] = -wat_value;
+			    WAT_PUT(SEG_INDEX(wat_seg, r, c), -wat_value);
 		    }
 		    else if (FLAG_GET(worked, r, c - 1)) {
 			alt_value = alt[SEG_INDEX(alt_seg, r, c)];
 			add_pt(r, c, alt_value, alt_value);
 			asp[SEG_INDEX(asp_seg, r, c)] = -4;
-			wat_value = wat[SEG_INDEX(wat_seg, r, c)];
+			wat_value = WAT_GET(SEG_INDEX(wat_seg, r, c));
 			if (wat_value > 0)
-			    wat[SEG_INDEX(wat_seg, r, c)] = -wat_value;
+			    WAT_PUT(SEG_INDEX(wat_seg, r, c), -wat_value);
 		    }
 		    else if (FLAG_GET(worked, r, c + 1)) {
 			alt_value = alt[SEG_INDEX(alt_seg, r, c)];
 			add_pt(r, c, alt_value, alt_value);
 			asp[SEG_INDEX(asp_seg, r, c)] = -8;
-			wat_value = wat[SEG_INDEX(wat_seg, r, c)];
+			wat_value = WAT_GET(SEG_INDEX(wat_seg, r, c));
 			if (wat_value > 0)
-			    wat[SEG_INDEX(wat_seg, r, c)] = -wat_value;
+			    WAT_PUT(SEG_INDEX(wat_seg, r, c), -wat_value);
 		    }
 		    else if (sides == 8 && FLAG_GET(worked, r - 1, c - 1)) {
 			alt_value = alt[SEG_INDEX(alt_seg, r, c)];
 			add_pt(r, c, alt_value, alt_value);
 			asp[SEG_INDEX(asp_seg, r, c)] = -3;
-			wat_value = wat[SEG_INDEX(wat_seg, r, c)];
+			wat_value = WAT_GET(SEG_INDEX(wat_seg, r, c));
 			if (wat_value > 0)
-			    wat[SEG_INDEX(wat_seg, r, c)] = -wat_value;
+			    WAT_PUT(SEG_INDEX(wat_seg, r, c), -wat_value);
 		    }
 		    else if (sides == 8 && FLAG_GET(worked, r - 1, c + 1)) {
 			alt_value = alt[SEG_INDEX(alt_seg, r, c)];
 			add_pt(r, c, alt_value, alt_value);
 			asp[SEG_INDEX(asp_seg, r, c)] = -1;
-			wat_value = wat[SEG_INDEX(wat_seg, r, c)];
+			wat_value = WAT_GET(SEG_INDEX(wat_seg, r, c));
 			if (wat_value > 0)
-			    wat[SEG_INDEX(wat_seg, r, c)] = -wat_value;
+			    WAT_PUT(SEG_INDEX(wat_seg, r, c), -wat_value);
 		    }
 		    else if (sides == 8 && FLAG_GET(worked, r + 1, c - 1)) {
 			alt_value = alt[SEG_INDEX(alt_seg, r, c)];
 			add_pt(r, c, alt_value, alt_value);
 			asp[SEG_INDEX(asp_seg, r, c)] = -5;
-			wat_value = wat[SEG_INDEX(wat_seg, r, c)];
+			wat_value = WAT_GET(SEG_INDEX(wat_seg, r, c));
 			if (wat_value > 0)
-			    wat[SEG_INDEX(wat_seg, r, c)] = -wat_value;
+			    WAT_PUT(SEG_INDEX(wat_seg, r, c), -wat_value);
 		    }
 		    else if (sides == 8 && FLAG_GET(worked, r + 1, c + 1)) {
 			alt_value = alt[SEG_INDEX(alt_seg, r, c)];
 			add_pt(r, c, alt_value, alt_value);
 			asp[SEG_INDEX(asp_seg, r, c)] = -7;
-			wat_value = wat[SEG_INDEX(wat_seg, r, c)];
+			wat_value = WAT_GET(SEG_INDEX(wat_seg, r, c));
 			if (wat_value > 0)
-			    wat[SEG_INDEX(wat_seg, r, c)] = -wat_value;
+			    WAT_PUT(SEG_INDEX(wat_seg, r, c), -wat_value);
 		    }
 		}
 	    }
@@ -416,14 +444,14 @@ int init_vars(int argc, char *argv[])
 		asp_value = asp[SEG_INDEX(asp_seg, r, c)];
 		if (r == 0 || c == 0 || r == nrows - 1 ||
 		    c == ncols - 1 || asp_value != 0) {
-		    wat_value = wat[SEG_INDEX(wat_seg, r, c)];
+		    wat_value = WAT_GET(SEG_INDEX(wat_seg, r, c));
 		    if (wat_value > 0) {
-			wat[SEG_INDEX(wat_seg, r, c)] = -wat_value;
+			WAT_PUT(SEG_INDEX(wat_seg, r, c), -wat_value);
 		    }
 		    /* set depression */
 		    if (asp_value) {
 			asp_value = 0;
-			wat[SEG_INDEX(wat_seg, r, c)] = ABS(wat_value);
+			WAT_PUT(SEG_INDEX(wat_seg, r, c), ABS(wat_value));
 		    }
 		    else if (r == 0)
 			asp_value = -2;
@@ -35,8 +35,10 @@ RAMSEG dis_seg, alt_seg, wat_seg, asp_seg, bas_seg, haf_seg;
 RAMSEG r_h_seg, dep_seg;
 RAMSEG slp_seg, s_l_seg, s_g_seg, l_s_seg;
 int *astar_pts;
-CELL *dis, *alt, *asp, *bas, *haf, *r_h, *dep;
+CELL *dis, *alt, *bas, *haf, *r_h, *dep;
+signed char *asp;
 DCELL *wat;
+int *wat_int;
 int ril_fd;
 double *s_l, *s_g, *l_s;
 CELL one, zero;
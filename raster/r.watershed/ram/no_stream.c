@@ -17,7 +17,7 @@ int no_stream(int row, int col, CELL basin_num,
 		if (r >= 0 && c >= 0 && r < nrows && c < ncols) {
 		    aspect = asp[SEG_INDEX(asp_seg, r, c)];
 		    if (aspect == drain[rr][cc]) {
-			dvalue = wat[SEG_INDEX(wat_seg, r, c)];
+			dvalue = WAT_GET(SEG_INDEX(wat_seg, r, c));
 			if (dvalue < 0)
 			    dvalue = -dvalue;
 			if ((dvalue - max_drain) > 5E-8f) {	/* floating point comparison problem workaround */
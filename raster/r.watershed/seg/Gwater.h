@@ -86,9 +86,10 @@ int close_array_seg(void);
 CELL def_basin(int, int, CELL, double, CELL);
 
 /* do_astar.c */
+int init_buckets(CELL, CELL, double);
 int do_astar(void);
 int add_pt(SHORT, SHORT, CELL, CELL);
-int drop_pt(void);
+int drop_pt(CELL *);
 int sift_up(int, CELL);
 double get_slope(SHORT, SHORT, SHORT, SHORT, CELL, CELL);
 int replace(SHORT, SHORT, SHORT, SHORT);
@@ -41,7 +41,7 @@ int bseg_open(BSEG * bseg, int srows, int scols, int nsegs_in_memory)
 	G_warning("bseg_open(): unable to re-open segment file");
 	return -4;
     }
-    if (0 > (errflag = segment_init(&(bseg->seg), fd, nsegs_in_memory))) {
+    if (0 > (errflag = segment_init_mmap(&(bseg->seg), fd, nsegs_in_memory))) {
 	close(fd);
 	unlink(filename);
 	if (errflag == -1) {
@@ -7,6 +7,98 @@
 
 double get_slope2(CELL, CELL, double);
 
+/*
+   priority-flood: when the range of the elevations (integer, or
+   scaled to integer for FP maps) is moderate, the search list is a
+   bucket queue with one FIFO per elevation instead of the heap.
+   points of equal elevation come out in the order they were added,
+   just as with the heap, so that the results do not change, but
+   adding and dropping a point takes constant time and heap_index is
+   not needed. the points of a bucket are linked through their nxt
+   field in astar_pts, the heads and tails of the buckets and a
+   bitmap of the non-empty buckets are kept in memory.
+ */
+
+static int use_buckets;
+static CELL bucket_min;
+static int num_buckets, lowest;
+static int *bucket_head, *bucket_tail;
+static unsigned int *bucket_bits;
+
+/* the heads, tails and bits of the buckets must fit into max_mem bytes */
+int init_buckets(CELL ele_min, CELL ele_max, double max_mem)
+{
+    double range = (double)ele_max - ele_min + 1;
+    int num_words;
+
+    if (ele_min > ele_max || range > MAX_BUCKETS ||
+	range > (double)do_points + MIN_BUCKETS ||
+	range * (2 * sizeof(int) + 0.125) > max_mem)
+	return 0;
+
+    use_buckets = 1;
+    bucket_min = ele_min;
+    num_buckets = ele_max - ele_min + 1;
+    lowest = num_buckets;
+    num_words = (num_buckets + 31) / 32;
+
+    bucket_head = (int *)G_malloc(num_buckets * sizeof(int));
+    bucket_tail = (int *)G_malloc(num_buckets * sizeof(int));
+    bucket_bits = (unsigned int *)G_calloc(num_words, sizeof(unsigned int));
+
+    G_debug(1, "A* Search: %d elevation buckets", num_buckets);
+
+    return 1;
+}
+
+/* point has been put to astar_pts with nxt = -1 */
+static void add_bucket(int point, CELL ele)
+{
+    POINT tail;
+    int b = ele - bucket_min;
+
+    if (bucket_bits[b >> 5] & (1U << (b & 31))) {
+	seg_get(&astar_pts, (char *)&tail, 0, bucket_tail[b]);
+	tail.nxt = point;
+	seg_put(&astar_pts, (char *)&tail, 0, bucket_tail[b]);
+    }
+    else {
+	bucket_bits[b >> 5] |= 1U << (b & 31);
+	bucket_head[b] = point;
+    }
+    bucket_tail[b] = point;
+
+    if (b < lowest)
+	lowest = b;
+}
+
+/* the list must not be empty */
+static int drop_bucket(CELL * ele)
+{
+    int w = lowest >> 5;
+    unsigned int bits = bucket_bits[w] & (~0U << (lowest & 31));
+    int b, point;
+    POINT head;
+
+    while (!bits)
+	bits = bucket_bits[++w];
+
+    for (b = w << 5; !(bits & 1); b++)
+	bits >>= 1;
+    lowest = b;
+
+    point = bucket_head[b];
+    seg_get(&astar_pts, (char *)&head, 0, point);
+    bucket_head[b] = head.nxt;
+    if (bucket_head[b] < 0)
+	bucket_bits[w] &= ~(1U << (b & 31));
+
+    heap_size--;
+    *ele = bucket_min + b;
+
+    return point;
+}
+
 int do_astar(void)
 {
     POINT point;
@@ -15,7 +107,6 @@ int do_astar(void)
     CELL work_val, alt_val, alt_nbr[8], alt_up, asp_up;
     DCELL wat_val;
     CELL in_val, drain_val;
-    HEAP heap_pos;
     /* sides
      * |7|1|4|
      * |2| |3|
@@ -45,25 +136,15 @@ int do_astar(void)
     ns_res = window.ns_res;
 
     count = 0;
-    seg_get(&heap_index, (char *)&heap_pos, 0, 1);
-    first_astar = heap_pos.point;
 
     /* A * Search: downhill path through all not masked cells */
-    while (first_astar != -1) {
+    while (heap_size > 0) {
 	G_percent(count++, do_points, 1);
 
-	seg_get(&heap_index, (char *)&heap_pos, 0, 1);
-	doer = heap_pos.point;
-
-	seg_get(&astar_pts, (char *)&point, 0, doer);
-
-	alt_val = heap_pos.ele;
-
 	/* drop astar_pts[doer] from heap */
-	drop_pt();
+	doer = drop_pt(&alt_val);
 
-	seg_get(&heap_index, (char *)&heap_pos, 0, 1);
-	first_astar = heap_pos.point;
+	seg_get(&astar_pts, (char *)&point, 0, doer);
 
 	point.nxt = first_cum;
 	seg_put(&astar_pts, (char *)&point, 0, doer);
@@ -139,7 +220,13 @@ int do_astar(void)
 	bseg_close(&worked);
 
     bseg_close(&in_list);
-    seg_close(&heap_index);
+    if (use_buckets) {
+	G_free(bucket_head);
+	G_free(bucket_tail);
+	G_free(bucket_bits);
+    }
+    else
+	seg_close(&heap_index);
 
     G_percent(count, do_points, 1);	/* finish it */
     return 0;
@@ -160,6 +247,17 @@ int add_pt(SHORT r, SHORT c, CELL ele, CELL downe)
     if (heap_size > do_points)
 	G_fatal_error(_("heapsize too large"));
 
+    if (use_buckets) {
+	point.r = r;
+	point.c = c;
+	point.nxt = -1;
+	seg_put(&astar_pts, (char *)&point, 0, nxt_avail_pt);
+	add_bucket(nxt_avail_pt, ele);
+	nxt_avail_pt++;
+
+	return 0;
+    }
+
     heap_pos.point = nxt_avail_pt;
     heap_pos.ele = ele;
     seg_put(&heap_index, (char *)&heap_pos, 0, heap_size);
@@ -181,13 +279,22 @@ int add_pt(SHORT r, SHORT c, CELL ele, CELL downe)
 }
 
 /* drop point routine for min heap */
-int drop_pt(void)
+/* returns the point dropped and sets its elevation */
+int drop_pt(CELL * drop_ele)
 {
     int child, childr, parent;
     int childp;
     CELL ele;
     int i;
     HEAP heap_pos;
+    int point;
+
+    if (use_buckets)
+	return drop_bucket(drop_ele);
+
+    seg_get(&heap_index, (char *)&heap_pos, 0, 1);
+    point = heap_pos.point;
+    *drop_ele = heap_pos.ele;
 
     if (heap_size == 1) {
 	parent = -1;
@@ -195,7 +302,7 @@ int drop_pt(void)
 	heap_pos.ele = 0;
 	seg_put(&heap_index, (char *)&heap_pos, 0, 1);
 	heap_size = 0;
-	return 0;
+	return point;
     }
 
     /* start with heap root */
@@ -251,7 +358,7 @@ int drop_pt(void)
     /* the actual drop */
     heap_size--;
 
-    return 0;
+    return point;
 
 }
 
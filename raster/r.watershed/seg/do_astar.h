@@ -4,4 +4,9 @@
 #define GET_PARENT(c) ((int) (((c) - 2) / 3 + 1))
 #define GET_CHILD(p) ((int) ((p) * 3 - 1))
 
+/* elevation buckets used even for few points */
+#define MIN_BUCKETS 65536
+/* most elevation buckets kept in memory, see also init_buckets() */
+#define MAX_BUCKETS (1 << 24)
+
 #endif /* __DO_ASTAR_H__ */
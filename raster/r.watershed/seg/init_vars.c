@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <unistd.h>
 #include "Gwater.h"
 #include <grass/gis.h>
@@ -17,6 +18,7 @@ int init_vars(int argc, char *argv[])
     /* int page_block, num_cseg; */
     int max_bytes;
     CELL *buf, alt_value, asp_value, worked_value, block_value;
+    CELL ele_min, ele_max;
     DCELL wat_value;
     DCELL dvalue;
     char MASK_flag;
@@ -201,6 +203,8 @@ int init_vars(int argc, char *argv[])
     /* read elevation input and mark NULL/masked cells */
     MASK_flag = 0;
     do_points = nrows * ncols;
+    ele_min = INT_MAX;
+    ele_max = -INT_MAX;
     for (r = 0; r < nrows; r++) {
 	G_get_raster_row(fd, elebuf, r, ele_map_type);
 	ptr = elebuf;
@@ -227,6 +231,10 @@ int init_vars(int argc, char *argv[])
 		    dvalue *= ele_scale;
 		    alt_value = ele_round(dvalue);
 		}
+		if (ele_min > alt_value)
+		    ele_min = alt_value;
+		if (ele_max < alt_value)
+		    ele_max = alt_value;
 	    }
 	    cseg_put(&alt, &alt_value, r, c);
 	    if (er_flag) {
@@ -355,13 +363,18 @@ int init_vars(int argc, char *argv[])
 
     /* heap_index will track astar_pts in ternary min-heap */
     /* heap_index is one-based */
-    if (seg_cols * num_open_segs * seg_rows / 10 > 0)
-	n_array_segs = seg_cols * num_open_segs * seg_rows / 10;
-    else
-	n_array_segs = 1;
+    /* not needed if the elevations fit into buckets, which may take
+       the share of memory= that heap_index would have had */
+    if (!init_buckets(ele_min, ele_max, segs_mb / 1.34 * seg_rows *
+		      seg_cols * sizeof(HEAP))) {
+	if (seg_cols * num_open_segs * seg_rows / 10 > 0)
+	    n_array_segs = seg_cols * num_open_segs * seg_rows / 10;
+	else
+	    n_array_segs = 1;
 
-    seg_open(&heap_index, 1, do_points + 1, 1, n_array_segs,
-	     10, sizeof(HEAP));
+	seg_open(&heap_index, 1, do_points + 1, 1, n_array_segs,
+		 10, sizeof(HEAP));
+    }
 
     G_message(_("SECTION 1b (of %1d): Determining Offmap Flow."), tot_parts);
 
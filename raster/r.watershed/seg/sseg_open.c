@@ -39,7 +39,7 @@ seg_open(SSEG * sseg, int nrows, int ncols, int row_in_seg, int col_in_seg,
 	G_warning("seg_open(): unable to re-open segment file");
 	return -4;
     }
-    if (0 > (errflag = segment_init(&(sseg->seg), fd, nsegs_in_memory))) {
+    if (0 > (errflag = segment_init_mmap(&(sseg->seg), fd, nsegs_in_memory))) {
 	close(fd);
 	unlink(filename);
 	if (errflag == -1) {